@@ -7,10 +7,8 @@ layout(std140) uniform ViewData {
     vec4 u_ViewPositionWorld;
 };
 
-uniform mat4 u_ModelViewPerspective;
-uniform mat4 u_ModelView;
-uniform mat4 u_Model;
-uniform mat4 u_NormalMatrix;
+#include "include/Entities.glsl"
+#include "include/VertexDecoding.glsl"
 
 layout(location = 0) in vec3 a_Position;
 layout(location = 1) in vec3 a_Normal;
@@ -24,14 +22,20 @@ out vec3 normalModel;
 out vec3 preNormalWorld;
 out vec2 uv;
 out vec4 color;
+flat out int entityIndex;
 
 void main() {
-    positionWorld = vec3(u_Model * vec4(a_Position, 1.0));
-    positionView = vec3(u_ModelView * vec4(a_Position, 1.0));
-    positionFrag = u_ModelViewPerspective * vec4(a_Position, 1.0);
+    vec3 position = DecodePosition(a_Position);
+    vec3 normal = DecodeNormal(a_Normal);
 
-    normalModel = a_Normal;
-    preNormalWorld = mat3(transpose(inverse(u_Model))) * a_Normal; // not normalized yet
+    entityIndex = int(instanceSlots[gl_BaseInstance + gl_InstanceID]);
+    mat4 model = entities[entityIndex].model;
+    positionWorld = vec3(model * vec4(position, 1.0));
+    positionView = vec3(u_View * vec4(positionWorld, 1.0));
+    positionFrag = u_Projection * vec4(positionView, 1.0);
+
+    normalModel = normal;
+    preNormalWorld = mat3(entities[entityIndex].normalMatrix) * normal; // not normalized yet
 
     uv = a_TexCoord;
     color = a_Color;
@@ -49,40 +53,9 @@ layout(std140) uniform ViewData {
     vec4 u_ViewPositionWorld;
 };
 
-#define MAX_LIGHTS 10
-struct PointLight {
-    vec4 attenuation; // vec3
-    vec4 position; // vec3
-};
-struct DirectionalLight {
-    vec4 direction; // vec3
-};
-struct Light {
-    vec4 color;
-    PointLight pointParams;
-    DirectionalLight directionalParams;
-    float intensity;
-    int type;
-};
-layout(std140) uniform Lights {
-    Light lights[MAX_LIGHTS];
-    vec4 ambientLight;
-    int numLights;
-};
-
-struct Material {
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    float shininess;
-    float alpha;
-};
+#include "include/Lighting.glsl"
+#include "include/Entities.glsl"
 
-uniform int u_RenderType = 1; // { SolidColor, Normal, UV, Depth }
-uniform vec4 u_SolidColor = vec4(1.0, 1.0, 1.0, 1.0);
-uniform float u_DepthMax = 5.0;
-uniform float u_DepthPow = 2.0;
-uniform Material u_Material;
 uniform vec3 u_SkyColor = vec3(0.0, 0.0, 1.0);
 uniform vec3 u_GroundColor = vec3(0.0, 1.0, 0.0);
 
@@ -93,14 +66,17 @@ in vec3 normalModel;
 in vec3 preNormalWorld;
 in vec2 uv;
 in vec4 color;
+flat in int entityIndex;
 
 layout (location = 0) out vec4 outColor;
+layout (location = 1) out int outEntityID; // for framebuffers with an integer second attachment, ignored otherwise
 
 void main() {
+    outEntityID = entities[entityIndex].entityID;
     vec3 normal = normalize(preNormalWorld);
-    switch (u_RenderType) {
+    switch (entities[entityIndex].visualization) { // { SolidColor, Normal, UV, Depth, ... }
     case 0: // Solid Color
-        outColor = u_SolidColor;
+        outColor = entities[entityIndex].solidColor;
         break;
     case 1: // Normal
         outColor = vec4(normalModel * 0.5 + 0.5, 1.0);
@@ -109,7 +85,7 @@ void main() {
         outColor = vec4(uv.x, uv.y, 0.0, 1.0);
         break;
     case 3: // Depth
-        outColor = vec4(vec3(1.0) - pow(positionFrag.z / u_DepthMax, u_DepthPow), 1.0);
+        outColor = vec4(vec3(1.0) - pow(positionFrag.z / entities[entityIndex].depthMax, entities[entityIndex].depthPow), 1.0);
         break;
     case 4: // Vertex Color
         outColor = color;
@@ -125,36 +101,17 @@ void main() {
     case 7: // Lit
         vec3 diffuseLight = vec3(0.0f);
         vec3 specularLight = vec3(0.0f);
-        for (int i = 0; i < numLights; i++) {
-            vec3 lightDir;
-            Light light = lights[i];
-            switch (light.type) {
-                case 0: { // PointLight
-                    vec3 relLightPos = light.pointParams.position.xyz - positionWorld;
-                    float lightDist = length(relLightPos);
-                    lightDir = relLightPos / lightDist; // normalize
-                    vec3 att = light.pointParams.attenuation.xyz;
-                    float attFactor = 1.0 / (att.x + att.y * lightDist + att.z * lightDist * lightDist);
-                    float diffuseVal = max(0.0, dot(normal, lightDir));
-                    diffuseLight += light.intensity * light.color.rgb * diffuseVal * attFactor;
-                }
-                break;
-                case 1: { // DirectionalLight
-                    lightDir = -normalize(light.directionalParams.direction.xyz);
-                    float diffuseVal = max(0.0, dot(normal, lightDir));
-                    diffuseLight += light.intensity * light.color.rgb * diffuseVal;
-                }
-                break;
-            }
-
-            // specular
-            vec3 viewDir = normalize(u_ViewPositionWorld.xyz - positionWorld);
-            vec3 reflectDir = reflect(-lightDir, normal);  
-            float specularVal = pow(max(dot(viewDir, reflectDir), 0.0), u_Material.shininess);
-            specularLight += light.intensity * light.color.rgb * specularVal;  
+        float shininess = entities[entityIndex].shininess;
+        for (int i = 0; i < clusterGrid.w; i++) {
+            AddLight(lights[i], positionWorld, normal, shininess, diffuseLight, specularLight);
+        }
+        uvec2 range = clusterRanges[GetCluster(positionView)];
+        for (uint i = range.x; i < range.x + range.y; i++) {
+            AddLight(lights[lightIndices[i]], positionWorld, normal, shininess, diffuseLight, specularLight);
         }
-        vec3 rgb = ambientLight.rgb * u_Material.ambient + diffuseLight * u_Material.diffuse + specularLight * u_Material.specular;
-        outColor = vec4(rgb, u_Material.alpha);
+        EntityData entity = entities[entityIndex];
+        vec3 rgb = ambientLight.rgb * entity.ambientColor.rgb + diffuseLight * entity.diffuseColor.rgb + specularLight * entity.specularColor.rgb;
+        outColor = vec4(rgb, entity.alpha);
         break;
     case 8: // Hemispherical Light
         float costheta = dot(normal, vec3(0.0, 1.0, 0.0));
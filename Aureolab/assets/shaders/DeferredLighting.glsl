@@ -0,0 +1,110 @@
+#type vertex
+#version 460 core
+
+// A triangle covering the viewport, see DeferredShading::Light
+void main() {
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+
+
+#type fragment
+#version 460 core
+
+layout(std140) uniform ViewData {
+	mat4 u_View;
+	mat4 u_Projection;
+    vec4 u_ViewPositionWorld;
+};
+
+#include "include/Lighting.glsl"
+#include "include/Entities.glsl"
+
+// Attachments of the G-buffer, see DeferredShading::GBufferAttachment
+layout(binding = 0) uniform sampler2D u_Albedo;
+layout(binding = 1) uniform sampler2D u_Specular;
+layout(binding = 2) uniform sampler2D u_NormalUV;
+layout(binding = 3) uniform isampler2D u_Slots;
+layout(binding = 4) uniform sampler2D u_Depth;
+
+uniform mat4 u_InverseView;
+uniform mat4 u_InverseProjection;
+uniform int u_GBufferView = 0; // see DeferredShading::View
+uniform float u_MaxShininess = 256.0; // DeferredShading::maxShininess
+uniform vec3 u_SkyColor = vec3(0.0, 0.0, 1.0);
+uniform vec3 u_GroundColor = vec3(0.0, 1.0, 0.0);
+
+layout (location = 0) out vec4 outColor;
+layout (location = 1) out int outEntityID;
+
+#include "include/Octahedral.glsl"
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    int slot = texelFetch(u_Slots, texel, 0).r;
+    if (slot < 0) { discard; } // background
+    EntityData entity = entities[slot];
+    outEntityID = entity.entityID;
+
+    // Position from depth, back through the projection
+    float depth = texelFetch(u_Depth, texel, 0).r;
+    vec4 positionNdc = vec4(gl_FragCoord.xy / vec2(textureSize(u_Depth, 0)) * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 position = u_InverseProjection * positionNdc;
+    vec3 positionView = position.xyz / position.w;
+    vec3 positionWorld = vec3(u_InverseView * vec4(positionView, 1.0));
+    vec4 normalUV = texelFetch(u_NormalUV, texel, 0);
+    vec3 normal = DecodeOctahedral(normalUV.xy);
+    vec3 albedo = texelFetch(u_Albedo, texel, 0).rgb;
+    vec4 specular = texelFetch(u_Specular, texel, 0);
+
+    // The Normal, UV and Depth visualizations of entities are views of the G-buffer
+    int view = u_GBufferView;
+    if (view == 0) {
+        switch (entity.visualization) { // { SolidColor, Normal, UV, Depth, ... }
+        case 1: view = 2; break;
+        case 2: view = 4; break;
+        case 3: view = 3; break;
+        }
+    }
+    switch (view) { // { Lit, Albedo, Normal, Depth, UV, Specular }
+    case 0: // Lit
+        if (entity.visualization == 7) { // Lit
+            vec3 diffuseLight = vec3(0.0f);
+            vec3 specularLight = vec3(0.0f);
+            float shininess = specular.a * specular.a * u_MaxShininess;
+            for (int i = 0; i < clusterGrid.w; i++) {
+                AddLight(lights[i], positionWorld, normal, shininess, diffuseLight, specularLight);
+            }
+            uvec2 range = clusterRanges[GetCluster(positionView)];
+            for (uint i = range.x; i < range.x + range.y; i++) {
+                AddLight(lights[lightIndices[i]], positionWorld, normal, shininess, diffuseLight, specularLight);
+            }
+            outColor = vec4(ambientLight.rgb * entity.ambientColor.rgb + diffuseLight * albedo + specularLight * specular.rgb, 1.0);
+        }
+        else if (entity.visualization == 8) { // Hemispherical Light
+            float costheta = dot(normal, vec3(0.0, 1.0, 0.0));
+            float a = costheta * 0.5 + 0.5;
+            outColor = vec4(mix(u_GroundColor, u_SkyColor, a), 1.0);
+        }
+        else { // colored without light
+            outColor = vec4(albedo, 1.0);
+        }
+        break;
+    case 1: // Albedo
+        outColor = vec4(albedo, 1.0);
+        break;
+    case 2: // Normal
+        outColor = vec4(normal * 0.5 + 0.5, 1.0);
+        break;
+    case 3: // Depth
+        float positionFragZ = (u_Projection * vec4(positionView, 1.0)).z;
+        outColor = vec4(vec3(1.0) - pow(positionFragZ / entity.depthMax, entity.depthPow), 1.0);
+        break;
+    case 4: // UV
+        outColor = vec4(normalUV.z, normalUV.w, 0.0, 1.0);
+        break;
+    case 5: // Specular
+        outColor = vec4(specular.rgb, 1.0);
+        break;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#type compute
+#version 460 core
+
+// Reduces a depth buffer to the farthest depth of each tile of u_TileSize x u_TileSize texels, the base of the pyramid of OcclusionCuller
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D u_Depth;
+layout(r32f, binding = 0) writeonly uniform image2D u_Tiles;
+uniform int u_TileSize = 8;
+
+void main() {
+    ivec2 tile = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 numTiles = imageSize(u_Tiles);
+    if (tile.x >= numTiles.x || tile.y >= numTiles.y) {
+        return;
+    }
+    ivec2 lastTexel = textureSize(u_Depth, 0) - 1;
+    float farthest = 0.0;
+    for (int y = 0; y < u_TileSize; y++) {
+        for (int x = 0; x < u_TileSize; x++) {
+            ivec2 texel = min(tile * u_TileSize + ivec2(x, y), lastTexel);
+            farthest = max(farthest, texelFetch(u_Depth, texel, 0).r);
+        }
+    }
+    imageStore(u_Tiles, tile, vec4(farthest));
+}
\ No newline at end of file
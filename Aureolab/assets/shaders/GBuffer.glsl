@@ -0,0 +1,97 @@
+#type vertex
+#version 460 core
+
+layout(std140) uniform ViewData {
+	mat4 u_View;
+	mat4 u_Projection;
+    vec4 u_ViewPositionWorld;
+};
+
+#include "include/Entities.glsl"
+#include "include/VertexDecoding.glsl"
+
+layout(location = 0) in vec3 a_Position;
+layout(location = 1) in vec3 a_Normal;
+layout(location = 2) in vec2 a_TexCoord;
+layout(location = 3) in vec4 a_Color;
+
+out vec3 positionView;
+out vec3 positionWorld;
+out vec4 positionFrag;
+out vec3 normalModel;
+out vec3 preNormalWorld;
+out vec2 uv;
+out vec4 color;
+flat out int entityIndex;
+
+void main() {
+    vec3 position = DecodePosition(a_Position);
+    vec3 normal = DecodeNormal(a_Normal);
+
+    entityIndex = int(instanceSlots[gl_BaseInstance + gl_InstanceID]);
+    mat4 model = entities[entityIndex].model;
+    positionWorld = vec3(model * vec4(position, 1.0));
+    positionView = vec3(u_View * vec4(positionWorld, 1.0));
+    positionFrag = u_Projection * vec4(positionView, 1.0);
+
+    normalModel = normal;
+    preNormalWorld = mat3(entities[entityIndex].normalMatrix) * normal; // not normalized yet
+
+    uv = a_TexCoord;
+    color = a_Color;
+
+    gl_Position = positionFrag;
+}
+
+
+#type fragment
+#version 460 core
+
+#include "include/Entities.glsl"
+
+uniform float u_MaxShininess = 256.0; // DeferredShading::maxShininess
+
+in vec3 positionWorld;
+in vec3 positionView;
+in vec4 positionFrag;
+in vec3 normalModel;
+in vec3 preNormalWorld;
+in vec2 uv;
+in vec4 color;
+flat in int entityIndex;
+
+// Attachments of the G-buffer, see DeferredShading::GBufferAttachment
+layout (location = 0) out vec4 outAlbedo;
+layout (location = 1) out vec4 outSpecular;
+layout (location = 2) out vec4 outNormalUV;
+layout (location = 3) out int outSlot;
+
+#include "include/Octahedral.glsl"
+
+void main() {
+    EntityData entity = entities[entityIndex];
+    outSlot = entityIndex;
+    outNormalUV = vec4(EncodeOctahedral(normalize(preNormalWorld)), uv);
+    outSpecular = vec4(entity.specularColor.rgb, sqrt(clamp(entity.shininess / u_MaxShininess, 0.0, 1.0)));
+    // Visualizations that color the surface without light write their color as albedo, the lighting pass shows it as it is.
+    // Normal, UV and Depth are views of the G-buffer there.
+    switch (entity.visualization) { // { SolidColor, Normal, UV, Depth, ... }
+    case 0: // Solid Color
+        outAlbedo = vec4(entity.solidColor.rgb, 1.0);
+        break;
+    case 4: // Vertex Color
+        outAlbedo = vec4(color.rgb, 1.0);
+        break;
+    case 5: // Front & Back Faces
+        if (gl_FrontFacing) { outAlbedo = vec4(1.0, 0.0, 0.0, 1.0); }
+        else { outAlbedo = vec4(0.0, 0.0, 1.0, 1.0); }
+        break;
+    case 6: // Checkers
+        vec2 p = uv * 10.0;
+        outAlbedo = vec4(vec3(int(p.x) % 2 ^ int(p.y) % 2), 1.0); // bitwise XOR for checkers pattern
+        break;
+    default:
+        outAlbedo = vec4(entity.diffuseColor.rgb, 1.0);
+        break;
+    }
+}
\ No newline at end of file
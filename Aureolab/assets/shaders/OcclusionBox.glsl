@@ -0,0 +1,31 @@
+#type vertex
+#version 460 core
+
+// Bounding box of an entity re-tested by OcclusionCuller::DrawRevealed, its 36 vertices made from gl_VertexID
+uniform mat4 u_ViewProjection;
+uniform vec3 u_BoxCenter;
+uniform vec3 u_BoxExtent;
+
+// Corners of the 12 triangles, bits 0, 1 and 2 set for the + side in x, y and z. Faces are not culled, so winding does not matter.
+const int corners[36] = int[36](
+    0, 4, 6, 0, 6, 2, // -x
+    1, 3, 7, 1, 7, 5, // +x
+    0, 1, 5, 0, 5, 4, // -y
+    2, 6, 7, 2, 7, 3, // +y
+    0, 2, 3, 0, 3, 1, // -z
+    4, 5, 7, 4, 7, 6  // +z
+);
+
+void main() {
+    int corner = corners[gl_VertexID];
+    vec3 side = vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1) * 2.0 - 1.0;
+    gl_Position = u_ViewProjection * vec4(u_BoxCenter + u_BoxExtent * side, 1.0);
+}
+
+
+#type fragment
+#version 460 core
+
+// Only whether samples pass the depth test counts, color and depth are not written
+void main() {
+}
\ No newline at end of file
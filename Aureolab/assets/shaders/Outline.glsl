@@ -4,11 +4,23 @@
 layout(location = 0) in vec3 a_Position;
 layout(location = 1) in vec3 a_Normal;
 
-uniform mat4 u_ModelViewPerspective;
+layout(std140) uniform ViewData {
+	mat4 u_View;
+	mat4 u_Projection;
+    vec4 u_ViewPositionWorld;
+};
+
+#include "include/Entities.glsl"
+
 uniform float u_OutlineThickness = 0.02;
 
+#include "include/VertexDecoding.glsl"
+
 void main() {
-    gl_Position = u_ModelViewPerspective * vec4(a_Position + a_Normal * u_OutlineThickness, 1.0);
+    vec3 position = DecodePosition(a_Position);
+    uint slot = instanceSlots[gl_BaseInstance + gl_InstanceID];
+    vec3 normal = DecodeNormal(a_Normal);
+    gl_Position = u_Projection * u_View * entities[slot].model * vec4(position + normal * u_OutlineThickness, 1.0);
 }
 
 
@@ -1,12 +1,21 @@
 #type vertex
 #version 460 core
 
-uniform mat4 u_ModelViewPerspective;
+layout(std140) uniform ViewData {
+	mat4 u_View;
+	mat4 u_Projection;
+    vec4 u_ViewPositionWorld;
+};
+
+#include "include/Entities.glsl"
+#include "include/VertexDecoding.glsl"
 
 layout(location = 0) in vec3 a_Position;
 
 void main() {
-    gl_Position = u_ModelViewPerspective * vec4(a_Position, 1.0);
+    vec3 position = DecodePosition(a_Position);
+    uint slot = instanceSlots[gl_BaseInstance + gl_InstanceID];
+    gl_Position = u_Projection * u_View * entities[slot].model * vec4(position, 1.0);
 }
 
 
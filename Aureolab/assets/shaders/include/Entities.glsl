@@ -0,0 +1,22 @@
+// Per-entity data, see EntityData in SceneBuffer.h. Indexed by slot.
+struct EntityData {
+    mat4 model;
+    mat4 normalMatrix;
+    vec4 solidColor;
+    vec4 ambientColor; // vec3
+    vec4 diffuseColor; // vec3
+    vec4 specularColor; // vec3
+    float shininess;
+    float alpha;
+    float depthMax;
+    float depthPow;
+    int visualization;
+    int entityID;
+};
+layout(std430) readonly buffer Entities {
+    EntityData entities[];
+};
+// Slots of the entities drawn by each instance, see SceneBuffer::StageInstances. Index gl_BaseInstance + gl_InstanceID, in vertex stages.
+layout(std430) readonly buffer Instances {
+    uint instanceSlots[];
+};
\ No newline at end of file
@@ -0,0 +1,66 @@
+// Clustered lights of the view, see LightClusters. For fragment stages, after the ViewData block.
+struct PointLight {
+    vec4 attenuation; // vec3
+    vec4 position; // vec3
+};
+struct DirectionalLight {
+    vec4 direction; // vec3
+};
+struct Light {
+    vec4 color;
+    PointLight pointParams;
+    DirectionalLight directionalParams;
+    float intensity;
+    int type;
+};
+// Lights of the view, see LightClusters. The global ones come first and light every fragment, the others only the clusters they reach.
+layout(std430) readonly buffer Lights {
+    vec4 ambientLight;
+    ivec4 clusterGrid; // tiles across, tiles up, depth slices, number of global lights
+    vec4 clusterParams; // near distance, slices / log(far / near), viewport width and height
+    Light lights[];
+};
+// First index in lightIndices and number of lights of each cluster, tile by tile and slice by slice
+layout(std430) readonly buffer LightClusters {
+    uvec2 clusterRanges[];
+};
+layout(std430) readonly buffer LightIndices {
+    uint lightIndices[];
+};
+
+// Adds the diffuse and specular light of a light at the fragment
+void AddLight(Light light, vec3 positionWorld, vec3 normal, float shininess, inout vec3 diffuseLight, inout vec3 specularLight) {
+    vec3 lightDir;
+    float attFactor = 1.0; // of point lights, on both diffuse and specular so that both fade within the range of LightClusters
+    switch (light.type) {
+        case 0: { // PointLight
+            vec3 relLightPos = light.pointParams.position.xyz - positionWorld;
+            float lightDist = length(relLightPos);
+            lightDir = relLightPos / lightDist; // normalize
+            vec3 att = light.pointParams.attenuation.xyz;
+            attFactor = 1.0 / (att.x + att.y * lightDist + att.z * lightDist * lightDist);
+            float diffuseVal = max(0.0, dot(normal, lightDir));
+            diffuseLight += light.intensity * light.color.rgb * diffuseVal * attFactor;
+        }
+        break;
+        case 1: { // DirectionalLight
+            lightDir = -normalize(light.directionalParams.direction.xyz);
+            float diffuseVal = max(0.0, dot(normal, lightDir));
+            diffuseLight += light.intensity * light.color.rgb * diffuseVal;
+        }
+        break;
+    }
+
+    // specular
+    vec3 viewDir = normalize(u_ViewPositionWorld.xyz - positionWorld);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float specularVal = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    specularLight += light.intensity * light.color.rgb * specularVal * attFactor;
+}
+
+// Cluster of the fragment, from its position in the viewport and its distance from the camera plane
+int GetCluster(vec3 positionView) {
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy / clusterParams.zw * vec2(clusterGrid.xy)), ivec2(0), clusterGrid.xy - 1);
+    int slice = clamp(int(log(-positionView.z / clusterParams.x) * clusterParams.y), 0, clusterGrid.z - 1);
+    return (slice * clusterGrid.y + tile.y) * clusterGrid.x + tile.x;
+}
\ No newline at end of file
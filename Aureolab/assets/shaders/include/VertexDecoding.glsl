@@ -0,0 +1,30 @@
+// Decoding of compact vertex formats, see VertexDecoding. Defaults leave BasicVertex attributes unchanged.
+#include "Octahedral.glsl"
+
+uniform vec3 u_PositionOffset = vec3(0.0);
+uniform vec3 u_PositionScale = vec3(1.0);
+uniform bool u_OctahedralNormals = false;
+
+// Draws of multi-draw-indirect calls, see IndirectDraw in GeometryPool.h. A multi-draw sets u_FirstDraw, and each draw reads the position decoding of its mesh here.
+struct IndirectDraw {
+    uint command[8]; // DrawElementsIndirectCommand, padded
+    vec4 positionOffset; // vec3
+    vec4 positionScale; // vec3
+};
+layout(std430) readonly buffer IndirectDraws {
+    IndirectDraw indirectDraws[];
+};
+uniform int u_FirstDraw = -1;
+
+// Vertex stage only, multi-draws decode with the offset and scale of the current draw
+vec3 DecodePosition(vec3 position) {
+    if (u_FirstDraw >= 0) {
+        IndirectDraw draw = indirectDraws[u_FirstDraw + gl_DrawID];
+        return draw.positionOffset.xyz + position * draw.positionScale.xyz;
+    }
+    return u_PositionOffset + position * u_PositionScale;
+}
+
+vec3 DecodeNormal(vec3 normal) {
+    return u_OctahedralNormals ? DecodeOctahedral(normal.xy) : normal;
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "ImGuiHelper.h"
 
 #include "Window.h"
+#include "Renderer/GraphicsAPI.h"
 
 #include <GLFW/glfw3.h>
 #include <imgui_impl_glfw.h>
@@ -46,6 +47,7 @@ void ImGuiHelper::RenderFrame() {
         ImGui::RenderPlatformWindowsDefault();
         glfwMakeContextCurrent(backup_current_context); //  For this specific demo app we could also call glfwMakeContextCurrent(window) directly)
     }
+    GraphicsAPI::Get()->InvalidateState(); // the backend sets GL state directly, not through the cache
 }
 
 void ImGuiHelper::Shutdown() {
@@ -0,0 +1,21 @@
+#include "MappedFile.h"
+#include "Platform/Platform.h"
+#include "Platform/Windows/WindowsMappedFile.h"
+
+#include <cassert>
+
+MappedFile* MappedFile::Open(const std::string& filepath) {
+	WindowsMappedFile* file = nullptr;
+	switch (PlatformUtils::GetPlatform()) {
+	case Platform::WINDOWS:
+		file = new WindowsMappedFile(filepath);
+		break;
+	default:
+		assert(false && "Memory mapped files for this platform has not been implemented yet.");
+	}
+	if (file != nullptr && !file->IsValid()) {
+		delete file;
+		file = nullptr;
+	}
+	return file;
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file mapped into the address space of the process.
+// Pages are loaded by the OS on first access, so opening a large file is cheap.
+class MappedFile {
+public:
+	// Returns nullptr if the file does not exist, is empty or cannot be mapped.
+	static MappedFile* Open(const std::string& filepath); // factory method design pattern
+	virtual ~MappedFile() = default;
+
+	virtual const void* GetData() const = 0;
+	virtual size_t GetSize() const = 0;
+};
\ No newline at end of file
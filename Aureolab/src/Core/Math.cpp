@@ -65,4 +65,23 @@ namespace Math {
 			* rotationMat
 			* glm::scale(glm::mat4(1.0f), scale);
 	}
+	std::array<glm::vec4, 6> ExtractFrustumPlanes(const glm::mat4& projection) {
+		const glm::vec4 row0 = { projection[0][0], projection[1][0], projection[2][0], projection[3][0] };
+		const glm::vec4 row1 = { projection[0][1], projection[1][1], projection[2][1], projection[3][1] };
+		const glm::vec4 row2 = { projection[0][2], projection[1][2], projection[2][2], projection[3][2] };
+		const glm::vec4 row3 = { projection[0][3], projection[1][3], projection[2][3], projection[3][3] };
+		// left, right, bottom, top, near, far
+		std::array<glm::vec4, 6> planes = { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 };
+		for (glm::vec4& plane : planes) {
+			plane /= glm::length(glm::vec3(plane));
+		}
+		return planes;
+	}
+
+	bool IsSphereOutsideFrustum(const std::array<glm::vec4, 6>& planes, const glm::vec3& center, float radius) {
+		for (const glm::vec4& plane : planes) {
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) { return true; }
+		}
+		return false;
+	}
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <glm/glm.hpp>
 
+#include <array>
 #include <numbers>
 
 namespace Math {
@@ -10,4 +11,9 @@ namespace Math {
 
 	bool DecomposeTransform(const glm::mat4& transform, glm::vec3& translation, glm::vec3& rotation, glm::vec3& scale);
 	glm::mat4 ComposeTransform(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale);
+
+	// Planes of the frustum of a projection matrix, in the space the matrix maps from [Gribb and Hartmann 2001]. xyz is the inward unit normal, w the distance.
+	// Passing a model-view-projection matrix gives planes in model space.
+	std::array<glm::vec4, 6> ExtractFrustumPlanes(const glm::mat4& projection);
+	bool IsSphereOutsideFrustum(const std::array<glm::vec4, 6>& planes, const glm::vec3& center, float radius);
 }
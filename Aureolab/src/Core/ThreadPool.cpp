@@ -0,0 +1,75 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <latch>
+#include <memory>
+
+ThreadPool& ThreadPool::GetShared() {
+	static ThreadPool pool;
+	return pool;
+}
+
+ThreadPool::ThreadPool(unsigned int numThreads) {
+	if (numThreads == 0) { numThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1; }
+	for (unsigned int ix = 0; ix < numThreads; ix++) {
+		threads.emplace_back(&ThreadPool::Work, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		isStopping = true;
+		jobs.clear();
+	}
+	hasJobs.notify_all();
+	for (std::thread& thread : threads) { thread.join(); }
+}
+
+void ThreadPool::Submit(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	hasJobs.notify_one();
+}
+
+void ThreadPool::RunInParallel(size_t numTasks, const std::function<void(size_t)>& task) {
+	if (numTasks == 0) { return; }
+	// Tasks are claimed by index. Jobs that start after this thread took the last one find nothing left, and must not touch task then,
+	// so what they read is shared with them instead of living on this stack.
+	struct Run {
+		Run(const std::function<void(size_t)>& task, size_t numTasks) : task(task), numTasks(numTasks), done((std::ptrdiff_t)numTasks) {}
+		const std::function<void(size_t)>& task;
+		const size_t numTasks;
+		std::atomic<size_t> next = 0;
+		std::latch done;
+	};
+	auto run = std::make_shared<Run>(task, numTasks);
+	auto runClaimed = [](Run& run) {
+		for (size_t ix = run.next++; ix < run.numTasks; ix = run.next++) {
+			run.task(ix);
+			run.done.count_down();
+		}
+	};
+	for (size_t ix = 1; ix < std::min(numTasks, threads.size() + 1); ix++) {
+		Submit([run, runClaimed]() { runClaimed(*run); });
+	}
+	runClaimed(*run);
+	run->done.wait();
+}
+
+void ThreadPool::Work() {
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			hasJobs.wait(lock, [this]() { return isStopping || !jobs.empty(); });
+			if (isStopping) { return; }
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+}
\ No newline at end of file
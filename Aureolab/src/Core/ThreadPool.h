@@ -0,0 +1,36 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running submitted jobs in submission order.
+// Systems of the engine share one pool, see GetShared, so that the machine is not oversubscribed by a set of threads per system.
+class ThreadPool {
+public:
+	// Pool of the default size, created on first use
+	static ThreadPool& GetShared();
+
+	// 0 threads means one less than the hardware threads, leaving one for the main thread, but at least one.
+	ThreadPool(unsigned int numThreads = 0);
+	// Waits for running jobs, drops the queued ones.
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void Submit(std::function<void()> job);
+	// Calls task(0) to task(numTasks - 1) on this thread and on the workers, and returns when all are done.
+	// This thread takes every task no worker has started yet, so workers busy with long jobs, e.g. mesh loads, do not hold it up.
+	void RunInParallel(size_t numTasks, const std::function<void(size_t)>& task);
+private:
+	void Work();
+
+	std::vector<std::thread> threads;
+	std::deque<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable hasJobs;
+	bool isStopping = false;
+};
\ No newline at end of file
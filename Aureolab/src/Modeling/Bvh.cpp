@@ -0,0 +1,296 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <numeric>
+#include <utility>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#define AL_SSE
+#endif
+
+static constexpr int numBins = 12;
+
+float SurfaceArea(const glm::vec3& min, const glm::vec3& max) {
+	const glm::vec3 size = glm::max(max - min, glm::vec3(0.0f));
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+static void Grow(glm::vec3& min, glm::vec3& max, const BoundingBox& box) {
+	min = glm::min(min, box.min);
+	max = glm::max(max, box.max);
+}
+
+std::vector<BvhNode> BuildBvh(const std::vector<BoundingBox>& boxes, std::vector<uint32_t>& order, uint32_t maxLeafSize) {
+	order.resize(boxes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::vector<BvhNode> nodes;
+	if (boxes.empty()) { return nodes; }
+	nodes.reserve(2 * boxes.size());
+	BvhNode root;
+	root.count = (uint32_t)boxes.size();
+	nodes.push_back(root);
+
+	std::vector<std::pair<uint32_t, int>> stack = { { 0, 0 } }; // node and its depth
+	while (!stack.empty()) {
+		const auto [nodeIx, depth] = stack.back();
+		stack.pop_back();
+		const uint32_t first = nodes[nodeIx].first;
+		const uint32_t count = nodes[nodeIx].count;
+		glm::vec3 min(std::numeric_limits<float>::max());
+		glm::vec3 max(std::numeric_limits<float>::lowest());
+		glm::vec3 centerMin = min;
+		glm::vec3 centerMax = max;
+		for (uint32_t ix = first; ix < first + count; ix++) {
+			const BoundingBox& box = boxes[order[ix]];
+			Grow(min, max, box);
+			const glm::vec3 center = (box.min + box.max) * 0.5f;
+			centerMin = glm::min(centerMin, center);
+			centerMax = glm::max(centerMax, center);
+		}
+		nodes[nodeIx].min = min;
+		nodes[nodeIx].max = max;
+		if (count <= maxLeafSize) { continue; }
+
+		// Bin the items by their centers along each axis, and cost the planes between bins by the areas and counts of both sides
+		int bestAxis = -1;
+		int bestBin = 0;
+		float bestCost = std::numeric_limits<float>::max();
+		// Deep nodes are split in the middle, which reaches single items within 32 more levels
+		const bool canUseSah = depth < maxBvhDepth - 32;
+		for (int axis = 0; canUseSah && axis < 3; axis++) {
+			const float extent = centerMax[axis] - centerMin[axis];
+			if (extent <= 0.0f) { continue; }
+			const float binScale = numBins / extent;
+			std::array<uint32_t, numBins> binCounts = {};
+			std::array<glm::vec3, numBins> binMins, binMaxs;
+			binMins.fill(glm::vec3(std::numeric_limits<float>::max()));
+			binMaxs.fill(glm::vec3(std::numeric_limits<float>::lowest()));
+			for (uint32_t ix = first; ix < first + count; ix++) {
+				const BoundingBox& box = boxes[order[ix]];
+				const float center = (box.min[axis] + box.max[axis]) * 0.5f;
+				const int bin = std::min((int)((center - centerMin[axis]) * binScale), numBins - 1);
+				binCounts[bin]++;
+				Grow(binMins[bin], binMaxs[bin], box);
+			}
+			// Sweep from the right to get the costs of the right sides, then from the left
+			std::array<float, numBins> rightCosts = {};
+			glm::vec3 sideMin(std::numeric_limits<float>::max());
+			glm::vec3 sideMax(std::numeric_limits<float>::lowest());
+			uint32_t sideCount = 0;
+			for (int bin = numBins - 1; bin > 0; bin--) {
+				sideMin = glm::min(sideMin, binMins[bin]);
+				sideMax = glm::max(sideMax, binMaxs[bin]);
+				sideCount += binCounts[bin];
+				rightCosts[bin] = sideCount * SurfaceArea(sideMin, sideMax);
+			}
+			sideMin = glm::vec3(std::numeric_limits<float>::max());
+			sideMax = glm::vec3(std::numeric_limits<float>::lowest());
+			sideCount = 0;
+			for (int bin = 1; bin < numBins; bin++) {
+				sideMin = glm::min(sideMin, binMins[bin - 1]);
+				sideMax = glm::max(sideMax, binMaxs[bin - 1]);
+				sideCount += binCounts[bin - 1];
+				const float cost = sideCount * SurfaceArea(sideMin, sideMax) + rightCosts[bin];
+				if (sideCount > 0 && sideCount < count && cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = bin;
+				}
+			}
+		}
+
+		uint32_t numLeft = count / 2; // items with the same center are split in the middle
+		if (bestAxis >= 0) {
+			const float binScale = numBins / (centerMax[bestAxis] - centerMin[bestAxis]);
+			auto middle = std::partition(order.begin() + first, order.begin() + first + count, [&](uint32_t item) {
+				const float center = (boxes[item].min[bestAxis] + boxes[item].max[bestAxis]) * 0.5f;
+				return std::min((int)((center - centerMin[bestAxis]) * binScale), numBins - 1) < bestBin;
+			});
+			numLeft = (uint32_t)(middle - (order.begin() + first));
+		}
+		BvhNode left;
+		left.first = first;
+		left.count = numLeft;
+		BvhNode right;
+		right.first = first + numLeft;
+		right.count = count - numLeft;
+		nodes[nodeIx].first = (uint32_t)nodes.size();
+		nodes[nodeIx].count = 0;
+		stack.emplace_back((uint32_t)nodes.size(), depth + 1);
+		nodes.push_back(left);
+		stack.emplace_back((uint32_t)nodes.size(), depth + 1);
+		nodes.push_back(right);
+	}
+	return nodes;
+}
+
+void RefitBvh(std::vector<BvhNode>& nodes, const std::vector<BoundingBox>& boxes, const std::vector<uint32_t>& order) {
+	for (size_t nodeIx = nodes.size(); nodeIx-- > 0;) {
+		BvhNode& node = nodes[nodeIx];
+		node.min = glm::vec3(std::numeric_limits<float>::max());
+		node.max = glm::vec3(std::numeric_limits<float>::lowest());
+		if (node.IsLeaf()) {
+			for (uint32_t ix = node.first; ix < node.first + node.count; ix++) { Grow(node.min, node.max, boxes[order[ix]]); }
+		}
+		else {
+			for (const BvhNode& child : { nodes[node.first], nodes[node.first + 1] }) {
+				node.min = glm::min(node.min, child.min);
+				node.max = glm::max(node.max, child.max);
+			}
+		}
+	}
+}
+
+BvhRay::BvhRay(const glm::vec3& origin, const glm::vec3& direction)
+	: origin(origin), direction(direction), inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z) {}
+
+// Slab test [Kay and Kajiya 1986]. Division by zero components gives infinities that keep the test working.
+float IntersectRayBox(const BvhRay& ray, const glm::vec3& min, const glm::vec3& max, float maxDistance) {
+#ifdef AL_SSE
+	// The fourth lane spans all distances, so that it never decides
+	const float infinity = std::numeric_limits<float>::infinity();
+	const __m128 origin = _mm_setr_ps(ray.origin.x, ray.origin.y, ray.origin.z, 0.0f);
+	const __m128 inverseDirection = _mm_setr_ps(ray.inverseDirection.x, ray.inverseDirection.y, ray.inverseDirection.z, 1.0f);
+	const __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(min.x, min.y, min.z, -infinity), origin), inverseDirection);
+	const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(max.x, max.y, max.z, infinity), origin), inverseDirection);
+	__m128 tEnter = _mm_min_ps(t0, t1);
+	__m128 tExit = _mm_max_ps(t0, t1);
+	tEnter = _mm_max_ps(tEnter, _mm_shuffle_ps(tEnter, tEnter, _MM_SHUFFLE(2, 3, 0, 1)));
+	tEnter = _mm_max_ps(tEnter, _mm_shuffle_ps(tEnter, tEnter, _MM_SHUFFLE(1, 0, 3, 2)));
+	tExit = _mm_min_ps(tExit, _mm_shuffle_ps(tExit, tExit, _MM_SHUFFLE(2, 3, 0, 1)));
+	tExit = _mm_min_ps(tExit, _mm_shuffle_ps(tExit, tExit, _MM_SHUFFLE(1, 0, 3, 2)));
+	const float enter = std::max(_mm_cvtss_f32(tEnter), 0.0f);
+	const float exit = _mm_cvtss_f32(tExit);
+#else
+	const glm::vec3 t0 = (min - ray.origin) * ray.inverseDirection;
+	const glm::vec3 t1 = (max - ray.origin) * ray.inverseDirection;
+	const glm::vec3 tEnter = glm::min(t0, t1);
+	const glm::vec3 tExit = glm::max(t0, t1);
+	const float enter = std::max({ tEnter.x, tEnter.y, tEnter.z, 0.0f });
+	const float exit = std::min({ tExit.x, tExit.y, tExit.z });
+#endif
+	return enter <= exit && enter <= maxDistance ? enter : bvhNoHit;
+}
+
+TriangleBvh::TriangleBvh(const BasicVertex* vertices, const unsigned int* indices, size_t indexOffset, size_t indexCount) {
+	numTriangles = indexCount / 3;
+	std::vector<BoundingBox> boxes(numTriangles);
+	for (size_t tri = 0; tri < numTriangles; tri++) {
+		const unsigned int* corners = &indices[indexOffset + 3 * tri];
+		boxes[tri].min = glm::min(glm::min(vertices[corners[0]].position, vertices[corners[1]].position), vertices[corners[2]].position);
+		boxes[tri].max = glm::max(glm::max(vertices[corners[0]].position, vertices[corners[1]].position), vertices[corners[2]].position);
+	}
+	std::vector<uint32_t> order;
+	nodes = BuildBvh(boxes, order, 4);
+
+	// Copy the triangles of each leaf into a pack, in the order of the leaves
+	for (BvhNode& node : nodes) {
+		if (!node.IsLeaf()) { continue; }
+		TrianglePack pack = {};
+		for (uint32_t lane = 0; lane < node.count; lane++) {
+			const unsigned int* corners = &indices[indexOffset + 3 * order[node.first + lane]];
+			const glm::vec3& v0 = vertices[corners[0]].position;
+			const glm::vec3 e1 = vertices[corners[1]].position - v0;
+			const glm::vec3 e2 = vertices[corners[2]].position - v0;
+			pack.v0x[lane] = v0.x; pack.v0y[lane] = v0.y; pack.v0z[lane] = v0.z;
+			pack.e1x[lane] = e1.x; pack.e1y[lane] = e1.y; pack.e1z[lane] = e1.z;
+			pack.e2x[lane] = e2.x; pack.e2y[lane] = e2.y; pack.e2z[lane] = e2.z;
+		}
+		node.first = (uint32_t)packs.size();
+		packs.push_back(pack);
+	}
+}
+
+float TriangleBvh::Intersect(const BvhRay& ray, float maxDistance) const {
+	if (nodes.empty() || IntersectRayBox(ray, nodes[0].min, nodes[0].max, maxDistance) == bvhNoHit) { return bvhNoHit; }
+	float nearest = maxDistance;
+	bool isHit = false;
+	uint32_t stack[maxBvhDepth + 1];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		const BvhNode& node = nodes[stack[--stackSize]];
+		if (node.IsLeaf()) {
+			const float distance = IntersectPack(packs[node.first], ray, nearest);
+			if (distance != bvhNoHit) {
+				nearest = distance;
+				isHit = true;
+			}
+			continue;
+		}
+		// Visit the nearer child first, so that the farther one is likely skipped once something is hit
+		float leftDistance = IntersectRayBox(ray, nodes[node.first].min, nodes[node.first].max, nearest);
+		float rightDistance = IntersectRayBox(ray, nodes[node.first + 1].min, nodes[node.first + 1].max, nearest);
+		uint32_t nearChild = node.first;
+		uint32_t farChild = node.first + 1;
+		if (rightDistance < leftDistance) {
+			std::swap(leftDistance, rightDistance);
+			std::swap(nearChild, farChild);
+		}
+		if (rightDistance != bvhNoHit) { stack[stackSize++] = farChild; }
+		if (leftDistance != bvhNoHit) { stack[stackSize++] = nearChild; }
+	}
+	return isHit ? nearest : bvhNoHit;
+}
+
+// Moller-Trumbore for four triangles at once [Moller and Trumbore 1997]. Triangles are hit from both sides.
+float TriangleBvh::IntersectPack(const TrianglePack& pack, const BvhRay& ray, float maxDistance) const {
+	float nearest = bvhNoHit;
+#ifdef AL_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 dirX = _mm_set1_ps(ray.direction.x);
+	const __m128 dirY = _mm_set1_ps(ray.direction.y);
+	const __m128 dirZ = _mm_set1_ps(ray.direction.z);
+	const __m128 e1x = _mm_loadu_ps(pack.e1x), e1y = _mm_loadu_ps(pack.e1y), e1z = _mm_loadu_ps(pack.e1z);
+	const __m128 e2x = _mm_loadu_ps(pack.e2x), e2y = _mm_loadu_ps(pack.e2y), e2z = _mm_loadu_ps(pack.e2z);
+	// p = direction x e2, det = e1 . p
+	const __m128 px = _mm_sub_ps(_mm_mul_ps(dirY, e2z), _mm_mul_ps(dirZ, e2y));
+	const __m128 py = _mm_sub_ps(_mm_mul_ps(dirZ, e2x), _mm_mul_ps(dirX, e2z));
+	const __m128 pz = _mm_sub_ps(_mm_mul_ps(dirX, e2y), _mm_mul_ps(dirY, e2x));
+	const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+	const __m128 inverseDet = _mm_div_ps(one, det);
+	// s = origin - v0, u = (s . p) / det
+	const __m128 sx = _mm_sub_ps(_mm_set1_ps(ray.origin.x), _mm_loadu_ps(pack.v0x));
+	const __m128 sy = _mm_sub_ps(_mm_set1_ps(ray.origin.y), _mm_loadu_ps(pack.v0y));
+	const __m128 sz = _mm_sub_ps(_mm_set1_ps(ray.origin.z), _mm_loadu_ps(pack.v0z));
+	const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverseDet);
+	// q = s x e1, v = (direction . q) / det, t = (e2 . q) / det
+	const __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+	const __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+	const __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+	const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dirX, qx), _mm_mul_ps(dirY, qy)), _mm_mul_ps(dirZ, qz)), inverseDet);
+	const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverseDet);
+
+	__m128 isHit = _mm_cmpneq_ps(det, zero);
+	isHit = _mm_and_ps(isHit, _mm_cmpge_ps(u, zero));
+	isHit = _mm_and_ps(isHit, _mm_cmpge_ps(v, zero));
+	isHit = _mm_and_ps(isHit, _mm_cmple_ps(_mm_add_ps(u, v), one));
+	isHit = _mm_and_ps(isHit, _mm_cmpge_ps(t, zero));
+	isHit = _mm_and_ps(isHit, _mm_cmple_ps(t, _mm_set1_ps(maxDistance)));
+	alignas(16) float distances[4];
+	_mm_store_ps(distances, t);
+	for (unsigned int lanes = (unsigned int)_mm_movemask_ps(isHit); lanes != 0; lanes &= lanes - 1) {
+		nearest = std::min(nearest, distances[std::countr_zero(lanes)]);
+	}
+#else
+	for (int lane = 0; lane < 4; lane++) {
+		const glm::vec3 e1 = { pack.e1x[lane], pack.e1y[lane], pack.e1z[lane] };
+		const glm::vec3 e2 = { pack.e2x[lane], pack.e2y[lane], pack.e2z[lane] };
+		const glm::vec3 p = glm::cross(ray.direction, e2);
+		const float det = glm::dot(e1, p);
+		if (det == 0.0f) { continue; }
+		const float inverseDet = 1.0f / det;
+		const glm::vec3 s = ray.origin - glm::vec3(pack.v0x[lane], pack.v0y[lane], pack.v0z[lane]);
+		const float u = glm::dot(s, p) * inverseDet;
+		const glm::vec3 q = glm::cross(s, e1);
+		const float v = glm::dot(ray.direction, q) * inverseDet;
+		const float t = glm::dot(e2, q) * inverseDet;
+		if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t <= maxDistance) { nearest = std::min(nearest, t); }
+	}
+#endif
+	return nearest;
+}
\ No newline at end of file
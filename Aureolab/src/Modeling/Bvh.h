@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Modeling.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Node of a bounding volume hierarchy. Children of a node are stored after it, so refitting in reverse order visits children before parents.
+struct BvhNode {
+	glm::vec3 min = glm::vec3(0.0f);
+	uint32_t first = 0; // inner nodes: index of the left child, the right one follows. Leaves: first item.
+	glm::vec3 max = glm::vec3(0.0f);
+	uint32_t count = 0; // number of items of a leaf, 0 for inner nodes
+
+	bool IsLeaf() const { return count > 0; }
+};
+
+// Deepest a BVH gets, so that traversals can keep their stack on the stack
+static constexpr int maxBvhDepth = 64;
+
+// Builds a BVH over items given by their boxes, splitting nodes at the best of a few planes by the surface area heuristic [Wald 2007].
+// order receives the item indices so that each leaf covers order[first, first + count). Leaves have at most maxLeafSize items.
+std::vector<BvhNode> BuildBvh(const std::vector<BoundingBox>& boxes, std::vector<uint32_t>& order, uint32_t maxLeafSize);
+// Recomputes the boxes of all nodes after items moved, keeping the tree as it is
+void RefitBvh(std::vector<BvhNode>& nodes, const std::vector<BoundingBox>& boxes, const std::vector<uint32_t>& order);
+float SurfaceArea(const glm::vec3& min, const glm::vec3& max);
+
+struct BvhRay {
+	glm::vec3 origin;
+	glm::vec3 direction; // not necessarily normalized, distances are in units of it
+	glm::vec3 inverseDirection;
+
+	BvhRay(const glm::vec3& origin, const glm::vec3& direction);
+};
+
+static constexpr float bvhNoHit = std::numeric_limits<float>::infinity();
+
+// Distance along the ray where it enters the box, or where it starts when inside. bvhNoHit when it misses the box or enters after maxDistance.
+float IntersectRayBox(const BvhRay& ray, const glm::vec3& min, const glm::vec3& max, float maxDistance);
+
+/*
+* BVH over the triangles of a mesh for ray queries on the CPU, e.g. picking. Keeps its own copy of the triangles, in packs of four
+* that are tested against a ray at once with SSE. Leaves hold a single pack.
+*/
+class TriangleBvh {
+public:
+	TriangleBvh() = default;
+	// Over the triangles of indices [indexOffset, indexOffset + indexCount), e.g. LOD 0
+	TriangleBvh(const BasicVertex* vertices, const unsigned int* indices, size_t indexOffset, size_t indexCount);
+
+	// Distance to the nearest triangle the ray hits from either side before maxDistance, bvhNoHit if none
+	float Intersect(const BvhRay& ray, float maxDistance = bvhNoHit) const;
+	bool IsEmpty() const { return nodes.empty(); }
+	size_t GetNumTriangles() const { return numTriangles; }
+
+private:
+	// Four triangles as a vertex and two edges each, structure of arrays. Unused lanes are degenerate and never hit.
+	struct TrianglePack {
+		float v0x[4], v0y[4], v0z[4];
+		float e1x[4], e1y[4], e1z[4];
+		float e2x[4], e2y[4], e2z[4];
+	};
+	float IntersectPack(const TrianglePack& pack, const BvhRay& ray, float maxDistance) const;
+
+	std::vector<BvhNode> nodes; // leaves refer to one pack with first
+	std::vector<TrianglePack> packs;
+	size_t numTriangles = 0;
+};
\ No newline at end of file
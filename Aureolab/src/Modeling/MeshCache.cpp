@@ -0,0 +1,202 @@
+#include "MeshCache.h"
+
+#include "Core/Log.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+uint64_t HashFileContent(const std::string& filepath) {
+	MappedFile* file = MappedFile::Open(filepath);
+	if (file == nullptr) { return 0; }
+	const unsigned char* bytes = (const unsigned char*)file->GetData();
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t ix = 0; ix < file->GetSize(); ix++) {
+		hash ^= bytes[ix];
+		hash *= 1099511628211ull;
+	}
+	delete file;
+	return hash;
+}
+
+// Size and last write time of a file, zeros if it cannot be read
+static void GetFileStamp(const std::string& filepath, uint64_t& size, int64_t& writeTime) {
+	std::error_code error;
+	const uintmax_t fileSize = std::filesystem::file_size(filepath, error);
+	size = error ? 0 : (uint64_t)fileSize;
+	const std::filesystem::file_time_type time = std::filesystem::last_write_time(filepath, error);
+	writeTime = error ? 0 : (int64_t)time.time_since_epoch().count();
+}
+
+// Several workers may load the same OBJ file, e.g. for two vertex formats. Only one at a time reads or writes its cache.
+static std::mutex& GetCacheMutex(const std::string& cachePath) {
+	static std::mutex mutexesMutex;
+	static std::unordered_map<std::string, std::mutex> mutexes;
+	std::lock_guard<std::mutex> lock(mutexesMutex);
+	return mutexes[cachePath];
+}
+
+std::string MeshCache::GetCachePath(const std::string& objFilepath) {
+	return objFilepath + ".almesh";
+}
+
+// Overwrites the source write time in the header of an existing cache file
+static bool WriteSourceWriteTime(const std::string& cachePath, int64_t sourceWriteTime) {
+	std::fstream output(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+	if (!output.is_open()) { return false; }
+	output.seekp(offsetof(MeshCacheHeader, sourceWriteTime));
+	output.write((const char*)&sourceWriteTime, sizeof(sourceWriteTime));
+	return output.good();
+}
+
+// Ranges and indices must stay within their arrays, as they are used without checks, e.g. by BuildTriangleBvh
+static bool IsPayloadValid(const MeshCache& cache) {
+	const MeshCacheHeader& header = cache.GetHeader();
+	if (header.indexSize == sizeof(unsigned short) && header.numVertices > (size_t)std::numeric_limits<unsigned short>::max() + 1) { return false; }
+	for (uint32_t ix = 0; ix < header.numLods; ix++) {
+		const MeshLod& lod = cache.GetLods()[ix];
+		if ((uint64_t)lod.indexOffset + lod.indexCount > header.numIndices) { return false; }
+	}
+	for (uint32_t ix = 0; ix < header.numMeshlets; ix++) {
+		const Meshlet& meshlet = cache.GetMeshlets()[ix];
+		if ((uint64_t)meshlet.indexOffset + meshlet.indexCount > header.numIndices) { return false; }
+	}
+	auto areIndicesValid = [&header](const auto* indices) {
+		return std::all_of(indices, indices + header.numIndices, [&header](uint32_t index) { return index < header.numVertices; });
+	};
+	return cache.GetIndexType() == IndexType::uint16 ? areIndicesValid((const unsigned short*)cache.GetIndices()) : areIndicesValid((const unsigned int*)cache.GetIndices());
+}
+
+MeshCache* MeshCache::Open(const std::string& objFilepath) {
+	const std::string cachePath = GetCachePath(objFilepath);
+	std::lock_guard<std::mutex> lock(GetCacheMutex(cachePath));
+	MappedFile* file = MappedFile::Open(cachePath);
+	if (file == nullptr) { return nullptr; }
+
+	MeshCache* cache = new MeshCache(file);
+	bool isValid = file->GetSize() >= sizeof(MeshCacheHeader);
+	if (isValid) {
+		const MeshCacheHeader& header = cache->GetHeader();
+		size_t expectedSize = sizeof(MeshCacheHeader) + (size_t)header.numVertices * header.vertexSize + (size_t)header.numLods * sizeof(MeshLod) + (size_t)header.numMeshlets * sizeof(Meshlet) + (size_t)header.numIndices * header.indexSize;
+		isValid = std::memcmp(header.magic, MeshCacheHeader{}.magic, sizeof(header.magic)) == 0
+			&& header.version == formatVersion
+			&& header.vertexSize == sizeof(BasicVertex)
+			&& (header.indexSize == sizeof(unsigned short) || header.indexSize == sizeof(unsigned int))
+			&& file->GetSize() == expectedSize
+			&& IsPayloadValid(*cache);
+	}
+	uint64_t sourceSize = 0;
+	int64_t sourceWriteTime = 0;
+	bool isWriteTimeStale = false;
+	if (isValid) {
+		const MeshCacheHeader& header = cache->GetHeader();
+		GetFileStamp(objFilepath, sourceSize, sourceWriteTime);
+		isValid = sourceSize != 0 && header.sourceSize == sourceSize;
+		if (isValid && header.sourceWriteTime != sourceWriteTime) {
+			isValid = header.sourceHash == HashFileContent(objFilepath);
+			isWriteTimeStale = isValid;
+		}
+	}
+	if (!isValid) {
+		Log::Debug("Mesh cache of {} is stale or corrupt.", objFilepath);
+		delete cache;
+		return nullptr;
+	}
+	if (isWriteTimeStale) {
+		// Same content with a new write time, e.g. after a touch or a checkout. Storing the new time spares hashing the file at the next open.
+		// The mapping does not share writes, so it is closed for the update and opened again.
+		delete cache;
+		if (!WriteSourceWriteTime(cachePath, sourceWriteTime)) { Log::Warning("Cannot update mesh cache of {}", objFilepath); }
+		file = MappedFile::Open(cachePath);
+		if (file == nullptr) { return nullptr; }
+		cache = new MeshCache(file);
+	}
+	return cache;
+}
+
+// The stamp is taken before hashing. A save in between leaves an older stamp, so that the next open hashes the file again.
+MeshCacheSource MeshCache::ReadSource(const std::string& objFilepath) {
+	MeshCacheSource source;
+	GetFileStamp(objFilepath, source.size, source.writeTime);
+	source.hash = HashFileContent(objFilepath);
+	return source;
+}
+
+bool MeshCache::Write(const std::string& objFilepath, const MeshCacheSource& source, const MeshData& mesh) {
+	if (mesh.vertices.empty() || mesh.indices.empty()) { return false; }
+	MeshCacheHeader header;
+	header.version = formatVersion;
+	header.sourceHash = source.hash;
+	header.sourceSize = source.size;
+	header.sourceWriteTime = source.writeTime;
+	header.vertexSize = sizeof(BasicVertex);
+	header.numVertices = (uint32_t)mesh.vertices.size();
+	header.numIndices = (uint32_t)mesh.indices.size();
+	const bool isCompact = mesh.vertices.size() <= (size_t)std::numeric_limits<unsigned short>::max() + 1;
+	header.indexSize = isCompact ? sizeof(unsigned short) : sizeof(unsigned int);
+	header.numLods = (uint32_t)mesh.lods.size();
+	header.numMeshlets = (uint32_t)mesh.meshlets.size();
+
+	// Written to a temporary file that replaces the cache when complete, so that a failed or interrupted write does not leave a partial cache
+	const std::string cachePath = GetCachePath(objFilepath);
+	const std::string temporaryPath = cachePath + ".tmp";
+	std::lock_guard<std::mutex> lock(GetCacheMutex(cachePath));
+	std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+	if (!output.is_open()) {
+		Log::Warning("Cannot write mesh cache of {}", objFilepath);
+		return false;
+	}
+	output.write((const char*)&header, sizeof(header));
+	output.write((const char*)mesh.vertices.data(), sizeof(BasicVertex) * mesh.vertices.size());
+	output.write((const char*)mesh.lods.data(), sizeof(MeshLod) * mesh.lods.size());
+	output.write((const char*)mesh.meshlets.data(), sizeof(Meshlet) * mesh.meshlets.size());
+	if (isCompact) {
+		std::vector<unsigned short> shortIndices(mesh.indices.begin(), mesh.indices.end());
+		output.write((const char*)shortIndices.data(), sizeof(unsigned short) * shortIndices.size());
+	}
+	else {
+		output.write((const char*)mesh.indices.data(), sizeof(unsigned int) * mesh.indices.size());
+	}
+	output.close();
+	std::error_code error;
+	if (output.good()) { std::filesystem::rename(temporaryPath, cachePath, error); }
+	if (!output.good() || error) {
+		Log::Warning("Cannot write mesh cache of {}", objFilepath);
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+	return true;
+}
+
+MeshCache::~MeshCache() {
+	delete file;
+}
+
+const MeshCacheHeader& MeshCache::GetHeader() const {
+	return *(const MeshCacheHeader*)file->GetData();
+}
+
+const BasicVertex* MeshCache::GetVertices() const {
+	return (const BasicVertex*)((const char*)file->GetData() + sizeof(MeshCacheHeader));
+}
+
+const MeshLod* MeshCache::GetLods() const {
+	return (const MeshLod*)((const char*)GetVertices() + sizeof(BasicVertex) * GetHeader().numVertices);
+}
+
+const Meshlet* MeshCache::GetMeshlets() const {
+	return (const Meshlet*)((const char*)GetLods() + sizeof(MeshLod) * GetHeader().numLods);
+}
+
+const void* MeshCache::GetIndices() const {
+	return (const char*)GetMeshlets() + sizeof(Meshlet) * GetHeader().numMeshlets;
+}
+
+IndexType MeshCache::GetIndexType() const {
+	return GetHeader().indexSize == sizeof(unsigned short) ? IndexType::uint16 : IndexType::uint32;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Modeling.h"
+#include "Core/MappedFile.h"
+#include "Renderer/IndexBuffer.h"
+
+#include <cstdint>
+#include <string>
+
+// Layout of a mesh cache file: MeshCacheHeader | BasicVertex[numVertices] | MeshLod[numLods] | Meshlet[numMeshlets] | uint16 or uint32 [numIndices]
+struct MeshCacheHeader {
+	char magic[4] = { 'A', 'L', 'M', 'C' };
+	uint32_t version = 0;
+	uint64_t sourceHash = 0; // content hash of the OBJ file the cache was created from
+	uint64_t sourceSize = 0; // size in bytes of the same file
+	int64_t sourceWriteTime = 0; // last write time of the same file, in ticks of std::filesystem::file_time_type
+	uint32_t vertexSize = 0; // sizeof(BasicVertex) at the time of writing
+	uint32_t numVertices = 0;
+	uint32_t numIndices = 0;
+	uint32_t indexSize = 0; // 2 or 4 bytes
+	uint32_t numLods = 0;
+	uint32_t numMeshlets = 0;
+};
+
+// Version of an OBJ file a cache is created from. Read it before parsing the file, so that a cache of an older version does not get the stamp of a newer one saved meanwhile.
+struct MeshCacheSource {
+	uint64_t hash = 0;
+	uint64_t size = 0;
+	int64_t writeTime = 0;
+};
+
+/*
+* Binary copy of an imported OBJ file, stored next to it, e.g. "suzanne.obj" -> "suzanne.obj.almesh"
+* Vertices and indices are stored exactly as they are uploaded to GPU. Loading a cached mesh is a memory mapping and two buffer uploads without any parsing.
+* Cache is invalidated when the content of the OBJ file changes or when the format version is bumped. The content is hashed only when
+* the size matches but the write time does not, e.g. after a checkout, so that opening a valid cache does not read the whole OBJ file.
+*/
+class MeshCache {
+public:
+	static const uint32_t formatVersion = 6; // 2: optimized triangle and vertex order, 3: LODs, 4: meshlets, 5: source size and write time, 6: meshlets in vertex cache and overdraw order
+
+	static std::string GetCachePath(const std::string& objFilepath);
+	// Returns nullptr when there is no valid cache for the OBJ file.
+	static MeshCache* Open(const std::string& objFilepath);
+	static MeshCacheSource ReadSource(const std::string& objFilepath);
+	// Call after importing an OBJ file so that next loads can skip parsing it. source is read before the import. Empty meshes, of files that failed to load, are not written.
+	static bool Write(const std::string& objFilepath, const MeshCacheSource& source, const MeshData& mesh);
+	~MeshCache();
+
+	const MeshCacheHeader& GetHeader() const;
+	const BasicVertex* GetVertices() const;
+	const MeshLod* GetLods() const;
+	const Meshlet* GetMeshlets() const;
+	const void* GetIndices() const;
+	IndexType GetIndexType() const;
+private:
+	MeshCache(MappedFile* file) : file(file) {}
+	MappedFile* file;
+};
+
+// 64-bit FNV-1a hash of the whole content of a file. Returns 0 if the file cannot be read.
+uint64_t HashFileContent(const std::string& filepath);
\ No newline at end of file
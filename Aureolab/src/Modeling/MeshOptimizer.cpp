@@ -0,0 +1,180 @@
+#include "MeshOptimizer.h"
+
+#include "Core/Log.h"
+
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+// Simulates a FIFO cache of transformed vertices. Hits do not refresh an entry.
+class FifoCacheSimulator {
+public:
+	FifoCacheSimulator(size_t numVertices, unsigned int cacheSize)
+		: insertedAt(numVertices, 0), cacheSize(cacheSize) {}
+
+	// Returns whether the vertex had to be transformed
+	bool Access(unsigned int vertex) {
+		if (insertedAt[vertex] != 0 && time - insertedAt[vertex] < cacheSize) { return false; }
+		insertedAt[vertex] = ++time;
+		return true;
+	}
+
+private:
+	std::vector<size_t> insertedAt; // 0: never cached
+	size_t time = 0; // number of cache insertions so far
+	unsigned int cacheSize;
+};
+
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t numVertices, unsigned int cacheSize) {
+	VertexCacheStatistics stats;
+	if (indices.empty()) { return stats; }
+	FifoCacheSimulator cache(numVertices, cacheSize);
+	std::vector<bool> isReferenced(numVertices, false);
+	size_t numMisses = 0;
+	size_t numReferenced = 0;
+	for (unsigned int index : indices) {
+		numMisses += cache.Access(index);
+		if (!isReferenced[index]) { isReferenced[index] = true; numReferenced++; }
+	}
+	stats.acmr = (float)numMisses / (indices.size() / 3);
+	stats.atvr = (float)numMisses / numReferenced;
+	return stats;
+}
+
+std::vector<unsigned int> OptimizeVertexCache(const std::vector<unsigned int>& indices, size_t numVertices, std::vector<size_t>& clusterStarts, unsigned int cacheSize) {
+	const size_t numTriangles = indices.size() / 3;
+	clusterStarts = { 0 };
+
+	// Triangles around each vertex. Triangles of vertex v are adjacency[adjacencyStart[v]...adjacencyStart[v + 1]]
+	std::vector<unsigned int> liveTriangles(numVertices, 0); // number of not yet emitted triangles using the vertex
+	for (unsigned int index : indices) { liveTriangles[index]++; }
+	std::vector<unsigned int> adjacencyStart(numVertices + 1, 0);
+	std::partial_sum(liveTriangles.begin(), liveTriangles.end(), adjacencyStart.begin() + 1);
+	std::vector<unsigned int> adjacency(indices.size());
+	std::vector<unsigned int> adjacencyEnd(adjacencyStart.begin(), adjacencyStart.end() - 1);
+	for (size_t ix = 0; ix < indices.size(); ix++) { adjacency[adjacencyEnd[indices[ix]]++] = (unsigned int)(ix / 3); }
+
+	std::vector<unsigned int> cacheTime(numVertices, 0);
+	std::vector<bool> isEmitted(numTriangles, false);
+	std::vector<unsigned int> deadEndStack;
+	deadEndStack.reserve(indices.size());
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> output;
+	output.reserve(numTriangles * 3);
+
+	unsigned int time = cacheSize + 1;
+	size_t inputCursor = 0;
+	int fanningVertex = numVertices > 0 ? 0 : -1;
+	while (fanningVertex >= 0) {
+		// Emit all remaining triangles around the fanning vertex
+		candidates.clear();
+		for (unsigned int a = adjacencyStart[fanningVertex]; a < adjacencyStart[fanningVertex + 1]; a++) {
+			unsigned int triangle = adjacency[a];
+			if (isEmitted[triangle]) { continue; }
+			for (int c = 0; c < 3; c++) {
+				unsigned int vertex = indices[triangle * 3 + c];
+				output.push_back(vertex);
+				deadEndStack.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+				if (time - cacheTime[vertex] > cacheSize) { cacheTime[vertex] = time++; }
+			}
+			isEmitted[triangle] = true;
+		}
+
+		// Next fanning vertex is the oldest candidate that will still be in the cache after emitting its remaining triangles
+		int nextVertex = -1;
+		int bestPriority = -1;
+		for (unsigned int vertex : candidates) {
+			if (liveTriangles[vertex] == 0) { continue; }
+			int priority = 0;
+			if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize) { priority = time - cacheTime[vertex]; }
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				nextVertex = vertex;
+			}
+		}
+
+		// Dead-end: continue from the most recently used vertex that has triangles left, otherwise from the next one in input order
+		if (nextVertex == -1) {
+			while (!deadEndStack.empty() && nextVertex == -1) {
+				unsigned int vertex = deadEndStack.back();
+				deadEndStack.pop_back();
+				if (liveTriangles[vertex] > 0) { nextVertex = vertex; }
+			}
+			while (nextVertex == -1 && inputCursor < numVertices) {
+				if (liveTriangles[inputCursor] > 0) { nextVertex = (int)inputCursor; }
+				else { inputCursor++; }
+			}
+			if (nextVertex != -1 && output.size() / 3 > clusterStarts.back()) { clusterStarts.push_back(output.size() / 3); }
+		}
+		fanningVertex = nextVertex;
+	}
+	return output;
+}
+
+std::vector<size_t> SortClustersForOverdraw(const unsigned int* indices, size_t numTriangles, const std::vector<BasicVertex>& vertices, const std::vector<size_t>& clusterStarts) {
+	// Area weighted centroids and normals of clusters, and of the whole mesh
+	struct Cluster { size_t begin, end; glm::vec3 centroid = { 0.0f, 0.0f, 0.0f }; glm::vec3 normal = { 0.0f, 0.0f, 0.0f }; float area = 0.0f; float sortKey = 0.0f; };
+	std::vector<Cluster> clusterInfos(clusterStarts.size());
+	glm::vec3 meshCentroid = { 0.0f, 0.0f, 0.0f };
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusterStarts.size(); c++) {
+		Cluster& cluster = clusterInfos[c];
+		cluster.begin = clusterStarts[c];
+		cluster.end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : numTriangles;
+		for (size_t t = cluster.begin; t < cluster.end; t++) {
+			const glm::vec3& p0 = vertices[indices[t * 3 + 0]].position;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0); // length is twice the area
+			float area = glm::length(normal) * 0.5f;
+			cluster.centroid += (p0 + p1 + p2) / 3.0f * area;
+			cluster.normal += normal;
+			cluster.area += area;
+		}
+		meshCentroid += cluster.centroid;
+		meshArea += cluster.area;
+		if (cluster.area > 0.0f) { cluster.centroid /= cluster.area; }
+	}
+	if (meshArea > 0.0f) { meshCentroid /= meshArea; }
+	for (Cluster& cluster : clusterInfos) {
+		float normalLength = glm::length(cluster.normal);
+		cluster.sortKey = normalLength > 0.0f ? glm::dot(cluster.centroid - meshCentroid, cluster.normal / normalLength) : 0.0f;
+	}
+
+	std::vector<size_t> order(clusterStarts.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return clusterInfos[a].sortKey > clusterInfos[b].sortKey; });
+	return order;
+}
+
+void OptimizeVertexFetch(MeshData& mesh) {
+	const unsigned int unused = std::numeric_limits<unsigned int>::max();
+	std::vector<unsigned int> remap(mesh.vertices.size(), unused);
+	std::vector<BasicVertex> vertices;
+	vertices.reserve(mesh.vertices.size());
+	for (unsigned int& index : mesh.indices) {
+		if (remap[index] == unused) {
+			remap[index] = (unsigned int)vertices.size();
+			vertices.push_back(mesh.vertices[index]);
+		}
+		index = remap[index];
+	}
+	mesh.vertices = std::move(vertices);
+}
+
+void OptimizeMesh(MeshData& mesh, const std::string& name) {
+	// LOD 0 is the whole mesh when there are no LODs
+	auto analyzeLod0 = [&mesh]() {
+		const size_t numIndices = mesh.lods.empty() ? mesh.indices.size() : mesh.lods[0].indexCount;
+		return AnalyzeVertexCache(std::vector<unsigned int>(mesh.indices.begin(), mesh.indices.begin() + numIndices), mesh.vertices.size());
+	};
+	VertexCacheStatistics before = analyzeLod0();
+	BuildMeshlets(mesh);
+	OptimizeVertexFetch(mesh);
+	VertexCacheStatistics after = analyzeLod0();
+	Log::Debug("Optimized {}: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", name, before.acmr, after.acmr, before.atvr, after.atvr);
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Modeling.h"
+
+#include <string>
+#include <vector>
+
+// Efficiency of a triangle order for a FIFO post-transform vertex cache
+struct VertexCacheStatistics {
+	float acmr = 0.0f; // average cache miss ratio: vertex shader invocations per triangle. 0.5 is ideal for large grids, 3 is the worst.
+	float atvr = 0.0f; // average transformed vertex ratio: vertex shader invocations per vertex. 1 is ideal.
+};
+
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t numVertices, unsigned int cacheSize = 16);
+
+// Reorders triangles for post-transform vertex cache reuse via Tipsify [Sander et al. 2007].
+// clusterStarts receives the first triangle of each run that starts at a dead-end, i.e. with a cold cache.
+std::vector<unsigned int> OptimizeVertexCache(const std::vector<unsigned int>& indices, size_t numVertices, std::vector<size_t>& clusterStarts, unsigned int cacheSize = 16);
+
+// Order in which to draw clusters of consecutive triangles, given by their first triangles, so that clusters facing away from the center of
+// all the triangles are drawn first to occlude the rest [Sander et al. 2007]
+std::vector<size_t> SortClustersForOverdraw(const unsigned int* indices, size_t numTriangles, const std::vector<BasicVertex>& vertices, const std::vector<size_t>& clusterStarts);
+
+// Reorders vertices in the order they are first referenced by indices, so that vertex fetches are mostly sequential. Drops unused vertices.
+void OptimizeVertexFetch(MeshData& mesh);
+
+// Builds meshlets, whose triangles are in vertex cache order and which are sorted for overdraw (see BuildMeshlets), then optimizes vertex fetch.
+// Logs cache statistics of LOD 0 before and after. Call after GenerateLods, as the last step that changes the order of triangles or vertices.
+void OptimizeMesh(MeshData& mesh, const std::string& name);
\ No newline at end of file
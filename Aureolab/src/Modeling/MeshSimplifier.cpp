@@ -0,0 +1,248 @@
+#include "MeshSimplifier.h"
+
+#include "MeshOptimizer.h"
+#include "Core/Log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+// Sum of squared distances to a set of planes, weighted. Stored as the upper triangle of a symmetric 4x4 matrix.
+struct Quadric {
+	double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+	double b2 = 0.0, bc = 0.0, bd = 0.0;
+	double c2 = 0.0, cd = 0.0;
+	double d2 = 0.0;
+	double weight = 0.0;
+
+	// Plane is dot(normal, p) + d = 0, normal is unit length
+	void AddPlane(const glm::vec3& normal, float d, float planeWeight) {
+		const double a = normal.x, b = normal.y, c = normal.z, w = planeWeight;
+		a2 += w * a * a; ab += w * a * b; ac += w * a * c; ad += w * a * d;
+		b2 += w * b * b; bc += w * b * c; bd += w * b * d;
+		c2 += w * c * c; cd += w * c * d;
+		d2 += w * d * d;
+		weight += w;
+	}
+
+	void Add(const Quadric& q) {
+		a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+		b2 += q.b2; bc += q.bc; bd += q.bd;
+		c2 += q.c2; cd += q.cd;
+		d2 += q.d2;
+		weight += q.weight;
+	}
+
+	// Weighted mean of squared distances of p to the planes
+	double Evaluate(const glm::vec3& p) const {
+		const double x = p.x, y = p.y, z = p.z;
+		double error = a2 * x * x + b2 * y * y + c2 * z * z
+			+ 2.0 * (ab * x * y + ac * x * z + bc * y * z)
+			+ 2.0 * (ad * x + bd * y + cd * z)
+			+ d2;
+		return weight > 0.0 ? std::abs(error) / weight : 0.0;
+	}
+};
+
+enum class VertexKind : uint8_t {
+	Manifold, // can collapse onto any neighbor
+	Border, // can only collapse along a border edge
+	Locked, // on an attribute seam, a non-manifold edge or a corner of borders. Never moves.
+};
+
+static uint64_t EdgeKey(unsigned int a, unsigned int b) {
+	return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+
+// Number of triangles using each edge, where edges connect positions rather than vertices
+static std::unordered_map<uint64_t, unsigned int> CountEdges(const std::vector<unsigned int>& indices, const std::vector<unsigned int>& positionRemap) {
+	std::unordered_map<uint64_t, unsigned int> edgeCounts;
+	edgeCounts.reserve(indices.size());
+	for (size_t t = 0; t < indices.size(); t += 3) {
+		for (int c = 0; c < 3; c++) {
+			edgeCounts[EdgeKey(positionRemap[indices[t + c]], positionRemap[indices[t + (c + 1) % 3]])]++;
+		}
+	}
+	return edgeCounts;
+}
+
+std::vector<unsigned int> SimplifyMesh(const std::vector<BasicVertex>& vertices, const std::vector<unsigned int>& inputIndices, size_t targetIndexCount, float maxError, float* error) {
+	const size_t numVertices = vertices.size();
+	std::vector<unsigned int> indices = inputIndices;
+	const std::vector<unsigned int> positionRemap = RemapPositions(vertices);
+
+	// Classify vertices
+	std::vector<VertexKind> kinds(numVertices, VertexKind::Manifold);
+	for (size_t v = 0; v < numVertices; v++) {
+		if (positionRemap[v] != v) {
+			kinds[v] = VertexKind::Locked;
+			kinds[positionRemap[v]] = VertexKind::Locked;
+		}
+	}
+	std::unordered_map<uint64_t, unsigned int> edgeCounts = CountEdges(indices, positionRemap);
+	std::vector<unsigned int> numBorderEdges(numVertices, 0);
+	for (const auto& [key, count] : edgeCounts) {
+		unsigned int a = (unsigned int)(key >> 32), b = (unsigned int)(key & 0xFFFFFFFF);
+		if (count == 1) { numBorderEdges[a]++; numBorderEdges[b]++; }
+		else if (count > 2) { kinds[a] = kinds[b] = VertexKind::Locked; }
+	}
+	for (size_t v = 0; v < numVertices; v++) {
+		if (kinds[v] == VertexKind::Manifold && numBorderEdges[v] == 2) { kinds[v] = VertexKind::Border; }
+		else if (numBorderEdges[v] != 0 && numBorderEdges[v] != 2) { kinds[v] = VertexKind::Locked; }
+	}
+
+	// Quadrics of the planes of triangles around each position, plus planes perpendicular to border edges that keep borders in place
+	const float borderWeight = 10.0f;
+	std::vector<Quadric> quadrics(numVertices);
+	for (size_t t = 0; t < indices.size(); t += 3) {
+		const glm::vec3& p0 = vertices[indices[t + 0]].position;
+		const glm::vec3& p1 = vertices[indices[t + 1]].position;
+		const glm::vec3& p2 = vertices[indices[t + 2]].position;
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float doubleArea = glm::length(normal);
+		if (doubleArea == 0.0f) { continue; }
+		normal /= doubleArea;
+		for (int c = 0; c < 3; c++) {
+			quadrics[positionRemap[indices[t + c]]].AddPlane(normal, -glm::dot(normal, p0), doubleArea * 0.5f);
+		}
+		for (int c = 0; c < 3; c++) {
+			unsigned int a = positionRemap[indices[t + c]], b = positionRemap[indices[t + (c + 1) % 3]];
+			if (edgeCounts[EdgeKey(a, b)] != 1) { continue; }
+			glm::vec3 edge = vertices[b].position - vertices[a].position;
+			glm::vec3 borderNormal = glm::cross(edge, normal);
+			float length = glm::length(borderNormal);
+			if (length == 0.0f) { continue; }
+			borderNormal /= length;
+			float d = -glm::dot(borderNormal, vertices[a].position);
+			quadrics[a].AddPlane(borderNormal, d, glm::dot(edge, edge) * borderWeight);
+			quadrics[b].AddPlane(borderNormal, d, glm::dot(edge, edge) * borderWeight);
+		}
+	}
+
+	struct Collapse {
+		unsigned int from, to;
+		float error;
+	};
+	std::vector<Collapse> collapses;
+	std::vector<unsigned int> adjacencyStart(numVertices + 1);
+	std::vector<unsigned int> adjacency;
+	std::vector<unsigned int> remap(numVertices);
+	std::vector<bool> isTouched(numVertices);
+	float largestError = 0.0f;
+
+	// Each pass collapses a set of edges whose neighborhoods do not overlap, so that adjacency stays valid within the pass
+	const int maxPasses = 100;
+	for (int pass = 0; pass < maxPasses && indices.size() > targetIndexCount; pass++) {
+		// Triangles around each vertex
+		std::fill(adjacencyStart.begin(), adjacencyStart.end(), 0);
+		for (unsigned int index : indices) { adjacencyStart[index + 1]++; }
+		std::partial_sum(adjacencyStart.begin(), adjacencyStart.end(), adjacencyStart.begin());
+		adjacency.resize(indices.size());
+		std::vector<unsigned int> adjacencyEnd(adjacencyStart.begin(), adjacencyStart.end() - 1);
+		for (size_t ix = 0; ix < indices.size(); ix++) { adjacency[adjacencyEnd[indices[ix]]++] = (unsigned int)(ix / 3); }
+		if (pass > 0) { edgeCounts = CountEdges(indices, positionRemap); }
+
+		collapses.clear();
+		for (size_t t = 0; t < indices.size(); t += 3) {
+			for (int c = 0; c < 3; c++) {
+				unsigned int a = indices[t + c], b = indices[t + (c + 1) % 3];
+				for (auto [from, to] : { std::pair{ a, b }, std::pair{ b, a } }) {
+					if (kinds[from] == VertexKind::Locked) { continue; }
+					if (kinds[from] == VertexKind::Border && edgeCounts[EdgeKey(positionRemap[from], positionRemap[to])] != 1) { continue; }
+					Quadric quadric = quadrics[from];
+					quadric.Add(quadrics[positionRemap[to]]);
+					float collapseError = (float)std::sqrt(quadric.Evaluate(vertices[to].position));
+					if (collapseError <= maxError) { collapses.push_back({ from, to, collapseError }); }
+				}
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+		std::iota(remap.begin(), remap.end(), 0);
+		std::fill(isTouched.begin(), isTouched.end(), false);
+		const size_t numTrianglesToRemove = (indices.size() - targetIndexCount) / 3;
+		size_t numTrianglesRemoved = 0;
+		size_t numCollapses = 0;
+		for (const Collapse& collapse : collapses) {
+			if (numTrianglesRemoved >= numTrianglesToRemove) { break; }
+			if (isTouched[collapse.from] || isTouched[collapse.to]) { continue; }
+
+			// Reject collapses that flip a remaining triangle around from
+			bool flips = false;
+			size_t numDegenerate = 0;
+			for (unsigned int a = adjacencyStart[collapse.from]; a < adjacencyStart[collapse.from + 1] && !flips; a++) {
+				const unsigned int* triangle = &indices[adjacency[a] * 3];
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+					numDegenerate++;
+					continue;
+				}
+				glm::vec3 before[3], after[3];
+				for (int c = 0; c < 3; c++) {
+					before[c] = vertices[triangle[c]].position;
+					after[c] = triangle[c] == collapse.from ? vertices[collapse.to].position : before[c];
+				}
+				glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+				glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+				flips = glm::dot(normalBefore, normalAfter) < 0.0f;
+			}
+			if (flips) { continue; }
+
+			remap[collapse.from] = collapse.to;
+			quadrics[positionRemap[collapse.to]].Add(quadrics[collapse.from]);
+			largestError = std::max(largestError, collapse.error);
+			for (unsigned int a = adjacencyStart[collapse.from]; a < adjacencyStart[collapse.from + 1]; a++) {
+				for (int c = 0; c < 3; c++) { isTouched[indices[adjacency[a] * 3 + c]] = true; }
+			}
+			numTrianglesRemoved += numDegenerate;
+			numCollapses++;
+		}
+		if (numCollapses == 0) { break; }
+
+		// Apply collapses and drop triangles that became degenerate
+		size_t numKept = 0;
+		for (size_t t = 0; t < indices.size(); t += 3) {
+			unsigned int a = remap[indices[t + 0]], b = remap[indices[t + 1]], c = remap[indices[t + 2]];
+			if (a == b || b == c || c == a) { continue; }
+			indices[numKept++] = a;
+			indices[numKept++] = b;
+			indices[numKept++] = c;
+		}
+		indices.resize(numKept);
+	}
+
+	if (error != nullptr) { *error = largestError; }
+	return indices;
+}
+
+void GenerateLods(MeshData& mesh) {
+	const float ratios[] = { 0.5f, 0.25f, 0.125f };
+	const float minReduction = 0.8f; // stop the chain when a LOD cannot get below this fraction of the previous one
+	const float maxRelativeError = 0.05f; // fraction of the radius of the mesh
+
+	const size_t numIndices = mesh.indices.size();
+	const float maxError = ComputeBoundingSphere(mesh.vertices.data(), mesh.vertices.size()).radius * maxRelativeError;
+	mesh.lods = { MeshLod{ 0, (uint32_t)numIndices, 0.0f } };
+	std::vector<unsigned int> previous = mesh.indices;
+	float accumulatedError = 0.0f;
+	for (float ratio : ratios) {
+		size_t targetIndexCount = (size_t)(numIndices / 3 * ratio) * 3;
+		// Errors add up along the chain, so each LOD gets what earlier ones left of the budget
+		const float remainingError = maxError - accumulatedError;
+		if (remainingError <= 0.0f) { break; }
+		float lodError = 0.0f;
+		std::vector<unsigned int> lod = SimplifyMesh(mesh.vertices, previous, targetIndexCount, remainingError, &lodError);
+		if (lod.empty() || lod.size() > previous.size() * minReduction || accumulatedError + lodError > maxError) { break; }
+
+		std::vector<size_t> clusterStarts;
+		lod = OptimizeVertexCache(lod, mesh.vertices.size(), clusterStarts);
+		accumulatedError += lodError; // each LOD is simplified from the previous one
+		mesh.lods.push_back(MeshLod{ (uint32_t)mesh.indices.size(), (uint32_t)lod.size(), accumulatedError });
+		mesh.indices.insert(mesh.indices.end(), lod.begin(), lod.end());
+		previous = std::move(lod);
+	}
+
+	for (size_t ix = 1; ix < mesh.lods.size(); ix++) {
+		Log::Debug("LOD {}: {} triangles ({:.1f}%), error {:.4f}", ix, mesh.lods[ix].indexCount / 3, 100.0f * mesh.lods[ix].indexCount / numIndices, mesh.lods[ix].error);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Modeling.h"
+
+#include <vector>
+
+// Removes triangles via edge collapses in the order of their quadric error [Garland and Heckbert 1997] until there are targetIndexCount indices left,
+// or no collapse is below maxError (in model space units). Vertices are not moved, so the result refers to the same vertex array.
+// Vertices on attribute seams and non-manifold edges stay in place and border vertices only slide along the border, so that no cracks open.
+// error receives how far the simplified surface can be from the input.
+std::vector<unsigned int> SimplifyMesh(const std::vector<BasicVertex>& vertices, const std::vector<unsigned int>& indices, size_t targetIndexCount, float maxError, float* error = nullptr);
+
+// Appends LODs with about 50%, 25% and 12.5% of the triangles to mesh.indices and describes them in mesh.lods.
+// The chain ends early when a mesh cannot be simplified further without visible damage.
+void GenerateLods(MeshData& mesh);
\ No newline at end of file
@@ -0,0 +1,245 @@
+#include "Meshlets.h"
+
+#include "Core/Log.h"
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+
+// Sphere around the bounding box of the triangles and the cone of their normals [Meshoptimizer, meshopt_computeClusterBounds]
+static void ComputeMeshletBounds(Meshlet& meshlet, const std::vector<BasicVertex>& vertices, const std::vector<unsigned int>& indices) {
+	glm::vec3 min(std::numeric_limits<float>::max());
+	glm::vec3 max(std::numeric_limits<float>::lowest());
+	for (size_t ix = meshlet.indexOffset; ix < meshlet.indexOffset + meshlet.indexCount; ix++) {
+		min = glm::min(min, vertices[indices[ix]].position);
+		max = glm::max(max, vertices[indices[ix]].position);
+	}
+	meshlet.bounds.center = (min + max) * 0.5f;
+	meshlet.bounds.radius = 0.0f;
+	for (size_t ix = meshlet.indexOffset; ix < meshlet.indexOffset + meshlet.indexCount; ix++) {
+		meshlet.bounds.radius = std::max(meshlet.bounds.radius, glm::length(vertices[indices[ix]].position - meshlet.bounds.center));
+	}
+
+	// Area weighted average of face normals is the axis, the widest normal from it gives the angle
+	std::vector<glm::vec3> normals;
+	normals.reserve(meshlet.indexCount / 3);
+	glm::vec3 axis(0.0f);
+	for (size_t ix = meshlet.indexOffset; ix < meshlet.indexOffset + meshlet.indexCount; ix += 3) {
+		const glm::vec3& a = vertices[indices[ix + 0]].position;
+		const glm::vec3& b = vertices[indices[ix + 1]].position;
+		const glm::vec3& c = vertices[indices[ix + 2]].position;
+		const glm::vec3 normal = glm::cross(b - a, c - a);
+		const float area = glm::length(normal);
+		if (area == 0.0f) { continue; }
+		axis += normal;
+		normals.push_back(normal / area);
+	}
+	const float axisLength = glm::length(axis);
+	if (normals.empty() || axisLength == 0.0f) { return; }
+	meshlet.coneAxis = axis / axisLength;
+
+	float minDot = 1.0f;
+	for (const glm::vec3& normal : normals) { minDot = std::min(minDot, glm::dot(normal, meshlet.coneAxis)); }
+	// Cones wider than ~84 degrees almost never face away entirely, keep the cutoff at 1 for them
+	if (minDot <= 0.1f) { return; }
+	// A triangle faces away when the view direction is within 90 degrees of its normal, so the cone of culling directions is 90 degrees narrower
+	meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+static glm::vec3 SafeNormalize(const glm::vec3& v) {
+	const float length = glm::length(v);
+	return length > 0.0f ? v / length : glm::vec3(0.0f);
+}
+
+// Grows meshlets greedily over triangles [indexOffset, indexOffset + indexCount) and reorders them so that each meshlet is a contiguous range.
+// The next triangle is the one adding the fewest vertices, then the one closest to the meshlet and most aligned with its normals,
+// which keeps meshlets compact and their normal cones narrow [Meshoptimizer, meshopt_buildMeshlets].
+// Then triangles of each meshlet are put in vertex cache order, and meshlets in overdraw order, which the greedy order would have undone.
+static std::vector<Meshlet> BuildMeshlets(const std::vector<BasicVertex>& vertices, const std::vector<unsigned int>& positionRemap, std::vector<unsigned int>& indices, size_t indexOffset, size_t indexCount) {
+	const float coneWeight = 0.5f;
+	const size_t numTriangles = indexCount / 3;
+	const unsigned int* triangles = indices.data() + indexOffset;
+
+	std::vector<glm::vec3> centroids(numTriangles);
+	std::vector<glm::vec3> normals(numTriangles);
+	for (size_t t = 0; t < numTriangles; t++) {
+		const glm::vec3& a = vertices[triangles[t * 3 + 0]].position;
+		const glm::vec3& b = vertices[triangles[t * 3 + 1]].position;
+		const glm::vec3& c = vertices[triangles[t * 3 + 2]].position;
+		centroids[t] = (a + b + c) / 3.0f;
+		normals[t] = SafeNormalize(glm::cross(b - a, c - a));
+	}
+
+	// Triangles around each position, so that neighbors across attribute seams are found too
+	std::vector<unsigned int> adjacencyOffsets(vertices.size() + 1, 0);
+	for (size_t ix = 0; ix < indexCount; ix++) { adjacencyOffsets[positionRemap[triangles[ix]] + 1]++; }
+	std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+	std::vector<unsigned int> adjacency(indexCount);
+	std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t ix = 0; ix < indexCount; ix++) { adjacency[fill[positionRemap[triangles[ix]]]++] = (unsigned int)(ix / 3); }
+
+	const uint32_t none = std::numeric_limits<uint32_t>::max();
+	std::vector<uint32_t> vertexMeshlet(vertices.size(), none); // meshlet that last used each vertex
+	std::vector<uint32_t> positionMeshlet(vertices.size(), none); // same for positions
+	std::vector<bool> isEmitted(numTriangles, false);
+	std::vector<unsigned int> order;
+	order.reserve(numTriangles);
+
+	std::vector<Meshlet> meshlets;
+	std::vector<unsigned int> positions; // of the current meshlet
+	size_t numVertices = 0;
+	size_t numMeshletTriangles = 0;
+	glm::vec3 centroidSum(0.0f);
+	glm::vec3 normalSum(0.0f);
+	glm::vec3 previousCenter(0.0f);
+	glm::vec3 previousAxis(0.0f);
+	size_t nextUnemitted = 0;
+
+	auto countNewVertices = [&](size_t t) {
+		size_t count = 0;
+		for (size_t corner = 0; corner < 3; corner++) {
+			const unsigned int vertex = triangles[t * 3 + corner];
+			const bool isRepeated = (corner > 0 && triangles[t * 3] == vertex) || (corner > 1 && triangles[t * 3 + 1] == vertex);
+			if (vertexMeshlet[vertex] != meshlets.size() && !isRepeated) { count++; }
+		}
+		return count;
+	};
+	// Best unemitted triangle around the given positions, or none
+	auto findNeighbor = [&](const glm::vec3& center, const glm::vec3& axis, bool mustFit) {
+		uint32_t best = none;
+		size_t bestExtra = 0;
+		float bestScore = 0.0f;
+		for (unsigned int position : positions) {
+			for (unsigned int ix = adjacencyOffsets[position]; ix < adjacencyOffsets[position + 1]; ix++) {
+				const unsigned int t = adjacency[ix];
+				if (isEmitted[t]) { continue; }
+				const size_t extra = mustFit ? countNewVertices(t) : 0;
+				if (mustFit && numVertices + extra > maxMeshletVertices) { continue; }
+				const float score = glm::length(centroids[t] - center) * (1.0f + coneWeight * (1.0f - glm::dot(normals[t], axis)));
+				if (best == none || extra < bestExtra || (extra == bestExtra && score < bestScore)) {
+					best = t;
+					bestExtra = extra;
+					bestScore = score;
+				}
+			}
+		}
+		return best;
+	};
+	auto finishMeshlet = [&]() {
+		Meshlet meshlet;
+		meshlet.indexOffset = (uint32_t)(indexOffset + (order.size() - numMeshletTriangles) * 3);
+		meshlet.indexCount = (uint32_t)(numMeshletTriangles * 3);
+		meshlets.push_back(meshlet);
+		previousCenter = centroidSum / (float)numMeshletTriangles;
+		previousAxis = SafeNormalize(normalSum);
+		numVertices = 0;
+		numMeshletTriangles = 0;
+		centroidSum = glm::vec3(0.0f);
+		normalSum = glm::vec3(0.0f);
+	};
+
+	while (order.size() < numTriangles) {
+		uint32_t t = none;
+		if (numMeshletTriangles > 0) {
+			t = findNeighbor(centroidSum / (float)numMeshletTriangles, SafeNormalize(normalSum), true);
+			if (t == none) {
+				finishMeshlet();
+				continue;
+			}
+		}
+		else {
+			// Start next to the previous meshlet so that neighboring meshlets stay close, or at the first triangle left
+			if (!positions.empty()) { t = findNeighbor(previousCenter, previousAxis, false); }
+			positions.clear();
+			if (t == none) {
+				while (isEmitted[nextUnemitted]) { nextUnemitted++; }
+				t = (uint32_t)nextUnemitted;
+			}
+		}
+
+		numVertices += countNewVertices(t);
+		for (size_t corner = 0; corner < 3; corner++) {
+			const unsigned int vertex = triangles[t * 3 + corner];
+			vertexMeshlet[vertex] = (uint32_t)meshlets.size();
+			if (positionMeshlet[positionRemap[vertex]] != meshlets.size()) {
+				positionMeshlet[positionRemap[vertex]] = (uint32_t)meshlets.size();
+				positions.push_back(positionRemap[vertex]);
+			}
+		}
+		isEmitted[t] = true;
+		order.push_back(t);
+		numMeshletTriangles++;
+		centroidSum += centroids[t];
+		normalSum += normals[t];
+		if (numMeshletTriangles == maxMeshletTriangles) { finishMeshlet(); }
+	}
+	if (numMeshletTriangles > 0) { finishMeshlet(); }
+
+	// Triangles of each meshlet in vertex cache order. Vertices are numbered within the meshlet, so that OptimizeVertexCache works on small arrays.
+	std::vector<unsigned int> reordered(indexCount);
+	std::vector<size_t> meshletStarts(meshlets.size()); // first triangle of each meshlet in reordered
+	std::vector<uint32_t> localMeshlet(vertices.size(), none); // meshlet in which localVertex of each vertex is valid
+	std::vector<unsigned int> localVertex(vertices.size());
+	std::vector<unsigned int> meshletVertices;
+	std::vector<unsigned int> localIndices;
+	std::vector<size_t> clusterStarts;
+	for (size_t m = 0; m < meshlets.size(); m++) {
+		const size_t begin = (meshlets[m].indexOffset - indexOffset) / 3;
+		const size_t end = begin + meshlets[m].indexCount / 3;
+		meshletVertices.clear();
+		localIndices.clear();
+		for (size_t ix = begin; ix < end; ix++) {
+			for (size_t corner = 0; corner < 3; corner++) {
+				const unsigned int vertex = triangles[order[ix] * 3 + corner];
+				if (localMeshlet[vertex] != m) {
+					localMeshlet[vertex] = (uint32_t)m;
+					localVertex[vertex] = (unsigned int)meshletVertices.size();
+					meshletVertices.push_back(vertex);
+				}
+				localIndices.push_back(localVertex[vertex]);
+			}
+		}
+		localIndices = OptimizeVertexCache(localIndices, meshletVertices.size(), clusterStarts);
+		for (size_t ix = 0; ix < localIndices.size(); ix++) { reordered[begin * 3 + ix] = meshletVertices[localIndices[ix]]; }
+		meshletStarts[m] = begin;
+	}
+
+	// Meshlets facing away from the center of the LOD are drawn first
+	std::vector<Meshlet> sortedMeshlets;
+	sortedMeshlets.reserve(meshlets.size());
+	size_t cursor = indexOffset;
+	for (size_t m : SortClustersForOverdraw(reordered.data(), numTriangles, vertices, meshletStarts)) {
+		Meshlet meshlet = meshlets[m];
+		std::copy_n(reordered.begin() + meshletStarts[m] * 3, meshlet.indexCount, indices.begin() + cursor);
+		meshlet.indexOffset = (uint32_t)cursor;
+		cursor += meshlet.indexCount;
+		sortedMeshlets.push_back(meshlet);
+	}
+	for (Meshlet& meshlet : sortedMeshlets) { ComputeMeshletBounds(meshlet, vertices, indices); }
+	return sortedMeshlets;
+}
+
+void BuildMeshlets(MeshData& mesh) {
+	mesh.meshlets.clear();
+	const std::vector<unsigned int> positionRemap = RemapPositions(mesh.vertices);
+	if (mesh.lods.empty()) {
+		mesh.meshlets = BuildMeshlets(mesh.vertices, positionRemap, mesh.indices, 0, mesh.indices.size());
+	}
+	for (const MeshLod& lod : mesh.lods) {
+		std::vector<Meshlet> lodMeshlets = BuildMeshlets(mesh.vertices, positionRemap, mesh.indices, lod.indexOffset, lod.indexCount);
+		mesh.meshlets.insert(mesh.meshlets.end(), lodMeshlets.begin(), lodMeshlets.end());
+	}
+
+	size_t numCullable = std::count_if(mesh.meshlets.begin(), mesh.meshlets.end(), [](const Meshlet& m) { return m.coneCutoff < 1.0f; });
+	Log::Debug("Meshlets: {}, with a normal cone narrow enough for backface culling: {}", mesh.meshlets.size(), numCullable);
+}
+
+bool IsMeshletBackfacing(const Meshlet& meshlet, const glm::vec3& cameraPosition) {
+	const glm::vec3 toCenter = meshlet.bounds.center - cameraPosition;
+	return glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.bounds.radius;
+
+}
\ No newline at end of file
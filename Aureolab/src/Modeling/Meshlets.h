@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Modeling.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+static const size_t maxMeshletVertices = 64;
+static const size_t maxMeshletTriangles = 124;
+
+// Splits each LOD of the mesh, or the whole mesh when it has no LODs, into meshlets and fills mesh.meshlets.
+// Triangles are reordered within each LOD so that every meshlet is a contiguous range of indices. Within a meshlet they are in vertex cache order
+// (see OptimizeVertexCache), and meshlets are sorted to reduce overdraw (see SortClustersForOverdraw).
+void BuildMeshlets(MeshData& mesh);
+
+// True when every triangle of the meshlet faces away from the camera, from anywhere within its bounding sphere.
+// cameraPosition is in model space, where the test is exact also for non-uniformly scaled meshes.
+bool IsMeshletBackfacing(const Meshlet& meshlet, const glm::vec3& cameraPosition);
\ No newline at end of file
@@ -3,100 +3,125 @@
 #include "Core/Log.h"
 #include "Core/Math.h"
 
-#include <tiny_obj_loader.h>
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "ObjParser.h"
 
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+// Hashes the bit patterns of all attributes. Only bitwise identical vertices are welded.
+struct BasicVertexHash {
+    size_t operator()(const BasicVertex& vertex) const {
+        std::array<uint32_t, sizeof(BasicVertex) / sizeof(uint32_t)> words;
+        std::memcpy(words.data(), &vertex, sizeof(BasicVertex));
+        uint64_t hash = 14695981039346656037ull; // FNV-1a over 32-bit words
+        for (uint32_t word : words) {
+            hash ^= word;
+            hash *= 1099511628211ull;
+        }
+        return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+};
 
+struct BasicVertexEqual {
+    bool operator()(const BasicVertex& a, const BasicVertex& b) const {
+        return std::memcmp(&a, &b, sizeof(BasicVertex)) == 0;
+    }
+};
+
+// Builds an indexed mesh one corner at a time. A corner that has been seen before re-uses the index of the existing vertex.
+class VertexWelder {
+public:
+    VertexWelder(size_t numCornersHint) {
+        uniqueVertices.reserve(numCornersHint);
+        mesh.indices.reserve(numCornersHint);
+    }
 
-// OBJ file is a compressed format. For each attribute it has indices. for example only one color value is stored if all vertices has the same color etc.
-// However, vertices sent to the GPU have unique combination of attributes. Therefore it's better to JOIN all attributes for each individual vertex.
-// LoadOBJ decompress OBJ into a vector of Vertex.
-std::vector<BasicVertex> LoadOBJ(const std::string& filepath) { // taken from https://github.com/tinyobjloader/tinyobjloader and modified
-    tinyobj::ObjReaderConfig reader_config;
-    tinyobj::ObjReader reader;
-    if (!reader.ParseFromFile(filepath, reader_config)) {
-        if (!reader.Error().empty()) {
-            Log::Error("TinyObjReader: {}", reader.Error());
-        }
+    void AddCorner(const BasicVertex& vertex) {
+        auto [it, isNew] = uniqueVertices.try_emplace(vertex, (unsigned int)mesh.vertices.size());
+        if (isNew) { mesh.vertices.push_back(vertex); }
+        mesh.indices.push_back(it->second);
+    }
+
+    MeshData mesh;
+private:
+    std::unordered_map<BasicVertex, unsigned int, BasicVertexHash, BasicVertexEqual> uniqueVertices;
+};
+
+std::vector<unsigned int> RemapPositions(const std::vector<BasicVertex>& vertices) {
+    std::vector<unsigned int> order(vertices.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto lessPosition = [&](unsigned int a, unsigned int b) {
+        const glm::vec3& pa = vertices[a].position;
+        const glm::vec3& pb = vertices[b].position;
+        if (pa.x != pb.x) { return pa.x < pb.x; }
+        if (pa.y != pb.y) { return pa.y < pb.y; }
+        if (pa.z != pb.z) { return pa.z < pb.z; }
+        return a < b;
+    };
+    std::sort(order.begin(), order.end(), lessPosition);
+    std::vector<unsigned int> remap(vertices.size());
+    for (size_t ix = 0; ix < order.size(); ix++) {
+        bool isSameAsPrevious = ix > 0 && vertices[order[ix]].position == vertices[order[ix - 1]].position;
+        remap[order[ix]] = isSameAsPrevious ? remap[order[ix - 1]] : order[ix];
     }
-    if (!reader.Warning().empty()) {
-        Log::Warning("TinyObjReader: {}", reader.Warning());
+    return remap;
+}
+
+BoundingBox ComputeBoundingBox(const BasicVertex* vertices, size_t numVertices) {
+    BoundingBox box;
+    if (numVertices == 0) { return box; }
+    box.min = vertices[0].position;
+    box.max = box.min;
+    for (size_t ix = 0; ix < numVertices; ix++) {
+        box.min = glm::min(box.min, vertices[ix].position);
+        box.max = glm::max(box.max, vertices[ix].position);
     }
+    return box;
+}
 
-    auto& attrib = reader.GetAttrib();
-    auto& shapes = reader.GetShapes();
-    if (shapes.size() != 1) {
-        Log::Warning("Number of shapes in OBJ file is not equal to 1, but {}", shapes.size());
+BoundingSphere ComputeBoundingSphere(const BasicVertex* vertices, size_t numVertices) {
+    BoundingSphere sphere;
+    if (numVertices == 0) { return sphere; }
+    const BoundingBox box = ComputeBoundingBox(vertices, numVertices);
+    sphere.center = (box.min + box.max) * 0.5f;
+    for (size_t ix = 0; ix < numVertices; ix++) {
+        sphere.radius = std::max(sphere.radius, glm::length(vertices[ix].position - sphere.center));
     }
-    auto& materials = reader.GetMaterials();
-    //const tinyobj::shape_t& shape = shapes[0];
-    //const tinyobj::mesh_t& mesh = shape.mesh;
-    //for (auto index : mesh.indices) Log::Debug("Indices: vertex {}, normal {}, texture {}", index.vertex_index, index.normal_index, index.texcoord_index);
-
-    std::vector<BasicVertex> vertices;
-
-    // Loop over shapes
-    for (size_t s = 0; s < shapes.size(); s++) {
-        // Loop over faces(polygon)
-        size_t index_offset = 0;
-        for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
-            size_t fv = size_t(shapes[s].mesh.num_face_vertices[f]);
-
-            // Loop over vertices in the face.
-            for (size_t v = 0; v < fv; v++) {
-                BasicVertex vertex;
-
-                // access to vertex
-                tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-                tinyobj::real_t vx = attrib.vertices[3 * size_t(idx.vertex_index) + 0];
-                tinyobj::real_t vy = attrib.vertices[3 * size_t(idx.vertex_index) + 1];
-                tinyobj::real_t vz = attrib.vertices[3 * size_t(idx.vertex_index) + 2];
-                vertex.position = { vx, vy, vz };
-                //Log::Info("Vertex[{}] = ({}, {}, {})", idx.vertex_index, vx, vy, vz);
-
-                // Check if `normal_index` is zero or positive. negative = no normal data
-                if (idx.normal_index >= 0) {
-                    tinyobj::real_t nx = attrib.normals[3 * size_t(idx.normal_index) + 0];
-                    tinyobj::real_t ny = attrib.normals[3 * size_t(idx.normal_index) + 1];
-                    tinyobj::real_t nz = attrib.normals[3 * size_t(idx.normal_index) + 2];
-                    vertex.normal = { nx, ny, nz };
-                }
-
-                // Check if `texcoord_index` is zero or positive. negative = no texcoord data
-                if (idx.texcoord_index >= 0) {
-                    tinyobj::real_t tx = attrib.texcoords[2 * size_t(idx.texcoord_index) + 0];
-                    tinyobj::real_t ty = attrib.texcoords[2 * size_t(idx.texcoord_index) + 1];
-                    vertex.texCoord = { tx, ty };
-                }
-
-                // Blender does not export vertex color. For now will keep color attribute commented out.
-                /*if (attrib.colors.size() > 0) {
-                    tinyobj::real_t red = attrib.colors[3 * size_t(idx.vertex_index) + 0];
-                    tinyobj::real_t green = attrib.colors[3 * size_t(idx.vertex_index) + 1];
-                    tinyobj::real_t blue = attrib.colors[3 * size_t(idx.vertex_index) + 2];
-                    // alpha?
-                    vertex.color = { red, green, blue, 1.0 };
-                }*/
-                vertices.push_back(vertex);
-
-                //Log::Debug("vertex: ({} {} {}), ({} {} {}), ({} {}), ({} {} {} {})",
-                //    vertex.position.x, vertex.position.y, vertex.position.z,
-                //    vertex.normal.x, vertex.normal.y, vertex.normal.z,
-                //    vertex.texCoord.x, vertex.texCoord.y,
-                //    vertex.color.r, vertex.color.g, vertex.color.b, vertex.color.a
-                //);
-            }
-            index_offset += fv;
-
-            // per-face material
-            //shapes[s].mesh.material_ids[f];
-        }
+    return sphere;
+}
+
+// OBJ file is a compressed format. For each attribute it has indices. for example only one color value is stored if all vertices has the same color etc.
+// However, vertices sent to the GPU have unique combination of attributes. Therefore it's better to JOIN all attributes for each individual vertex.
+// LoadOBJ decompress OBJ into a vector of Vertex, and welds corners that ended up with the same attributes, so that shared vertices are stored once.
+MeshData LoadOBJ(const std::string& filepath, unsigned int numThreads) {
+    ObjData obj;
+    if (!ParseOBJ(filepath, obj, numThreads)) { return {}; }
+
+    VertexWelder welder(obj.corners.size());
+    for (const ObjCorner& corner : obj.corners) {
+        BasicVertex vertex;
+        vertex.position = obj.positions[corner.position];
+        // negative index = no normal/texcoord data
+        if (corner.normal >= 0) { vertex.normal = obj.normals[corner.normal]; }
+        if (corner.texCoord >= 0) { vertex.texCoord = obj.texCoords[corner.texCoord]; }
+        // Blender does not export vertex color. Only files with "v x y z r g b" lines have them.
+        if (!obj.colors.empty()) { vertex.color = glm::vec4(obj.colors[corner.position], 1.0f); }
+        welder.AddCorner(vertex);
     }
-    return vertices; // apparently this is move semantics, i.e. locally created vector will be moved to the scope of the caller.
+    Log::Debug("OBJ {}: {} corners welded into {} vertices", filepath, obj.corners.size(), welder.mesh.vertices.size());
+    MeshData mesh = std::move(welder.mesh);
+    GenerateLods(mesh);
+    OptimizeMesh(mesh, filepath);
+    return mesh;
 }
 
 
-std::vector<BasicVertex> GenerateBox(glm::vec3 dimensions) {
+MeshData GenerateBox(glm::vec3 dimensions) {
     glm::vec3 halfDim = dimensions * 0.5f;
     float width = halfDim.x, height = halfDim.y, depth = halfDim.z;
 
@@ -128,23 +153,29 @@ std::vector<BasicVertex> GenerateBox(glm::vec3 dimensions) {
     Face fUp = { { p010, p011, p111, p110 }, nUp };
     Face fDown = { { p100, p101, p001, p000 }, nDown };
 
-    std::vector<BasicVertex> vertices;
-    int indices[] = { 0, 1, 2,    // triangle 1 of quad
-                      0, 2, 3, }; // triangle 2 of quad
+    MeshData mesh;
+    unsigned int quadIndices[] = { 0, 1, 2,    // triangle 1 of quad
+                                   0, 2, 3, }; // triangle 2 of quad
     glm::vec2 uvs[] = { {0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f} };
     for (auto& face : { fBack, fFront, fLeft, fRight, fUp, fDown }) {
-        for (int ix : indices) {
+        unsigned int faceStart = (unsigned int)mesh.vertices.size();
+        for (int ix = 0; ix < 4; ix++) {
             const Vertex& v = face.corners[ix];
-            vertices.emplace_back<BasicVertex>(
+            mesh.vertices.emplace_back<BasicVertex>(
                 { v.position, face.normal, uvs[ix], v.color, }
             );
         }
+        for (unsigned int ix : quadIndices) {
+            mesh.indices.push_back(faceStart + ix);
+        }
     }
-    return vertices;
+    OptimizeMesh(mesh, "Box");
+    return mesh;
 }
 
-std::vector<BasicVertex> GenerateTorus(float outerRadius, int outerSegments, float innerRadius, int innerSegments) {
-    std::vector<BasicVertex> points;
+MeshData GenerateTorus(float outerRadius, int outerSegments, float innerRadius, int innerSegments) {
+    MeshData mesh;
+    std::vector<BasicVertex>& points = mesh.vertices;
     for (int i = 0; i < outerSegments; i++) {
         float u = (float)i / (outerSegments - 1);
         float outerAngle = Math::TAU * u;
@@ -164,25 +195,25 @@ std::vector<BasicVertex> GenerateTorus(float outerRadius, int outerSegments, flo
         }
     }
 
-    std::vector<BasicVertex> vertices;
-    for (size_t i = 0; i < outerSegments; i++) {
-        for (size_t j = 0; j < innerSegments; j++) {
-            size_t i1 = (i + 1) % outerSegments;
-            size_t j1 = (j + 1) % innerSegments;
-            const BasicVertex& p1 = points[i * innerSegments + j];
-            const BasicVertex& p2 = points[i * innerSegments + j1];
-            const BasicVertex& p3 = points[i1 * innerSegments + j];
-            const BasicVertex& p4 = points[i1 * innerSegments + j1];
-            vertices.push_back(p3); // triangle-1
-            vertices.push_back(p2);
-            vertices.push_back(p1);
-
-            vertices.push_back(p2); // triangle-2
-            vertices.push_back(p3);
-            vertices.push_back(p4);
+    std::vector<unsigned int>& indices = mesh.indices;
+    indices.reserve((size_t)outerSegments * innerSegments * 6);
+    for (unsigned int i = 0; i < (unsigned int)outerSegments; i++) {
+        for (unsigned int j = 0; j < (unsigned int)innerSegments; j++) {
+            unsigned int i1 = (i + 1) % outerSegments;
+            unsigned int j1 = (j + 1) % innerSegments;
+            unsigned int p1 = i * innerSegments + j;
+            unsigned int p2 = i * innerSegments + j1;
+            unsigned int p3 = i1 * innerSegments + j;
+            unsigned int p4 = i1 * innerSegments + j1;
+            indices.push_back(p3); // triangle-1
+            indices.push_back(p2);
+            indices.push_back(p1);
+
+            indices.push_back(p2); // triangle-2
+            indices.push_back(p3);
+            indices.push_back(p4);
         }
     }
-    
-    return vertices;
+    OptimizeMesh(mesh, "Torus");
+    return mesh;
 }
-;
@@ -4,6 +4,7 @@
 
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -22,7 +23,51 @@ static std::vector<VertexAttributeSpecification> BasicVertexAttributeSpecs = {
     VertexAttributeSpecification{ 3, VertexAttributeSemantic::Color, VertexAttributeType::float32, 4, false},
 };
 
-std::vector<BasicVertex> LoadOBJ(const std::string& filepath);
+// A range of indices that draws the mesh at some level of detail
+struct MeshLod {
+    uint32_t indexOffset = 0;
+    uint32_t indexCount = 0;
+    float error = 0.0f; // how far simplified surface can be from the original one, in model space units
+};
+
+struct BoundingBox {
+    glm::vec3 min = { -0.5f, -0.5f, -0.5f };
+    glm::vec3 max = { 0.5f, 0.5f, 0.5f };
+};
+
+struct BoundingSphere {
+    glm::vec3 center = { 0.0f, 0.0f, 0.0f };
+    float radius = 0.0f;
+};
+
+// Cluster of at most maxMeshletVertices unique vertices and maxMeshletTriangles consecutive triangles of a mesh, culled as a whole.
+struct Meshlet {
+    uint32_t indexOffset = 0;
+    uint32_t indexCount = 0;
+    BoundingSphere bounds; // in model space
+    // All triangle normals are within the cone around coneAxis. coneCutoff is the sine of its half-angle, 1 when the cone is too wide to cull with.
+    glm::vec3 coneAxis = { 0.0f, 0.0f, 0.0f };
+    float coneCutoff = 1.0f;
+};
+
+// Indexed triangle mesh. Each unique vertex is stored once and triangles refer to them via indices.
+struct MeshData {
+    std::vector<BasicVertex> vertices;
+    std::vector<unsigned int> indices;
+    // When not empty, indices is a concatenation of LODs all referring to the same vertices. LOD 0 is the full mesh.
+    std::vector<MeshLod> lods;
+    // Ranges of indices covering each LOD (or the whole mesh when there are no LODs), sorted by indexOffset
+    std::vector<Meshlet> meshlets;
+};
+
+MeshData LoadOBJ(const std::string& filepath, unsigned int numThreads = 0); // numThreads of ParseOBJ
+
+MeshData GenerateBox(glm::vec3 dimensions);
+MeshData GenerateTorus(float outerRadius, int outerSegments, float innerRadius, int innerSegments);
+
+BoundingBox ComputeBoundingBox(const BasicVertex* vertices, size_t numVertices);
+// Sphere around the center of the bounding box of the vertices. Not the tightest, but cheap.
+BoundingSphere ComputeBoundingSphere(const BasicVertex* vertices, size_t numVertices);
 
-std::vector<BasicVertex> GenerateBox(glm::vec3 dimensions);
-std::vector<BasicVertex> GenerateTorus(float outerRadius, int outerSegments, float innerRadius, int innerSegments);
\ No newline at end of file
+// Maps each vertex to the lowest index vertex with the same position. Vertices with different normals or UVs at the same position form seams.
+std::vector<unsigned int> RemapPositions(const std::vector<BasicVertex>& vertices);
\ No newline at end of file
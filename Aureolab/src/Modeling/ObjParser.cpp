@@ -0,0 +1,259 @@
+#include "ObjParser.h"
+
+#include "Core/Log.h"
+#include "Core/MappedFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <charconv>
+#include <cstring>
+#include <thread>
+
+// Faces can refer to attributes relative to the end of the attribute list so far, e.g. "f -3 -2 -1".
+// A chunk does not know how many attributes were defined in chunks before it. Such indices are stored relative to the start of the chunk and fixed while merging.
+enum RelativeIndexFlags : uint8_t {
+	RelativePosition = 1 << 0,
+	RelativeTexCoord = 1 << 1,
+	RelativeNormal = 1 << 2,
+};
+
+struct ObjChunk {
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> colors; // one per position, white when not given
+	bool hasColors = false;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> texCoords;
+	std::vector<ObjCorner> corners;
+	std::vector<uint8_t> relativeFlags; // one per corner
+};
+
+// Runs func(ix) for ix in [0, count), each on its own thread. The first one runs on the calling thread.
+template <typename TFunc>
+static void RunInParallel(unsigned int count, TFunc func) {
+	std::vector<std::thread> threads;
+	threads.reserve(count);
+	for (unsigned int ix = 1; ix < count; ix++) {
+		threads.emplace_back(func, ix);
+	}
+	if (count > 0) { func(0); }
+	for (auto& thread : threads) { thread.join(); }
+}
+
+static void SkipSpaces(const char*& cursor, const char* end) {
+	while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) { cursor++; }
+}
+
+static bool ParseFloat(const char*& cursor, const char* end, float& value) {
+	SkipSpaces(cursor, end);
+	if (cursor < end && *cursor == '+') { cursor++; } // from_chars does not accept a leading plus sign
+	auto [next, error] = std::from_chars(cursor, end, value);
+	if (error != std::errc()) { return false; }
+	cursor = next;
+	return true;
+}
+
+static bool ParseInt(const char*& cursor, const char* end, int& value) {
+	if (cursor < end && *cursor == '+') { cursor++; }
+	auto [next, error] = std::from_chars(cursor, end, value);
+	if (error != std::errc()) { return false; }
+	cursor = next;
+	return true;
+}
+
+// Converts a 1-based (or negative, relative) OBJ index into a 0-based index. Relative ones are converted to chunk-local indices.
+static int ResolveIndex(int objIndex, size_t numDefinedInChunk, uint8_t relativeFlag, uint8_t& flags) {
+	if (objIndex > 0) { return objIndex - 1; }
+	if (objIndex < 0) {
+		flags |= relativeFlag;
+		return (int)numDefinedInChunk + objIndex;
+	}
+	return -1; // 0 is not a valid OBJ index
+}
+
+// Parses a corner written as "v", "v/vt", "v//vn" or "v/vt/vn"
+static bool ParseCorner(const char*& cursor, const char* end, const ObjChunk& chunk, ObjCorner& corner, uint8_t& flags) {
+	int index;
+	if (!ParseInt(cursor, end, index)) { return false; }
+	corner.position = ResolveIndex(index, chunk.positions.size(), RelativePosition, flags);
+	if (cursor < end && *cursor == '/') {
+		cursor++;
+		if (cursor < end && *cursor != '/') {
+			if (!ParseInt(cursor, end, index)) { return false; }
+			corner.texCoord = ResolveIndex(index, chunk.texCoords.size(), RelativeTexCoord, flags);
+		}
+		if (cursor < end && *cursor == '/') {
+			cursor++;
+			if (!ParseInt(cursor, end, index)) { return false; }
+			corner.normal = ResolveIndex(index, chunk.normals.size(), RelativeNormal, flags);
+		}
+	}
+	return true;
+}
+
+static void ParseChunk(const char* begin, const char* end, ObjChunk& chunk) {
+	// rough guesses to avoid most of the re-allocations. An OBJ line is ~30 bytes.
+	size_t numLinesGuess = (end - begin) / 30;
+	chunk.positions.reserve(numLinesGuess / 3);
+	chunk.colors.reserve(numLinesGuess / 3);
+	chunk.corners.reserve(numLinesGuess * 3);
+	chunk.relativeFlags.reserve(numLinesGuess * 3);
+
+	std::vector<ObjCorner> polygon;
+	std::vector<uint8_t> polygonFlags;
+	const char* lineStart = begin;
+	while (lineStart < end) {
+		const char* lineEnd = (const char*)std::memchr(lineStart, '\n', end - lineStart);
+		if (lineEnd == nullptr) { lineEnd = end; }
+		const char* cursor = lineStart;
+		lineStart = lineEnd + 1;
+
+		SkipSpaces(cursor, lineEnd);
+		if (lineEnd - cursor < 2) { continue; }
+		if (cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+			cursor += 2;
+			float values[7];
+			int numValues = 0;
+			while (numValues < 7 && ParseFloat(cursor, lineEnd, values[numValues])) { numValues++; }
+			if (numValues < 3) { continue; }
+			chunk.positions.push_back({ values[0], values[1], values[2] });
+			// 6 values: x y z r g b, 7 values: x y z w r g b
+			if (numValues >= 6) {
+				chunk.colors.push_back({ values[numValues - 3], values[numValues - 2], values[numValues - 1] });
+				chunk.hasColors = true;
+			}
+			else {
+				chunk.colors.push_back({ 1.0f, 1.0f, 1.0f });
+			}
+		}
+		else if (cursor[0] == 'v' && cursor[1] == 'n') {
+			cursor += 2;
+			glm::vec3 normal;
+			if (ParseFloat(cursor, lineEnd, normal.x) && ParseFloat(cursor, lineEnd, normal.y) && ParseFloat(cursor, lineEnd, normal.z)) {
+				chunk.normals.push_back(normal);
+			}
+		}
+		else if (cursor[0] == 'v' && cursor[1] == 't') {
+			cursor += 2;
+			glm::vec2 texCoord;
+			if (ParseFloat(cursor, lineEnd, texCoord.x)) {
+				if (!ParseFloat(cursor, lineEnd, texCoord.y)) { texCoord.y = 0.0f; }
+				chunk.texCoords.push_back(texCoord);
+			}
+		}
+		else if (cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+			cursor += 2;
+			polygon.clear();
+			polygonFlags.clear();
+			while (true) {
+				SkipSpaces(cursor, lineEnd);
+				if (cursor >= lineEnd) { break; }
+				ObjCorner corner;
+				uint8_t flags = 0;
+				if (!ParseCorner(cursor, lineEnd, chunk, corner, flags)) { break; }
+				polygon.push_back(corner);
+				polygonFlags.push_back(flags);
+			}
+			// triangulate as a fan around the first corner
+			for (size_t ix = 1; ix + 1 < polygon.size(); ix++) {
+				for (size_t c : { (size_t)0, ix, ix + 1 }) {
+					chunk.corners.push_back(polygon[c]);
+					chunk.relativeFlags.push_back(polygonFlags[c]);
+				}
+			}
+		}
+	}
+}
+
+// Splits [data, data + size) into numChunks ranges that end on line boundaries.
+static std::vector<const char*> SplitIntoChunks(const char* data, size_t size, unsigned int numChunks) {
+	const char* end = data + size;
+	std::vector<const char*> boundaries = { data };
+	for (unsigned int ix = 1; ix < numChunks; ix++) {
+		const char* boundary = std::max(data + size * ix / numChunks, boundaries.back());
+		const char* newline = (const char*)std::memchr(boundary, '\n', end - boundary);
+		boundaries.push_back(newline == nullptr ? end : newline + 1);
+	}
+	boundaries.push_back(end);
+	return boundaries;
+}
+
+bool ParseOBJ(const std::string& filepath, ObjData& obj, unsigned int numThreads) {
+	auto startTime = std::chrono::steady_clock::now();
+	MappedFile* file = MappedFile::Open(filepath);
+	if (file == nullptr) {
+		Log::Error("Cannot open OBJ file {}", filepath);
+		return false;
+	}
+	const char* data = (const char*)file->GetData();
+	const size_t size = file->GetSize();
+
+	const size_t minChunkSize = 1 << 20; // below this, the cost of starting a thread is more than parsing the chunk
+	if (numThreads == 0) { numThreads = std::max(std::thread::hardware_concurrency(), 1u); }
+	const unsigned int numChunks = (unsigned int)std::clamp<size_t>(size / minChunkSize, 1, numThreads);
+	std::vector<const char*> boundaries = SplitIntoChunks(data, size, numChunks);
+
+	std::vector<ObjChunk> chunks(numChunks);
+	RunInParallel(numChunks, [&](unsigned int ix) { ParseChunk(boundaries[ix], boundaries[ix + 1], chunks[ix]); });
+	delete file;
+
+	// Offsets of each chunk in the merged arrays
+	struct Offsets { size_t positions = 0, normals = 0, texCoords = 0, corners = 0; };
+	std::vector<Offsets> offsets(numChunks + 1);
+	bool hasColors = false;
+	for (unsigned int ix = 0; ix < numChunks; ix++) {
+		offsets[ix + 1].positions = offsets[ix].positions + chunks[ix].positions.size();
+		offsets[ix + 1].normals = offsets[ix].normals + chunks[ix].normals.size();
+		offsets[ix + 1].texCoords = offsets[ix].texCoords + chunks[ix].texCoords.size();
+		offsets[ix + 1].corners = offsets[ix].corners + chunks[ix].corners.size();
+		hasColors |= chunks[ix].hasColors;
+	}
+	const Offsets& totals = offsets[numChunks];
+	obj.positions.resize(totals.positions);
+	obj.colors.resize(hasColors ? totals.positions : 0);
+	obj.normals.resize(totals.normals);
+	obj.texCoords.resize(totals.texCoords);
+	obj.corners.resize(totals.corners);
+
+	std::vector<size_t> numInvalidCorners(numChunks, 0);
+	RunInParallel(numChunks, [&](unsigned int ix) {
+		ObjChunk& chunk = chunks[ix];
+		const Offsets& offset = offsets[ix];
+		std::copy(chunk.positions.begin(), chunk.positions.end(), obj.positions.begin() + offset.positions);
+		if (hasColors) { std::copy(chunk.colors.begin(), chunk.colors.end(), obj.colors.begin() + offset.positions); }
+		std::copy(chunk.normals.begin(), chunk.normals.end(), obj.normals.begin() + offset.normals);
+		std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), obj.texCoords.begin() + offset.texCoords);
+
+		auto resolve = [](int index, bool isRelative, size_t chunkOffset, size_t total) {
+			long long global = isRelative ? (long long)chunkOffset + index : index;
+			return (global >= 0 && global < (long long)total) ? (int)global : -1;
+		};
+		for (size_t c = 0; c < chunk.corners.size(); c++) {
+			ObjCorner corner = chunk.corners[c];
+			uint8_t flags = chunk.relativeFlags[c];
+			corner.position = resolve(corner.position, flags & RelativePosition, offset.positions, totals.positions);
+			if (corner.texCoord != -1 || (flags & RelativeTexCoord)) { corner.texCoord = resolve(corner.texCoord, flags & RelativeTexCoord, offset.texCoords, totals.texCoords); }
+			if (corner.normal != -1 || (flags & RelativeNormal)) { corner.normal = resolve(corner.normal, flags & RelativeNormal, offset.normals, totals.normals); }
+			if (corner.position == -1) { numInvalidCorners[ix]++; }
+			obj.corners[offset.corners + c] = corner;
+		}
+		chunk = ObjChunk{}; // release chunk memory as soon as possible
+	});
+
+	// Drop triangles that refer to non-existent positions
+	size_t numInvalid = 0;
+	for (size_t n : numInvalidCorners) { numInvalid += n; }
+	if (numInvalid > 0) {
+		Log::Warning("OBJ {} has faces with invalid vertex indices. Dropping them.", filepath);
+		size_t numKept = 0;
+		for (size_t t = 0; t < obj.corners.size(); t += 3) {
+			if (obj.corners[t].position == -1 || obj.corners[t + 1].position == -1 || obj.corners[t + 2].position == -1) { continue; }
+			std::copy_n(obj.corners.begin() + t, 3, obj.corners.begin() + numKept);
+			numKept += 3;
+		}
+		obj.corners.resize(numKept);
+	}
+
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+	Log::Debug("Parsed OBJ {} ({} bytes) in {} chunks in {} ms: {} positions, {} triangles", filepath, size, numChunks, duration.count(), obj.positions.size(), obj.corners.size() / 3);
+	return true;
+}
\ No newline at end of file
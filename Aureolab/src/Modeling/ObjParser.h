@@ -0,0 +1,30 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// One corner of a triangle. Indices are 0-based into ObjData's arrays, -1 when the attribute is not given.
+struct ObjCorner {
+	int position = -1;
+	int texCoord = -1;
+	int normal = -1;
+};
+
+// Geometry of an OBJ file as it is written in the file, i.e. attributes are indexed separately.
+struct ObjData {
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> colors; // from the non-standard "v x y z r g b" extension. Either empty or the same size as positions.
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> texCoords;
+	std::vector<ObjCorner> corners; // 3 per triangle. Polygons are triangulated as fans.
+};
+
+/*
+* Parses v/vn/vt/f records of an OBJ file. Other records (o, g, s, usemtl, mtllib, l, p etc.) are ignored.
+* The file is memory mapped and split into chunks on line boundaries which are parsed on parallel threads.
+* Chunk results are merged in file order, so the output does not depend on the number of threads.
+* numThreads = 0 picks the number of hardware threads. Small files are parsed on a single thread.
+*/
+bool ParseOBJ(const std::string& filepath, ObjData& obj, unsigned int numThreads = 0);
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "VertexPacking.h"
+
+#include "Core/Log.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+static_assert(sizeof(PackedVertex) == 24, "PackedVertex has to match PackedVertexAttributeSpecs");
+static_assert(sizeof(QuantizedVertex) == 20, "QuantizedVertex has to match QuantizedVertexAttributeSpecs");
+
+const std::vector<VertexAttributeSpecification>& GetVertexAttributeSpecs(VertexFormat format) {
+	switch (format) {
+	case VertexFormat::Basic:
+		return BasicVertexAttributeSpecs;
+	case VertexFormat::Packed:
+		return PackedVertexAttributeSpecs;
+	case VertexFormat::PackedQuantized:
+		return QuantizedVertexAttributeSpecs;
+	default:
+		assert(false); // unknown vertex format
+		return BasicVertexAttributeSpecs;
+	}
+}
+
+static float SignNotZero(float value) { return value >= 0.0f ? 1.0f : -1.0f; }
+
+glm::vec2 EncodeOctahedral(const glm::vec3& normal) {
+	float l1Norm = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	if (l1Norm == 0.0f) { return { 0.0f, 0.0f }; } // meshes without normals
+	glm::vec3 n = normal / l1Norm;
+	if (n.z >= 0.0f) { return { n.x, n.y }; }
+	return { (1.0f - std::abs(n.y)) * SignNotZero(n.x), (1.0f - std::abs(n.x)) * SignNotZero(n.y) };
+}
+
+glm::vec3 DecodeOctahedral(const glm::vec2& encoded) {
+	glm::vec3 n = { encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y) };
+	if (n.z < 0.0f) {
+		n.x = (1.0f - std::abs(encoded.y)) * SignNotZero(encoded.x);
+		n.y = (1.0f - std::abs(encoded.x)) * SignNotZero(encoded.y);
+	}
+	return glm::normalize(n);
+}
+
+// Attributes PackedVertex and QuantizedVertex have in common
+template <typename TVertex>
+static void PackAttributes(const BasicVertex& vertex, TVertex& packed) {
+	glm::vec2 normal = EncodeOctahedral(vertex.normal);
+	packed.normal[0] = (int16_t)glm::packSnorm1x16(normal.x);
+	packed.normal[1] = (int16_t)glm::packSnorm1x16(normal.y);
+	packed.texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+	packed.texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+	uint32_t color = glm::packUnorm4x8(vertex.color); // red in the lowest byte
+	std::memcpy(packed.color, &color, sizeof(color));
+}
+
+PackedVertices PackVertices(const BasicVertex* vertices, size_t numVertices, VertexFormat format) {
+	PackedVertices result;
+	result.format = format;
+	switch (format) {
+	case VertexFormat::Basic:
+		result.basic.assign(vertices, vertices + numVertices);
+		break;
+	case VertexFormat::Packed: {
+		result.packed.resize(numVertices);
+		for (size_t ix = 0; ix < numVertices; ix++) {
+			result.packed[ix].position = vertices[ix].position;
+			PackAttributes(vertices[ix], result.packed[ix]);
+		}
+		result.decoding.octahedralNormals = true;
+		break;
+	}
+	case VertexFormat::PackedQuantized: {
+		glm::vec3 min = numVertices > 0 ? vertices[0].position : glm::vec3{ 0.0f, 0.0f, 0.0f };
+		glm::vec3 max = min;
+		for (size_t ix = 0; ix < numVertices; ix++) {
+			min = glm::min(min, vertices[ix].position);
+			max = glm::max(max, vertices[ix].position);
+		}
+		const glm::vec3 extent = max - min;
+		result.quantized.resize(numVertices);
+		for (size_t ix = 0; ix < numVertices; ix++) {
+			for (int c = 0; c < 3; c++) {
+				float normalized = extent[c] > 0.0f ? (vertices[ix].position[c] - min[c]) / extent[c] : 0.0f;
+				result.quantized[ix].position[c] = glm::packUnorm1x16(normalized);
+			}
+			result.quantized[ix].position[3] = 0;
+			PackAttributes(vertices[ix], result.quantized[ix]);
+		}
+		result.decoding.positionOffset = min;
+		result.decoding.positionScale = extent;
+		result.decoding.octahedralNormals = true;
+		break;
+	}
+	}
+	return result;
+}
+
+void PackedVertices::Upload(VertexBuffer& vbo) const {
+	switch (format) {
+	case VertexFormat::Basic:
+		vbo.SetVertices(basic);
+		break;
+	case VertexFormat::Packed:
+		vbo.SetVertices(packed);
+		break;
+	case VertexFormat::PackedQuantized:
+		vbo.SetVertices(quantized);
+		break;
+	}
+	Log::Debug("Uploaded {} vertices in {} format, {} bytes each", vbo.GetNumVertices(), vertexFormatNames[(int)format], vbo.GetVertexSize());
+}
+
+VertexDecoding UploadPackedVertices(VertexBuffer& vbo, const BasicVertex* vertices, size_t numVertices, VertexFormat format) {
+	if (format == VertexFormat::Basic) {
+		vbo.SetVertices(vertices, numVertices); // no conversion needed, skip the copy
+		Log::Debug("Uploaded {} vertices in {} format, {} bytes each", numVertices, vertexFormatNames[(int)format], vbo.GetVertexSize());
+		return VertexDecoding{};
+	}
+	PackedVertices packed = PackVertices(vertices, numVertices, format);
+	packed.Upload(vbo);
+	return packed.decoding;
+}
\ No newline at end of file
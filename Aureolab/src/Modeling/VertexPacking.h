@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Modeling.h"
+#include "Renderer/MeshAsset.h"
+
+#include <cstdint>
+#include <vector>
+
+// Compact alternatives to BasicVertex. Attribute locations are the same, so shaders read them as the same inputs and only decode position and normal.
+struct PackedVertex {
+	glm::vec3 position;
+	int16_t normal[2]; // octahedral encoding, snorm16
+	uint16_t texCoord[2]; // half floats, so that tiling UVs outside of [0, 1] survive
+	uint8_t color[4]; // unorm8
+};
+
+struct QuantizedVertex {
+	uint16_t position[4]; // unorm16 relative to the bounding box of the mesh. 4th component is padding.
+	int16_t normal[2];
+	uint16_t texCoord[2];
+	uint8_t color[4];
+};
+
+// To be in sync with PackedVertex and the decoding in shaders
+static std::vector<VertexAttributeSpecification> PackedVertexAttributeSpecs = {
+	VertexAttributeSpecification{ 0, VertexAttributeSemantic::Position, VertexAttributeType::float32, 3, false},
+	VertexAttributeSpecification{ 1, VertexAttributeSemantic::Normal, VertexAttributeType::int16, 2, true},
+	VertexAttributeSpecification{ 2, VertexAttributeSemantic::UV, VertexAttributeType::float16, 2, false},
+	VertexAttributeSpecification{ 3, VertexAttributeSemantic::Color, VertexAttributeType::uint8, 4, true},
+};
+
+// To be in sync with QuantizedVertex and the decoding in shaders
+static std::vector<VertexAttributeSpecification> QuantizedVertexAttributeSpecs = {
+	VertexAttributeSpecification{ 0, VertexAttributeSemantic::Position, VertexAttributeType::uint16, 4, true},
+	VertexAttributeSpecification{ 1, VertexAttributeSemantic::Normal, VertexAttributeType::int16, 2, true},
+	VertexAttributeSpecification{ 2, VertexAttributeSemantic::UV, VertexAttributeType::float16, 2, false},
+	VertexAttributeSpecification{ 3, VertexAttributeSemantic::Color, VertexAttributeType::uint8, 4, true},
+};
+
+const std::vector<VertexAttributeSpecification>& GetVertexAttributeSpecs(VertexFormat format);
+
+// Maps a unit vector onto [-1, 1]^2 by projecting it onto an octahedron and unfolding the lower half.
+glm::vec2 EncodeOctahedral(const glm::vec3& normal);
+glm::vec3 DecodeOctahedral(const glm::vec2& encoded);
+
+// Vertices converted into a VertexFormat, kept in the vector matching it. Lets conversion happen away from the thread that uploads.
+struct PackedVertices {
+	VertexFormat format = VertexFormat::Basic;
+	std::vector<BasicVertex> basic;
+	std::vector<PackedVertex> packed;
+	std::vector<QuantizedVertex> quantized;
+	VertexDecoding decoding;
+
+	// vbo has to be created with GetVertexAttributeSpecs(format)
+	void Upload(VertexBuffer& vbo) const;
+};
+
+PackedVertices PackVertices(const BasicVertex* vertices, size_t numVertices, VertexFormat format);
+
+// Converts vertices into given format and uploads them into vbo, which has to be created with GetVertexAttributeSpecs(format).
+// Returns the parameters shaders need to decode them.
+VertexDecoding UploadPackedVertices(VertexBuffer& vbo, const BasicVertex* vertices, size_t numVertices, VertexFormat format);
\ No newline at end of file
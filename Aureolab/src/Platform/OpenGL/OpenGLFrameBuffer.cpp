@@ -1,51 +1,79 @@
 #include "OpenGLFrameBuffer.h"
 
+#include "OpenGLGraphicsAPI.h"
 #include "Core/Log.h"
 
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <cassert>
 
-OpenGLFrameBuffer::OpenGLFrameBuffer(int width, int height, TextureFormat textureFormat) 
-		: textureFormat(textureFormat) {
+// Internal format, and format and type of pixel transfers
+struct GLTextureFormat {
+	GLenum internalFormat;
+	GLenum format;
+	GLenum type;
+};
+
+static GLTextureFormat ToGLTextureFormat(FrameBuffer::TextureFormat textureFormat) {
+	switch (textureFormat) {
+	case FrameBuffer::TextureFormat::RGBA8: return { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE };
+	case FrameBuffer::TextureFormat::RED_INTEGER: return { GL_R32I, GL_RED_INTEGER, GL_INT };
+	case FrameBuffer::TextureFormat::RGBA16F: return { GL_RGBA16F, GL_RGBA, GL_FLOAT };
+	case FrameBuffer::TextureFormat::DEPTH24_STENCIL8: return { GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8 };
+	}
+	assert(false); // unknown TextureFormat
+	return { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE };
+}
+
+// Size of a pixel in readbacks, see FrameBuffer::Readback
+static unsigned int GetReadbackPixelSize(FrameBuffer::TextureFormat textureFormat) {
+	return textureFormat == FrameBuffer::TextureFormat::RGBA16F ? 4 * sizeof(float) : 4;
+}
+
+OpenGLFrameBuffer::OpenGLFrameBuffer(const FrameBufferSpec& spec)
+		: spec(spec) {
 	glGenFramebuffers(1, &rendererID);
 
 	Bind();
-	// generate color buffer texture
-	unsigned int colorRendererID;
-	glGenTextures(1, &colorRendererID);
-	glBindTexture(GL_TEXTURE_2D, colorRendererID);
-	switch (textureFormat) {
-	case TextureFormat::RGBA8:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-		break;
-	case TextureFormat::RED_INTEGER:
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32I, width, height, 0, GL_RED_INTEGER, GL_INT, 0);
-		break;
-	default:
-		assert(false); // unknown TextureFormat
+	// generate a texture for each attachment, and attach them to the currently bound framebuffer object
+	const GLenum target = GetTextureTarget();
+	const bool hasSamplerState = spec.samples == 1; // multisampled textures are fetched per sample, without filtering or wrapping
+	for (TextureFormat textureFormat : spec.attachments) {
+		unsigned int textureID;
+		glGenTextures(1, &textureID);
+		glBindTexture(target, textureID);
+		if (textureFormat == TextureFormat::DEPTH24_STENCIL8) {
+			assert(depthRendererID == 0); // at most one depth attachment
+			depthRendererID = textureID;
+			if (hasSamplerState) {
+				glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+				glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+				glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			}
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, target, textureID, 0);
+		}
+		else {
+			// integer textures cannot be filtered
+			const GLint filter = textureFormat == TextureFormat::RED_INTEGER ? GL_NEAREST : GL_LINEAR;
+			if (hasSamplerState) {
+				glTexParameteri(target, GL_TEXTURE_MIN_FILTER, filter);
+				glTexParameteri(target, GL_TEXTURE_MAG_FILTER, filter);
+				glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+				glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+			}
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + (GLenum)colorRendererIDs.size(), target, textureID, 0);
+			colorRendererIDs.push_back(textureID);
+			colorFormats.push_back(textureFormat);
+		}
+		glBindTexture(target, 0);
 	}
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	colorRendererIDs.push_back(colorRendererID);
-
-	// generate depth & stencil buffer texture
-	glGenTextures(1, &depthRendererID);
-	glBindTexture(GL_TEXTURE_2D, depthRendererID);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	// attach them to currently bound framebuffer object
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorRendererID, 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthRendererID, 0);
+	AllocateAttachments();
+	std::vector<unsigned int> allColorAttachments(colorRendererIDs.size());
+	for (unsigned int ix = 0; ix < allColorAttachments.size(); ix++) { allColorAttachments[ix] = ix; }
+	SetDrawAttachments(allColorAttachments);
 
 	// Check FBO completion
 	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
@@ -58,15 +86,22 @@ OpenGLFrameBuffer::OpenGLFrameBuffer(int width, int height, TextureFormat textur
 }
 
 OpenGLFrameBuffer::~OpenGLFrameBuffer() {
-	glDeleteFramebuffers(1, &rendererID);
+	for (PendingReadback& readback : readbacks) {
+		if (readback.fence != nullptr) { glDeleteSync(readback.fence); }
+		if (readback.bufferID != 0) { OpenGLGraphicsAPI::DeleteBuffer(readback.bufferID); }
+	}
+	glDeleteTextures((GLsizei)colorRendererIDs.size(), colorRendererIDs.data());
+	if (depthRendererID != 0) { glDeleteTextures(1, &depthRendererID); }
+	OpenGLGraphicsAPI::DeleteFramebuffer(rendererID);
 }
 
 void OpenGLFrameBuffer::Bind() const {
-	glBindFramebuffer(GL_FRAMEBUFFER, rendererID);
+	OpenGLGraphicsAPI::BindFramebuffer(rendererID);
+	glViewport(0, 0, spec.width, spec.height);
 }
 
 void OpenGLFrameBuffer::Unbind() const {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	OpenGLGraphicsAPI::BindFramebuffer(0);
 }
 
 unsigned int OpenGLFrameBuffer::GetColorAttachmentRendererID(unsigned int index) const {
@@ -75,42 +110,147 @@ unsigned int OpenGLFrameBuffer::GetColorAttachmentRendererID(unsigned int index)
 }
 
 void OpenGLFrameBuffer::Resize(int width, int height) {
+	spec.width = width;
+	spec.height = height;
+	AllocateAttachments();
+}
+
+void OpenGLFrameBuffer::AllocateAttachments() {
+	const GLenum target = GetTextureTarget();
+	auto allocate = [&](unsigned int textureID, TextureFormat textureFormat) {
+		const GLTextureFormat format = ToGLTextureFormat(textureFormat);
+		glBindTexture(target, textureID);
+		if (spec.samples > 1) { glTexImage2DMultisample(target, spec.samples, format.internalFormat, spec.width, spec.height, GL_TRUE); }
+		else { glTexImage2D(target, 0, format.internalFormat, spec.width, spec.height, 0, format.format, format.type, nullptr); }
+	};
+	for (size_t ix = 0; ix < colorRendererIDs.size(); ix++) { allocate(colorRendererIDs[ix], colorFormats[ix]); }
+	if (depthRendererID != 0) { allocate(depthRendererID, TextureFormat::DEPTH24_STENCIL8); }
+	glBindTexture(target, 0);
+}
+
+FrameBuffer::TextureFormat OpenGLFrameBuffer::GetColorAttachmentFormat(unsigned int index) const {
+	assert(index < colorFormats.size()); // attachment with that index does not exist.
+	return colorFormats[index];
+}
+
+void OpenGLFrameBuffer::SetDrawAttachments(const std::vector<unsigned int>& indices) {
+	drawBuffers.clear();
+	for (unsigned int index : indices) {
+		assert(index < colorRendererIDs.size()); // attachment with that index does not exist.
+		drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + index);
+	}
 	Bind();
-	for (unsigned int id : colorRendererIDs) {
-		glBindTexture(GL_TEXTURE_2D, id);
-		switch (textureFormat) {
-		case TextureFormat::RGBA8:
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-			break;
-		case TextureFormat::RED_INTEGER:
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_R32I, width, height, 0, GL_RED_INTEGER, GL_INT, 0);
-			break;
-		}
-		
-		glBindTexture(GL_TEXTURE_2D, 0);
+	if (drawBuffers.empty()) { glDrawBuffer(GL_NONE); }
+	else { glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data()); }
+}
+
+void OpenGLFrameBuffer::ResolveTo(FrameBuffer& target, bool includeColors) const {
+	const OpenGLFrameBuffer& glTarget = static_cast<const OpenGLFrameBuffer&>(target);
+	const int targetWidth = glTarget.spec.width;
+	const int targetHeight = glTarget.spec.height;
+	assert(spec.samples == 1 || (spec.width == targetWidth && spec.height == targetHeight)); // multisampled blits cannot stretch
+	// The named versions leave bindings alone, so the state cache of OpenGLGraphicsAPI stays valid
+	const unsigned int numColorAttachments = includeColors ? std::min(GetNumColorAttachments(), glTarget.GetNumColorAttachments()) : 0;
+	for (unsigned int ix = 0; ix < numColorAttachments; ix++) {
+		glNamedFramebufferReadBuffer(rendererID, GL_COLOR_ATTACHMENT0 + ix);
+		glNamedFramebufferDrawBuffer(glTarget.rendererID, GL_COLOR_ATTACHMENT0 + ix);
+		glBlitNamedFramebuffer(rendererID, glTarget.rendererID, 0, 0, spec.width, spec.height, 0, 0, targetWidth, targetHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 	}
-	glBindTexture(GL_TEXTURE_2D, depthRendererID);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	Unbind();
+	if (depthRendererID != 0 && glTarget.depthRendererID != 0) {
+		glBlitNamedFramebuffer(rendererID, glTarget.rendererID, 0, 0, spec.width, spec.height, 0, 0, targetWidth, targetHeight, GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+	}
+	if (glTarget.drawBuffers.empty()) { glNamedFramebufferDrawBuffer(glTarget.rendererID, GL_NONE); }
+	else { glNamedFramebufferDrawBuffers(glTarget.rendererID, (GLsizei)glTarget.drawBuffers.size(), glTarget.drawBuffers.data()); }
+}
+
+void OpenGLFrameBuffer::BindColorAttachmentTexture(unsigned int index, unsigned int unit) const {
+	assert(spec.samples == 1); // multisampled textures need other samplers
+	glBindTextureUnit(unit, GetColorAttachmentRendererID(index));
+}
+
+void OpenGLFrameBuffer::BindDepthAttachmentTexture(unsigned int unit) const {
+	assert(spec.samples == 1 && depthRendererID != 0);
+	glBindTextureUnit(unit, depthRendererID); // samplers read depth, the default GL_DEPTH_STENCIL_TEXTURE_MODE
 }
 
 void OpenGLFrameBuffer::Clear(int clearValue, unsigned int index) {
+	assert(GetColorAttachmentFormat(index) == TextureFormat::RED_INTEGER);
 	glClearTexImage(GetColorAttachmentRendererID(index), 0, GL_RED_INTEGER, GL_INT, &clearValue);
 	glClear(GL_DEPTH_BUFFER_BIT);
 }
 
 void OpenGLFrameBuffer::Clear(glm::vec4 clearColor, unsigned int index) {
-	glClearTexImage(GetColorAttachmentRendererID(index), 0, GL_RGBA, GL_UNSIGNED_BYTE, glm::value_ptr(clearColor));
+	assert(GetColorAttachmentFormat(index) != TextureFormat::RED_INTEGER);
+	glClearTexImage(GetColorAttachmentRendererID(index), 0, GL_RGBA, GL_FLOAT, glm::value_ptr(clearColor));
 	glClear(GL_DEPTH_BUFFER_BIT);
 }
 
 void OpenGLFrameBuffer::ReadPixel(int& pixel, int x, int y, unsigned int index) {
+	assert(spec.samples == 1);
 	glReadBuffer(GL_COLOR_ATTACHMENT0 + index);
 	glReadPixels(x, y, 1, 1, GL_RED_INTEGER, GL_INT, &pixel);
 }
 
 void OpenGLFrameBuffer::ReadPixel(glm::vec4& pixel, int x, int y, unsigned int index) {
+	assert(spec.samples == 1);
 	glReadBuffer(GL_COLOR_ATTACHMENT0 + index);
 	glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &pixel);
 }
+
+
+bool OpenGLFrameBuffer::ReadPixelsAsync(int x, int y, int regionWidth, int regionHeight, const ReadbackCallback& callback, unsigned int index) {
+	assert(callback && spec.samples == 1);
+	const int x0 = std::max(x, 0);
+	const int y0 = std::max(y, 0);
+	const int x1 = std::min(x + regionWidth, spec.width);
+	const int y1 = std::min(y + regionHeight, spec.height);
+	if (x1 <= x0 || y1 <= y0) { return false; }
+	PendingReadback& readback = readbacks[nextReadback];
+	if (readback.callback) { return false; }
+
+	// Pixels are multiples of four bytes, so rows keep the default pack alignment
+	const TextureFormat textureFormat = GetColorAttachmentFormat(index);
+	const GLTextureFormat format = ToGLTextureFormat(textureFormat);
+	const unsigned int size = (x1 - x0) * (y1 - y0) * GetReadbackPixelSize(textureFormat);
+	if (readback.bufferID == 0) { glGenBuffers(1, &readback.bufferID); }
+	OpenGLGraphicsAPI::BindBuffer(GL_PIXEL_PACK_BUFFER, readback.bufferID);
+	if (readback.size < size) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		readback.size = size;
+	}
+	glReadBuffer(GL_COLOR_ATTACHMENT0 + index);
+	// Into the pack buffer, returns without waiting
+	glReadPixels(x0, y0, x1 - x0, y1 - y0, format.format, format.type, nullptr);
+	OpenGLGraphicsAPI::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.region = { x0, y0, x1 - x0, y1 - y0, textureFormat, nullptr };
+	readback.callback = callback;
+	nextReadback = (nextReadback + 1) % numReadbackBuffers;
+	return true;
+}
+
+void OpenGLFrameBuffer::PollReadbacks() {
+	// Readbacks finish in order, so stop at the first one still in flight. Callbacks may start new ones, which move nextReadback.
+	const int oldest = nextReadback;
+	for (int i = 0; i < numReadbackBuffers; i++) {
+		PendingReadback& readback = readbacks[(oldest + i) % numReadbackBuffers];
+		if (readback.fence == nullptr) { continue; }
+		const GLenum result = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (result == GL_TIMEOUT_EXPIRED) { break; }
+		if (result == GL_WAIT_FAILED) { Log::Error("Waiting for framebuffer readback failed"); }
+		glDeleteSync(readback.fence);
+		readback.fence = nullptr;
+
+		OpenGLGraphicsAPI::BindBuffer(GL_PIXEL_PACK_BUFFER, readback.bufferID);
+		Readback region = readback.region;
+		region.pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, region.width * region.height * GetReadbackPixelSize(region.format), GL_MAP_READ_BIT);
+		if (region.pixels != nullptr) {
+			readback.callback(region);
+			OpenGLGraphicsAPI::BindBuffer(GL_PIXEL_PACK_BUFFER, readback.bufferID); // the callback may have bound another one
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		OpenGLGraphicsAPI::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		readback.callback = nullptr;
+	}
+}
@@ -2,26 +2,58 @@
 
 #include "Renderer/FrameBuffer.h"
 
+#include <glad/glad.h>
+
+#include <array>
 #include <vector>
 
 class OpenGLFrameBuffer : public FrameBuffer {
 public:
-	OpenGLFrameBuffer(int width, int height, TextureFormat textureFormat);
+	OpenGLFrameBuffer(const FrameBufferSpec& spec);
 	virtual ~OpenGLFrameBuffer();
 
 	virtual void Bind() const override;
 	virtual void Unbind() const override;
 
+	virtual const FrameBufferSpec& GetSpec() const override { return spec; }
 	virtual unsigned int GetColorAttachmentRendererID(unsigned int index) const override;
+	virtual TextureFormat GetColorAttachmentFormat(unsigned int index) const override;
+	virtual unsigned int GetNumColorAttachments() const override { return (unsigned int)colorRendererIDs.size(); }
+	virtual unsigned int GetDepthAttachmentRendererID() const override { return depthRendererID; }
+	virtual int GetWidth() const override { return spec.width; }
+	virtual int GetHeight() const override { return spec.height; }
 	virtual void Resize(int width, int height) override;
+	virtual void SetDrawAttachments(const std::vector<unsigned int>& indices) override;
+	virtual void ResolveTo(FrameBuffer& target, bool includeColors = true) const override;
+	virtual void BindColorAttachmentTexture(unsigned int index, unsigned int unit) const override;
+	virtual void BindDepthAttachmentTexture(unsigned int unit) const override;
 	virtual void Clear(int clearValue, unsigned int index) override;
 	virtual void Clear(glm::vec4 clearColor, unsigned int index = 0) override;
 	virtual void ReadPixel(int& pixel, int x, int y, unsigned int index = 0) override;
 	virtual void ReadPixel(glm::vec4& pixel, int x, int y, unsigned int index = 0) override;
+	virtual bool ReadPixelsAsync(int x, int y, int width, int height, const ReadbackCallback& callback, unsigned int index = 0) override;
+	virtual void PollReadbacks() override;
 
 private:
+	// (Re)allocates the storage of all attachments at the current size
+	void AllocateAttachments();
+	GLenum GetTextureTarget() const { return spec.samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D; }
+
+	// A pixel pack buffer with a fence after the copy into it. Busy from the copy until its callback returns.
+	struct PendingReadback {
+		GLuint bufferID = 0; // created on first use
+		unsigned int size = 0;
+		GLsync fence = nullptr;
+		Readback region;
+		ReadbackCallback callback;
+	};
+
 	unsigned int rendererID = -1;
 	std::vector<unsigned int> colorRendererIDs;
-	unsigned int depthRendererID;
-	TextureFormat textureFormat;
+	std::vector<TextureFormat> colorFormats;
+	unsigned int depthRendererID = 0;
+	std::vector<GLenum> drawBuffers; // see SetDrawAttachments
+	FrameBufferSpec spec;
+	std::array<PendingReadback, numReadbackBuffers> readbacks;
+	int nextReadback = 0; // the oldest one when busy
 };
\ No newline at end of file
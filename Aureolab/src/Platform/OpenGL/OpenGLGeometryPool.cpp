@@ -0,0 +1,85 @@
+#include "OpenGLGeometryPool.h"
+
+#include "OpenGLGraphicsAPI.h"
+#include "OpenGLVertexSpecification.h"
+#include "Modeling/VertexPacking.h"
+
+#include <algorithm>
+#include <cstdint>
+
+static constexpr uint32_t initialCapacity = 1 << 16; // vertices and indices
+
+OpenGLGeometryPool::OpenGLGeometryPool(VertexFormat format, IndexType indexType)
+	: GeometryPool(format, indexType) {
+	for (const VertexAttributeSpecification& spec : GetVertexAttributeSpecs(format)) { vertexSize += TypeSize(spec.type) * spec.numComponents; }
+	indexSize = indexType == IndexType::uint16 ? sizeof(GLushort) : sizeof(GLuint);
+	glGenVertexArrays(1, &vertexArrayID);
+	Reserve(initialCapacity, initialCapacity);
+}
+
+OpenGLGeometryPool::~OpenGLGeometryPool() {
+	OpenGLGraphicsAPI::DeleteVertexArray(vertexArrayID);
+	OpenGLGraphicsAPI::DeleteBuffer(vertexBufferID);
+	OpenGLGraphicsAPI::DeleteBuffer(indexBufferID);
+}
+
+void OpenGLGeometryPool::Bind() const {
+	OpenGLGraphicsAPI::BindVertexArray(vertexArrayID);
+}
+
+void OpenGLGeometryPool::Reserve(uint32_t numVertices, uint32_t numIndices) {
+	if (numVertices > vertexCapacity) {
+		const uint32_t newCapacity = std::max(numVertices, vertexCapacity * 2);
+		vertexBufferID = Grow(vertexBufferID, (GLsizeiptr)vertexCapacity * vertexSize, (GLsizeiptr)newCapacity * vertexSize);
+		vertexCapacity = newCapacity;
+		SetAttributes();
+	}
+	if (numIndices > indexCapacity) {
+		const uint32_t newCapacity = std::max(numIndices, indexCapacity * 2);
+		indexBufferID = Grow(indexBufferID, (GLsizeiptr)indexCapacity * indexSize, (GLsizeiptr)newCapacity * indexSize);
+		indexCapacity = newCapacity;
+		OpenGLGraphicsAPI::BindVertexArray(vertexArrayID);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID);
+		OpenGLGraphicsAPI::BindVertexArray(0); // so that later element buffer binds do not change this VAO
+	}
+}
+
+void OpenGLGeometryPool::CopyIn(const MeshAsset* asset, uint32_t firstVertex, uint32_t firstIndex) {
+	const GLsizeiptr verticesSize = (GLsizeiptr)asset->vbo->GetNumVertices() * vertexSize;
+	if (verticesSize > 0) {
+		OpenGLGraphicsAPI::BindBuffer(GL_COPY_READ_BUFFER, asset->vbo->GetRendererID());
+		OpenGLGraphicsAPI::BindBuffer(GL_COPY_WRITE_BUFFER, vertexBufferID);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, (GLintptr)firstVertex * vertexSize, verticesSize);
+	}
+	const GLsizeiptr indicesSize = (GLsizeiptr)asset->ebo->GetNumIndices() * indexSize;
+	if (indicesSize > 0) {
+		OpenGLGraphicsAPI::BindBuffer(GL_COPY_READ_BUFFER, asset->ebo->GetRendererID());
+		OpenGLGraphicsAPI::BindBuffer(GL_COPY_WRITE_BUFFER, indexBufferID);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, (GLintptr)firstIndex * indexSize, indicesSize);
+	}
+}
+
+GLuint OpenGLGeometryPool::Grow(GLuint buffer, GLsizeiptr oldSize, GLsizeiptr newSize) {
+	GLuint newBuffer = 0;
+	glGenBuffers(1, &newBuffer);
+	OpenGLGraphicsAPI::BindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, newSize, nullptr, 0); // only written by copies
+	if (oldSize > 0) {
+		OpenGLGraphicsAPI::BindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+	}
+	if (buffer != 0) { OpenGLGraphicsAPI::DeleteBuffer(buffer); } // freed by the driver once the copy is done
+	return newBuffer;
+}
+
+void OpenGLGeometryPool::SetAttributes() {
+	OpenGLGraphicsAPI::BindVertexArray(vertexArrayID);
+	OpenGLGraphicsAPI::BindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+	unsigned int offset = 0;
+	for (const VertexAttributeSpecification& spec : GetVertexAttributeSpecs(format)) {
+		glVertexAttribPointer(spec.index, spec.numComponents, ALTypeToGLType(spec.type), spec.normalized, vertexSize, (void*)(std::uintptr_t)offset);
+		glEnableVertexAttribArray(spec.index);
+		offset += TypeSize(spec.type) * spec.numComponents;
+	}
+	OpenGLGraphicsAPI::BindVertexArray(0);
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Renderer/GeometryPool.h"
+
+#include <glad/glad.h>
+
+// Buffers have immutable storage that is only written by copies, and are replaced by larger ones as the pool grows
+class OpenGLGeometryPool : public GeometryPool {
+public:
+	OpenGLGeometryPool(VertexFormat format, IndexType indexType);
+	~OpenGLGeometryPool();
+
+	virtual void Bind() const override;
+
+protected:
+	virtual void Reserve(uint32_t numVertices, uint32_t numIndices) override;
+	virtual void CopyIn(const MeshAsset* asset, uint32_t firstVertex, uint32_t firstIndex) override;
+
+private:
+	// Returns a buffer of newSize bytes with the first oldSize bytes of buffer, which is deleted
+	static GLuint Grow(GLuint buffer, GLsizeiptr oldSize, GLsizeiptr newSize);
+	// Points the vertex attributes of the VAO at the current vertex buffer
+	void SetAttributes();
+
+	GLuint vertexArrayID = 0;
+	GLuint vertexBufferID = 0;
+	GLuint indexBufferID = 0;
+	uint32_t vertexCapacity = 0;
+	uint32_t indexCapacity = 0;
+	unsigned int vertexSize = 0;
+	unsigned int indexSize = 0;
+};
\ No newline at end of file
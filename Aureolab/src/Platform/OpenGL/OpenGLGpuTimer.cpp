@@ -0,0 +1,45 @@
+#include "OpenGLGpuTimer.h"
+
+OpenGLGpuTimer::~OpenGLGpuTimer() {
+	for (Frame& frame : frames) {
+		if (!frame.queries.empty()) { glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data()); }
+	}
+}
+
+void OpenGLGpuTimer::BeginFrame() {
+	// Frames finish in order, so stop at the first one still in flight. The last query of a frame is available after the others.
+	for (int i = 1; i <= numFramesInFlight; i++) {
+		Frame& frame = frames[(current + i) % numFramesInFlight];
+		if (!frame.isInFlight) { continue; }
+		GLint isAvailable = GL_FALSE;
+		glGetQueryObjectiv(frame.queries[frame.labels.size() - 1], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+		if (isAvailable == GL_FALSE) { break; }
+
+		latestFrame.resize(frame.labels.size());
+		GLuint64 start = 0;
+		for (size_t ix = 0; ix < frame.labels.size(); ix++) {
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(frame.queries[ix], GL_QUERY_RESULT, &nanoseconds);
+			if (ix == 0) { start = nanoseconds; }
+			latestFrame[ix] = { frame.labels[ix], (double)(nanoseconds - start) * 1e-6 };
+		}
+		frame.isInFlight = false;
+	}
+
+	current = (current + 1) % numFramesInFlight;
+	isRecording = !frames[current].isInFlight;
+	if (isRecording) { frames[current].labels.clear(); }
+}
+
+void OpenGLGpuTimer::Record(const std::string& label) {
+	if (!isRecording) { return; }
+	Frame& frame = frames[current];
+	if (frame.labels.size() == frame.queries.size()) {
+		GLuint queryID = 0;
+		glGenQueries(1, &queryID);
+		frame.queries.push_back(queryID);
+	}
+	glQueryCounter(frame.queries[frame.labels.size()], GL_TIMESTAMP);
+	frame.labels.push_back(label);
+	frame.isInFlight = true;
+}
\ No newline at end of file
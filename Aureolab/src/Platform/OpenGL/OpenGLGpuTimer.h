@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Renderer/GpuTimer.h"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <string>
+#include <vector>
+
+// A GL_TIMESTAMP query per recorded point, in a ring of frames whose query objects are reused once their results have been read.
+class OpenGLGpuTimer : public GpuTimer {
+public:
+	~OpenGLGpuTimer();
+
+	virtual void BeginFrame() override;
+	virtual void Record(const std::string& label) override;
+
+private:
+	struct Frame {
+		std::vector<GLuint> queries; // created on first use, the first labels.size() ones recorded
+		std::vector<std::string> labels;
+		bool isInFlight = false;
+	};
+
+	std::array<Frame, numFramesInFlight> frames;
+	int current = -1; // frame being recorded, the one before the oldest
+	bool isRecording = false;
+};
\ No newline at end of file
@@ -1,7 +1,15 @@
 #include "OpenGLGraphicsAPI.h"
 
+#include "Renderer/GeometryPool.h"
+#include "Renderer/StorageBuffer.h"
+
+#include "Core/Log.h"
+
 #include <glad/glad.h>
 
+#include <cassert>
+#include <limits>
+
 GLenum AbilityAL2GL(GraphicsAbility ability) {
 	switch (ability) {
 	case GraphicsAbility::Blend:
@@ -72,6 +80,18 @@ inline GLenum PolygonModeAL2GL(PolygonMode pm) {
 	}
 }
 
+inline GLenum IndexTypeAL2GL(IndexType it) {
+	switch (it) {
+	case IndexType::uint16:
+		return GL_UNSIGNED_SHORT;
+	case IndexType::uint32:
+		return GL_UNSIGNED_INT;
+	default:
+		assert(false); // unknown IndexType
+		return -1;
+	}
+}
+
 inline GLenum BufferTestFunctionAL2GL(BufferTestFunction df) {
 	switch (df) {
 	case BufferTestFunction::Never:
@@ -121,8 +141,41 @@ inline GLenum StencilActionAL2GL(StencilAction sa) {
 }
 
 
+static int BufferTargetIndex(GLenum target) {
+	switch (target) {
+	case GL_ARRAY_BUFFER:
+		return 0;
+	case GL_COPY_READ_BUFFER:
+		return 1;
+	case GL_COPY_WRITE_BUFFER:
+		return 2;
+	case GL_UNIFORM_BUFFER:
+		return 3;
+	case GL_SHADER_STORAGE_BUFFER:
+		return 4;
+	case GL_DRAW_INDIRECT_BUFFER:
+		return 5;
+	case GL_PIXEL_PACK_BUFFER:
+		return 6;
+	case GL_PIXEL_UNPACK_BUFFER:
+		return 7;
+	default:
+		assert(false); // buffer target not cached
+		return -1;
+	}
+}
+
+// Tells whether a cached value has to be set, and counts calls that would not change anything
+static bool ShouldChange(bool isDifferent) {
+	if (isDifferent) { GraphicsAPI::stats.numStateChanges++; }
+	else { GraphicsAPI::stats.numRedundantStateChanges++; }
+	return isDifferent;
+}
+
 void OpenGLGraphicsAPI::SetClearColor(const glm::vec4& color) {
+	if (!ShouldChange(color != clearColor)) { return; }
 	glClearColor(color.r, color.g, color.b, color.a);
+	clearColor = color;
 }
 
 void OpenGLGraphicsAPI::Clear(std::unordered_set<ClearableBuffer> buffers) {
@@ -139,18 +192,19 @@ void OpenGLGraphicsAPI::Clear(std::unordered_set<ClearableBuffer> buffers) {
 }
 
 void OpenGLGraphicsAPI::Enable(GraphicsAbility ability) {
-	GLenum glEnum = AbilityAL2GL(ability);
-	glEnable(glEnum);
+	PipelineState next = state;
+	next.SetEnabled(ability, true);
+	SetPipelineState(next);
 }
 
 void OpenGLGraphicsAPI::Disable(GraphicsAbility ability) {
-	GLenum glEnum = AbilityAL2GL(ability);
-	glDisable(glEnum);
+	PipelineState next = state;
+	next.SetEnabled(ability, false);
+	SetPipelineState(next);
 }
 
 bool OpenGLGraphicsAPI::IsEnabled(GraphicsAbility ability) {
-	GLenum glEnum = AbilityAL2GL(ability);
-	return glIsEnabled(glEnum);
+	return state.IsEnabled(ability);
 }
 
 glm::ivec4 OpenGLGraphicsAPI::GetViewportPositionAndSize() const {
@@ -160,71 +214,291 @@ glm::ivec4 OpenGLGraphicsAPI::GetViewportPositionAndSize() const {
 }
 
 void OpenGLGraphicsAPI::SetDefaultPointSize(float diameter) {
+	if (!ShouldChange(diameter != pointSize)) { return; }
 	glPointSize(diameter);
+	pointSize = diameter;
 }
 
 void OpenGLGraphicsAPI::SetBlendingFunction(BlendingFactor src, BlendingFactor dst) {
-	GLenum srcEnum = BlendingFactorAL2GL(src);
-	GLenum dstEnum = BlendingFactorAL2GL(dst);
-	glBlendFunc(srcEnum, dstEnum);
+	PipelineState next = state;
+	next.blendSource = src;
+	next.blendDestination = dst;
+	SetPipelineState(next);
 }
 
 void OpenGLGraphicsAPI::SetCullFace(CullFace cullFace) {
-	GLenum glEnum = cullFaceAL2GL(cullFace);
-	glCullFace(glEnum);
+	PipelineState next = state;
+	next.cullFace = cullFace;
+	SetPipelineState(next);
 }
 
 void OpenGLGraphicsAPI::SetPolygonMode(PolygonMode polygonMode) {
-	GLenum glEnum = PolygonModeAL2GL(polygonMode);
-	glPolygonMode(GL_FRONT_AND_BACK, glEnum);
+	PipelineState next = state;
+	next.polygonMode = polygonMode;
+	SetPipelineState(next);
 }
 
 void OpenGLGraphicsAPI::SetDepthFunction(BufferTestFunction depthTestFunction) {
-	GLenum glEnum = BufferTestFunctionAL2GL(depthTestFunction);
-	glDepthFunc(glEnum);
+	PipelineState next = state;
+	next.depthFunction = depthTestFunction;
+	SetPipelineState(next);
 }
 
 void OpenGLGraphicsAPI::SetStencilOperation(StencilAction stencilTestFail, StencilAction depthTestFail, StencilAction depthTestPass) {
-	GLenum fail = StencilActionAL2GL(stencilTestFail);
-	GLenum zfail = StencilActionAL2GL(depthTestFail);
-	GLenum zpass = StencilActionAL2GL(depthTestPass);
-	glStencilOp(fail, zfail, zpass);
+	PipelineState next = state;
+	next.stencilTestFail = stencilTestFail;
+	next.depthTestFail = depthTestFail;
+	next.depthTestPass = depthTestPass;
+	SetPipelineState(next);
 }
 
 void OpenGLGraphicsAPI::SetStencilFunction(BufferTestFunction stencilTestFunction, int reference, unsigned int mask) {
-	GLenum func = BufferTestFunctionAL2GL(stencilTestFunction);
-	glStencilFunc(func, reference, mask);
+	PipelineState next = state;
+	next.stencilFunction = stencilTestFunction;
+	next.stencilReference = reference;
+	next.stencilReadMask = mask;
+	SetPipelineState(next);
 }
 
 void OpenGLGraphicsAPI::SetStencilMask(unsigned int mask) {
-	glStencilMask(mask);
+	PipelineState next = state;
+	next.stencilWriteMask = mask;
+	SetPipelineState(next);
 }
 
 void OpenGLGraphicsAPI::SetPolygonOffset(float factor, float units) {
-	glPolygonOffset(factor, units);
+	PipelineState next = state;
+	next.polygonOffsetFactor = factor;
+	next.polygonOffsetUnits = units;
+	SetPipelineState(next);
 }
 
-void OpenGLGraphicsAPI::DrawIndexedTriangles(const VertexArray& vertexArray, unsigned int indexCount) {
-	vertexArray.Bind();
-	indexCount = indexCount == 0 ? (unsigned int)vertexArray.GetIndexBuffer()->GetNumIndices() : indexCount;
-	glDrawElements(GL_TRIANGLES, (GLsizei)indexCount, GL_UNSIGNED_INT, 0);
+void OpenGLGraphicsAPI::SetPipelineState(const PipelineState& next) {
+	const bool isAll = !isStateKnown;
+	int numChanges = 0;
+	for (int ability = 0; ability <= (int)GraphicsAbility::PolygonOffsetPoint; ability++) {
+		const bool isEnabled = next.IsEnabled((GraphicsAbility)ability);
+		if (!isAll && isEnabled == state.IsEnabled((GraphicsAbility)ability)) { continue; }
+		if (isEnabled) { glEnable(AbilityAL2GL((GraphicsAbility)ability)); }
+		else { glDisable(AbilityAL2GL((GraphicsAbility)ability)); }
+		numChanges++;
+	}
+	if (isAll || next.blendSource != state.blendSource || next.blendDestination != state.blendDestination) {
+		glBlendFunc(BlendingFactorAL2GL(next.blendSource), BlendingFactorAL2GL(next.blendDestination));
+		numChanges++;
+	}
+	if (isAll || next.cullFace != state.cullFace) {
+		glCullFace(cullFaceAL2GL(next.cullFace));
+		numChanges++;
+	}
+	if (isAll || next.polygonMode != state.polygonMode) {
+		glPolygonMode(GL_FRONT_AND_BACK, PolygonModeAL2GL(next.polygonMode));
+		numChanges++;
+	}
+	if (isAll || next.depthFunction != state.depthFunction) {
+		glDepthFunc(BufferTestFunctionAL2GL(next.depthFunction));
+		numChanges++;
+	}
+	if (isAll || next.stencilTestFail != state.stencilTestFail || next.depthTestFail != state.depthTestFail || next.depthTestPass != state.depthTestPass) {
+		glStencilOp(StencilActionAL2GL(next.stencilTestFail), StencilActionAL2GL(next.depthTestFail), StencilActionAL2GL(next.depthTestPass));
+		numChanges++;
+	}
+	if (isAll || next.stencilFunction != state.stencilFunction || next.stencilReference != state.stencilReference || next.stencilReadMask != state.stencilReadMask) {
+		glStencilFunc(BufferTestFunctionAL2GL(next.stencilFunction), next.stencilReference, next.stencilReadMask);
+		numChanges++;
+	}
+	if (isAll || next.stencilWriteMask != state.stencilWriteMask) {
+		glStencilMask(next.stencilWriteMask);
+		numChanges++;
+	}
+	if (isAll || next.polygonOffsetFactor != state.polygonOffsetFactor || next.polygonOffsetUnits != state.polygonOffsetUnits) {
+		glPolygonOffset(next.polygonOffsetFactor, next.polygonOffsetUnits);
+		numChanges++;
+	}
+	stats.numStateChanges += numChanges;
+	if (numChanges == 0) { stats.numRedundantStateChanges++; }
+	state = next;
+	isStateKnown = true;
+}
+
+void OpenGLGraphicsAPI::InvalidateState() {
+	isStateKnown = false;
+	clearColor = glm::vec4(std::numeric_limits<float>::quiet_NaN()); // unequal to any color
+	pointSize = std::numeric_limits<float>::quiet_NaN();
+	program = unknownBinding;
+	vertexArray = unknownBinding;
+	framebuffer = unknownBinding;
+	buffers.fill(unknownBinding);
+	for (std::vector<GLuint>& points : indexedBuffers) { points.clear(); }
+}
+
+void OpenGLGraphicsAPI::DrawIndexedTriangles(const VertexArray& vertexArray, unsigned int indexCount, unsigned int firstIndex, unsigned int baseInstance) {
+	DrawIndexedTrianglesInstanced(vertexArray, 1, indexCount, firstIndex, baseInstance);
 }
 
-void OpenGLGraphicsAPI::DrawIndexedPoints(const VertexArray& vertexArray, unsigned int indexCount) {
+void OpenGLGraphicsAPI::DrawIndexedPoints(const VertexArray& vertexArray, unsigned int indexCount, unsigned int firstIndex) {
 	vertexArray.Bind();
-	indexCount = indexCount == 0 ? (unsigned int)vertexArray.GetIndexBuffer()->GetNumIndices() : indexCount;
-	glDrawElements(GL_POINTS, (GLsizei)indexCount, GL_UNSIGNED_INT, 0);
+	BeforeDraw();
+	const IndexBuffer* indexBuffer = vertexArray.GetIndexBuffer();
+	indexCount = indexCount == 0 ? (unsigned int)indexBuffer->GetNumIndices() : indexCount;
+	const size_t indexSize = indexBuffer->GetIndexType() == IndexType::uint16 ? sizeof(GLushort) : sizeof(GLuint);
+	glDrawElements(GL_POINTS, (GLsizei)indexCount, IndexTypeAL2GL(indexBuffer->GetIndexType()), (void*)(firstIndex * indexSize));
 }
 
 void OpenGLGraphicsAPI::DrawArrayTriangles(const VertexArray& vertexArray, unsigned int start, unsigned int count) {
 	vertexArray.Bind();
+	BeforeDraw();
 	count = count == 0 ? vertexArray.GetVertexBuffers()[0]->GetNumVertices() : count;
 	glDrawArrays(GL_TRIANGLES, start, count);
 }
 
 void OpenGLGraphicsAPI::DrawArrayPoints(const VertexArray& vertexArray, unsigned int start, unsigned int count) {
 	vertexArray.Bind();
+	BeforeDraw();
 	count = count == 0 ? vertexArray.GetVertexBuffers()[0]->GetNumVertices() : count;
 	glDrawArrays(GL_POINTS, start, count);
 }
 
+void OpenGLGraphicsAPI::DrawIndexedTrianglesInstanced(const VertexArray& vertexArray, unsigned int instanceCount, unsigned int indexCount, unsigned int firstIndex, unsigned int baseInstance) {
+	vertexArray.Bind();
+	BeforeDraw();
+	const IndexBuffer* indexBuffer = vertexArray.GetIndexBuffer();
+	indexCount = indexCount == 0 ? (unsigned int)indexBuffer->GetNumIndices() : indexCount;
+	const size_t indexSize = indexBuffer->GetIndexType() == IndexType::uint16 ? sizeof(GLushort) : sizeof(GLuint);
+	glDrawElementsInstancedBaseInstance(GL_TRIANGLES, (GLsizei)indexCount, IndexTypeAL2GL(indexBuffer->GetIndexType()), (void*)(firstIndex * indexSize), (GLsizei)instanceCount, baseInstance);
+}
+
+void OpenGLGraphicsAPI::DrawArrayTrianglesInstanced(const VertexArray& vertexArray, unsigned int instanceCount, unsigned int start, unsigned int count, unsigned int baseInstance) {
+	vertexArray.Bind();
+	BeforeDraw();
+	count = count == 0 ? vertexArray.GetVertexBuffers()[0]->GetNumVertices() : count;
+	glDrawArraysInstancedBaseInstance(GL_TRIANGLES, start, count, (GLsizei)instanceCount, baseInstance);
+}
+
+void OpenGLGraphicsAPI::MultiDrawIndexedTrianglesIndirect(const GeometryPool& pool, const StorageBuffer& commands, unsigned int firstCommand, unsigned int numCommands, unsigned int stride) {
+	pool.Bind();
+	BindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.GetRendererID());
+	BeforeDraw();
+	glMultiDrawElementsIndirect(GL_TRIANGLES, IndexTypeAL2GL(pool.GetIndexType()), (void*)((size_t)firstCommand * stride), (GLsizei)numCommands, (GLsizei)stride);
+}
+
+void OpenGLGraphicsAPI::UseProgram(GLuint id) {
+	if (!ShouldChange(id != program)) { return; }
+	glUseProgram(id);
+	program = id;
+}
+
+void OpenGLGraphicsAPI::BindVertexArray(GLuint id) {
+	if (!ShouldChange(id != vertexArray)) { return; }
+	glBindVertexArray(id);
+	vertexArray = id;
+}
+
+void OpenGLGraphicsAPI::BindBuffer(GLenum target, GLuint id) {
+	GLuint& bound = buffers[BufferTargetIndex(target)];
+	if (!ShouldChange(id != bound)) { return; }
+	glBindBuffer(target, id);
+	bound = id;
+}
+
+void OpenGLGraphicsAPI::BindBufferBase(GLenum target, GLuint index, GLuint id) {
+	assert(target == GL_UNIFORM_BUFFER || target == GL_SHADER_STORAGE_BUFFER);
+	std::vector<GLuint>& points = indexedBuffers[target == GL_UNIFORM_BUFFER ? 0 : 1];
+	if (index >= points.size()) { points.resize(index + 1, unknownBinding); }
+	if (!ShouldChange(id != points[index])) { return; }
+	glBindBufferBase(target, index, id);
+	points[index] = id;
+	buffers[BufferTargetIndex(target)] = id; // binds the generic binding point too
+}
+
+void OpenGLGraphicsAPI::BindFramebuffer(GLuint id) {
+	if (!ShouldChange(id != framebuffer)) { return; }
+	glBindFramebuffer(GL_FRAMEBUFFER, id);
+	framebuffer = id;
+}
+
+void OpenGLGraphicsAPI::DeleteProgram(GLuint id) {
+	glDeleteProgram(id);
+	if (program == id) { program = unknownBinding; }
+}
+
+void OpenGLGraphicsAPI::DeleteVertexArray(GLuint id) {
+	glDeleteVertexArrays(1, &id);
+	if (vertexArray == id) { vertexArray = unknownBinding; }
+}
+
+void OpenGLGraphicsAPI::DeleteBuffer(GLuint id) {
+	glDeleteBuffers(1, &id);
+	for (GLuint& bound : buffers) {
+		if (bound == id) { bound = unknownBinding; }
+	}
+	for (std::vector<GLuint>& points : indexedBuffers) {
+		for (GLuint& bound : points) {
+			if (bound == id) { bound = unknownBinding; }
+		}
+	}
+}
+
+void OpenGLGraphicsAPI::DeleteFramebuffer(GLuint id) {
+	glDeleteFramebuffers(1, &id);
+	if (framebuffer == id) { framebuffer = unknownBinding; }
+}
+
+void OpenGLGraphicsAPI::BeforeDraw() const {
+	if (isStateValidationEnabled) { ValidateState(); }
+}
+
+void OpenGLGraphicsAPI::ValidateState() const {
+	bool isValid = true;
+	auto check = [&isValid](const char* name, GLint cached, GLint actual) {
+		if (cached == actual) { return; }
+		Log::Error("Cached GL state {} is {} but the driver has {}", name, cached, actual);
+		isValid = false;
+	};
+	auto getInteger = [](GLenum name) {
+		GLint value = 0;
+		glGetIntegerv(name, &value);
+		return value;
+	};
+	auto getFloat = [](GLenum name) {
+		GLfloat value = 0.0f;
+		glGetFloatv(name, &value);
+		return value;
+	};
+
+	if (isStateKnown) {
+		for (int ability = 0; ability <= (int)GraphicsAbility::PolygonOffsetPoint; ability++) {
+			check("ability", state.IsEnabled((GraphicsAbility)ability), glIsEnabled(AbilityAL2GL((GraphicsAbility)ability)));
+		}
+		check("GL_BLEND_SRC_RGB", BlendingFactorAL2GL(state.blendSource), getInteger(GL_BLEND_SRC_RGB));
+		check("GL_BLEND_DST_RGB", BlendingFactorAL2GL(state.blendDestination), getInteger(GL_BLEND_DST_RGB));
+		check("GL_CULL_FACE_MODE", cullFaceAL2GL(state.cullFace), getInteger(GL_CULL_FACE_MODE));
+		GLint polygonModes[2] = {};
+		glGetIntegerv(GL_POLYGON_MODE, polygonModes);
+		check("GL_POLYGON_MODE", PolygonModeAL2GL(state.polygonMode), polygonModes[0]);
+		check("GL_DEPTH_FUNC", BufferTestFunctionAL2GL(state.depthFunction), getInteger(GL_DEPTH_FUNC));
+		check("GL_STENCIL_FAIL", StencilActionAL2GL(state.stencilTestFail), getInteger(GL_STENCIL_FAIL));
+		check("GL_STENCIL_PASS_DEPTH_FAIL", StencilActionAL2GL(state.depthTestFail), getInteger(GL_STENCIL_PASS_DEPTH_FAIL));
+		check("GL_STENCIL_PASS_DEPTH_PASS", StencilActionAL2GL(state.depthTestPass), getInteger(GL_STENCIL_PASS_DEPTH_PASS));
+		check("GL_STENCIL_FUNC", BufferTestFunctionAL2GL(state.stencilFunction), getInteger(GL_STENCIL_FUNC));
+		check("GL_STENCIL_REF", state.stencilReference, getInteger(GL_STENCIL_REF));
+		check("GL_STENCIL_VALUE_MASK", (GLint)state.stencilReadMask, getInteger(GL_STENCIL_VALUE_MASK));
+		check("GL_STENCIL_WRITEMASK", (GLint)state.stencilWriteMask, getInteger(GL_STENCIL_WRITEMASK));
+		const glm::vec2 polygonOffset = { getFloat(GL_POLYGON_OFFSET_FACTOR), getFloat(GL_POLYGON_OFFSET_UNITS) };
+		if (polygonOffset != glm::vec2(state.polygonOffsetFactor, state.polygonOffsetUnits)) {
+			Log::Error("Cached polygon offset is {} {} but the driver has {} {}", state.polygonOffsetFactor, state.polygonOffsetUnits, polygonOffset.x, polygonOffset.y);
+			isValid = false;
+		}
+	}
+	if (program != unknownBinding) { check("GL_CURRENT_PROGRAM", program, getInteger(GL_CURRENT_PROGRAM)); }
+	if (vertexArray != unknownBinding) { check("GL_VERTEX_ARRAY_BINDING", vertexArray, getInteger(GL_VERTEX_ARRAY_BINDING)); }
+	if (framebuffer != unknownBinding) { check("GL_DRAW_FRAMEBUFFER_BINDING", framebuffer, getInteger(GL_DRAW_FRAMEBUFFER_BINDING)); }
+	const std::array<GLenum, 8> bindingNames = {
+		GL_ARRAY_BUFFER_BINDING, GL_COPY_READ_BUFFER_BINDING, GL_COPY_WRITE_BUFFER_BINDING, GL_UNIFORM_BUFFER_BINDING,
+		GL_SHADER_STORAGE_BUFFER_BINDING, GL_DRAW_INDIRECT_BUFFER_BINDING, GL_PIXEL_PACK_BUFFER_BINDING, GL_PIXEL_UNPACK_BUFFER_BINDING,
+	};
+	for (size_t ix = 0; ix < buffers.size(); ix++) {
+		if (buffers[ix] != unknownBinding) { check("buffer binding", buffers[ix], getInteger(bindingNames[ix])); }
+	}
+	assert(isValid); // the cache is out of sync, see the log
+}
\ No newline at end of file
@@ -2,6 +2,13 @@
 
 #include "Renderer/GraphicsAPI.h"
 
+#include <glad/glad.h>
+
+#include <array>
+#include <vector>
+
+// Keeps a shadow copy of the GL state it sets, and drops changes to values that are already current before they reach the driver.
+// Bindings made by the other OpenGL classes go through the static functions below for the same reason.
 class OpenGLGraphicsAPI : public GraphicsAPI {
 public:
 	OpenGLGraphicsAPI() = default;
@@ -25,8 +32,44 @@ public:
 	virtual void SetStencilMask(unsigned int mask) override;
 	virtual void SetPolygonOffset(float factor, float units) override;
 
-	virtual void DrawIndexedTriangles(const VertexArray& vertexArray, unsigned int indexCount = 0) override;
-	virtual void DrawIndexedPoints(const VertexArray& vertexArray, unsigned int indexCount = 0) override;
+	virtual void SetPipelineState(const PipelineState& state) override;
+	virtual const PipelineState& GetPipelineState() const override { return state; }
+	virtual void InvalidateState() override;
+
+	virtual void DrawIndexedTriangles(const VertexArray& vertexArray, unsigned int indexCount = 0, unsigned int firstIndex = 0, unsigned int baseInstance = 0) override;
+	virtual void DrawIndexedPoints(const VertexArray& vertexArray, unsigned int indexCount = 0, unsigned int firstIndex = 0) override;
 	virtual void DrawArrayTriangles(const VertexArray& vertexArray, unsigned int start = 0, unsigned int count = 0) override;
 	virtual void DrawArrayPoints(const VertexArray& vertexArray, unsigned int start = 0, unsigned int count = 0) override;
+	virtual void DrawIndexedTrianglesInstanced(const VertexArray& vertexArray, unsigned int instanceCount, unsigned int indexCount = 0, unsigned int firstIndex = 0, unsigned int baseInstance = 0) override;
+	virtual void DrawArrayTrianglesInstanced(const VertexArray& vertexArray, unsigned int instanceCount, unsigned int start = 0, unsigned int count = 0, unsigned int baseInstance = 0) override;
+	virtual void MultiDrawIndexedTrianglesIndirect(const GeometryPool& pool, const StorageBuffer& commands, unsigned int firstCommand, unsigned int numCommands, unsigned int stride = sizeof(DrawElementsIndirectCommand)) override;
+
+	static void UseProgram(GLuint program);
+	static void BindVertexArray(GLuint vertexArray);
+	// Not for GL_ELEMENT_ARRAY_BUFFER, whose binding is part of the bound vertex array
+	static void BindBuffer(GLenum target, GLuint buffer);
+	static void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	static void BindFramebuffer(GLuint framebuffer);
+	// Delete through these, so that a name the driver hands out again is not taken as still bound
+	static void DeleteProgram(GLuint program);
+	static void DeleteVertexArray(GLuint vertexArray);
+	static void DeleteBuffer(GLuint buffer);
+	static void DeleteFramebuffer(GLuint framebuffer);
+
+private:
+	// Reports differences between the cache and the driver's state
+	void ValidateState() const;
+	void BeforeDraw() const;
+
+	PipelineState state;
+	glm::vec4 clearColor = glm::vec4(0.0f);
+	float pointSize = 1.0f;
+	bool isStateKnown = false; // otherwise the next changes are applied even if equal to the cached values
+
+	static constexpr GLuint unknownBinding = 0xFFFFFFFF;
+	static inline GLuint program = unknownBinding;
+	static inline GLuint vertexArray = unknownBinding;
+	static inline GLuint framebuffer = unknownBinding;
+	static inline std::array<GLuint, 8> buffers = { unknownBinding, unknownBinding, unknownBinding, unknownBinding, unknownBinding, unknownBinding, unknownBinding, unknownBinding }; // by target, see BufferTargetIndex
+	static inline std::array<std::vector<GLuint>, 2> indexedBuffers; // of uniform and shader storage blocks, by binding point
 };
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "OpenGLIndexBuffer.h"
 
+#include "OpenGLGraphicsAPI.h"
+
 #include <glad/glad.h>
 
 #include <vector>
@@ -9,7 +11,7 @@ OpenGLIndexBuffer::OpenGLIndexBuffer() {
 }
 
 OpenGLIndexBuffer::~OpenGLIndexBuffer() {
-	glDeleteBuffers(1, &rendererID);
+	OpenGLGraphicsAPI::DeleteBuffer(rendererID);
 }
 
 void OpenGLIndexBuffer::Bind() const {
@@ -17,11 +19,26 @@ void OpenGLIndexBuffer::Bind() const {
 }
 
 void OpenGLIndexBuffer::Unbind() const {
+    OpenGLGraphicsAPI::BindVertexArray(0); // else the bound vertex array would lose its element buffer
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
-void OpenGLIndexBuffer::UploadIndices(const std::vector<unsigned int>& indices) {
+// The element buffer binding is state of the bound vertex array, which must not get this buffer just because it is being uploaded
+void OpenGLIndexBuffer::BindForUpload() const {
+    OpenGLGraphicsAPI::BindVertexArray(0);
     Bind();
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
-    numIndices = indices.size();
+}
+
+void OpenGLIndexBuffer::UploadIndices(const unsigned int* indices, size_t numIndices) {
+    BindForUpload();
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * numIndices, indices, GL_STATIC_DRAW);
+    this->numIndices = numIndices;
+    indexType = IndexType::uint32;
+}
+
+void OpenGLIndexBuffer::UploadIndices(const unsigned short* indices, size_t numIndices) {
+    BindForUpload();
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * numIndices, indices, GL_STATIC_DRAW);
+    this->numIndices = numIndices;
+    indexType = IndexType::uint16;
 }
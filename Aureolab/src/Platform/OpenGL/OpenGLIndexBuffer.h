@@ -12,9 +12,17 @@ public:
 	virtual void Bind() const override;
 	virtual void Unbind() const override;
 
-	virtual void UploadIndices(const std::vector<unsigned int>& indices) override;
+	virtual unsigned int GetRendererID() const override { return rendererID; }
+
+	using IndexBuffer::UploadIndices;
+	virtual void UploadIndices(const unsigned int* indices, size_t numIndices) override;
+	virtual void UploadIndices(const unsigned short* indices, size_t numIndices) override;
 	virtual const size_t GetNumIndices() const override { return numIndices; };
+	virtual IndexType GetIndexType() const override { return indexType; }
 private:
+	void BindForUpload() const;
+
 	unsigned int rendererID = -1;
 	size_t numIndices = 0;
+	IndexType indexType = IndexType::uint32;
 };
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "OpenGLOcclusionCuller.h"
+
+#include "OpenGLGraphicsAPI.h"
+
+#include "Core/Log.h"
+#include "Renderer/Renderer.h"
+
+#include <cassert>
+
+static constexpr UniformHandle uViewProjection = "u_ViewProjection"_uniform;
+static constexpr UniformHandle uBoxCenter = "u_BoxCenter"_uniform;
+static constexpr UniformHandle uBoxExtent = "u_BoxExtent"_uniform;
+
+OpenGLOcclusionCuller::OpenGLOcclusionCuller(Shader* downsampleShader, Shader* boxShader)
+	: downsampleShader(downsampleShader), boxShader(boxShader) {
+	assert(downsampleShader != nullptr && boxShader != nullptr);
+	for (Readback& readback : readbacks) { glGenBuffers(1, &readback.bufferID); }
+}
+
+OpenGLOcclusionCuller::~OpenGLOcclusionCuller() {
+	for (Readback& readback : readbacks) {
+		if (readback.fence != nullptr) { glDeleteSync(readback.fence); }
+		OpenGLGraphicsAPI::DeleteBuffer(readback.bufferID);
+	}
+	if (tilesID != 0) { glDeleteTextures(1, &tilesID); }
+	if (!queries.empty()) { glDeleteQueries((GLsizei)queries.size(), queries.data()); }
+	delete emptyVao;
+}
+
+void OpenGLOcclusionCuller::Capture(const FrameBuffer& fbo, const glm::mat4& viewProjection) {
+	Readback& readback = readbacks[next];
+	if (readback.fence != nullptr) { return; }
+	const int width = (fbo.GetWidth() + tileSize - 1) / tileSize;
+	const int height = (fbo.GetHeight() + tileSize - 1) / tileSize;
+	if (width <= 0 || height <= 0) { return; }
+
+	if (width != tilesWidth || height != tilesHeight) {
+		// Copies from the old texture in flight keep it alive until they are done
+		if (tilesID != 0) { glDeleteTextures(1, &tilesID); }
+		glGenTextures(1, &tilesID);
+		glBindTexture(GL_TEXTURE_2D, tilesID);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32F, width, height);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		tilesWidth = width;
+		tilesHeight = height;
+	}
+
+	downsampleShader->Bind();
+	downsampleShader->UploadUniformInt("u_TileSize", tileSize);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, fbo.GetDepthAttachmentRendererID());
+	glBindImageTexture(0, tilesID, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+	glDispatchCompute((width + 7) / 8, (height + 7) / 8, 1); // local size of DepthDownsample.glsl
+	glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+	glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+	downsampleShader->Unbind();
+
+	const unsigned int size = width * height * sizeof(float);
+	OpenGLGraphicsAPI::BindBuffer(GL_PIXEL_PACK_BUFFER, readback.bufferID);
+	if (readback.size < size) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		readback.size = size;
+	}
+	glBindTexture(GL_TEXTURE_2D, tilesID);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT, nullptr); // into the pack buffer, returns without waiting
+	glBindTexture(GL_TEXTURE_2D, 0);
+	OpenGLGraphicsAPI::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.width = width;
+	readback.height = height;
+	readback.fboWidth = fbo.GetWidth();
+	readback.fboHeight = fbo.GetHeight();
+	readback.viewProjection = viewProjection;
+	next = (next + 1) % numReadbacks;
+}
+
+void OpenGLOcclusionCuller::Fetch() {
+	// Readbacks finish in order, so stop at the first one still in flight and use only the newest finished one
+	Readback* newest = nullptr;
+	for (int i = 0; i < numReadbacks; i++) {
+		Readback& readback = readbacks[(next + i) % numReadbacks];
+		if (readback.fence == nullptr) { continue; }
+		const GLenum result = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (result == GL_TIMEOUT_EXPIRED) { break; }
+		if (result == GL_WAIT_FAILED) { Log::Error("Waiting for depth readback failed"); }
+		glDeleteSync(readback.fence);
+		readback.fence = nullptr;
+		newest = &readback;
+	}
+	if (newest == nullptr) { return; }
+
+	OpenGLGraphicsAPI::BindBuffer(GL_PIXEL_PACK_BUFFER, newest->bufferID);
+	const unsigned int size = newest->width * newest->height * sizeof(float);
+	const float* tiles = (const float*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	if (tiles != nullptr) {
+		SetBase(tiles, newest->width, newest->height, newest->fboWidth, newest->fboHeight, newest->viewProjection);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	OpenGLGraphicsAPI::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void OpenGLOcclusionCuller::TestBoxes(const SlotBounds& bounds, const glm::mat4& viewProjection, const std::vector<uint32_t>& slots) {
+	if (queries.size() < slots.size()) {
+		const size_t numQueries = queries.size();
+		queries.resize(slots.size());
+		glGenQueries((GLsizei)(slots.size() - numQueries), queries.data() + numQueries);
+	}
+	if (emptyVao == nullptr) { emptyVao = VertexArray::Create(); }
+
+	// Only the depth test counts, and the camera is outside of every box, so both sides are drawn and nothing is written
+	GraphicsAPI* api = GraphicsAPI::Get();
+	const PipelineState drawState = api->GetPipelineState();
+	PipelineState testState = drawState;
+	testState.SetEnabled(GraphicsAbility::DepthTest, true);
+	testState.SetEnabled(GraphicsAbility::FaceCulling, false);
+	testState.polygonMode = PolygonMode::Fill;
+	testState.stencilWriteMask = 0x00;
+	api->SetPipelineState(testState);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+
+	boxShader->Bind();
+	boxShader->UploadUniformMat4(uViewProjection, viewProjection);
+	for (size_t ix = 0; ix < slots.size(); ix++) {
+		const uint32_t slot = slots[ix];
+		boxShader->UploadUniformFloat3(uBoxCenter, { bounds.boxX[slot], bounds.boxY[slot], bounds.boxZ[slot] });
+		boxShader->UploadUniformFloat3(uBoxExtent, { bounds.extentX[slot], bounds.extentY[slot], bounds.extentZ[slot] });
+		glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, queries[ix]);
+		api->DrawArrayTriangles(*emptyVao, 0, 36);
+		glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+		Renderer::stats.numDrawCalls++;
+	}
+	boxShader->Unbind();
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_TRUE);
+	api->SetPipelineState(drawState);
+}
+
+void OpenGLOcclusionCuller::BeginConditionalDraw(size_t test) {
+	// Waits for the query on the GPU, which has it right after the box, instead of drawing regardless
+	glBeginConditionalRender(queries[test], GL_QUERY_WAIT);
+}
+
+void OpenGLOcclusionCuller::EndConditionalDraw() {
+	glEndConditionalRender();
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Renderer/OcclusionCuller.h"
+#include "Renderer/VertexArray.h"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <vector>
+
+// The tiles are written by a compute shader into an R32F texture and copied into a ring of pixel pack buffers, each fenced,
+// and mapped only once its fence has signaled. While all buffers are in flight, the depth of the frame is not captured.
+// Boxes are tested with conservative any-samples-passed queries, and the draws of each wait for its result on the GPU with conditional rendering.
+class OpenGLOcclusionCuller : public OcclusionCuller {
+public:
+	OpenGLOcclusionCuller(Shader* downsampleShader, Shader* boxShader);
+	~OpenGLOcclusionCuller();
+
+	virtual void Capture(const FrameBuffer& fbo, const glm::mat4& viewProjection) override;
+
+protected:
+	virtual void Fetch() override;
+	virtual void TestBoxes(const SlotBounds& bounds, const glm::mat4& viewProjection, const std::vector<uint32_t>& slots) override;
+	virtual void BeginConditionalDraw(size_t test) override;
+	virtual void EndConditionalDraw() override;
+
+private:
+	struct Readback {
+		GLuint bufferID = 0;
+		unsigned int size = 0;
+		GLsync fence = nullptr;
+		int width = 0;
+		int height = 0;
+		int fboWidth = 0;
+		int fboHeight = 0;
+		glm::mat4 viewProjection = glm::mat4(1.0f);
+	};
+	static constexpr int numReadbacks = 3;
+
+	Shader* downsampleShader = nullptr;
+	GLuint tilesID = 0;
+	int tilesWidth = 0;
+	int tilesHeight = 0;
+	std::array<Readback, numReadbacks> readbacks;
+	int next = 0; // readback the next capture goes to, the oldest in flight when it has a fence
+
+	Shader* boxShader = nullptr;
+	VertexArray* emptyVao = nullptr; // the boxes have no vertex buffers, created on first use
+	std::vector<GLuint> queries; // one per tested box, grown as needed
+};
\ No newline at end of file
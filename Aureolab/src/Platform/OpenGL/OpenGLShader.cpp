@@ -1,11 +1,15 @@
 #include "OpenGLShader.h"
 
+#include "OpenGLGraphicsAPI.h"
 #include "Core/Log.h"
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 
 OpenGLShader::OpenGLShader(const std::string& filepath) 
@@ -14,7 +18,7 @@ OpenGLShader::OpenGLShader(const std::string& filepath)
 }
 
 OpenGLShader::~OpenGLShader() {
-	glDeleteProgram(rendererID);
+	OpenGLGraphicsAPI::DeleteProgram(rendererID);
 }
 
 void OpenGLShader::Recompile() {
@@ -24,75 +28,125 @@ void OpenGLShader::Recompile() {
 }
 
 void OpenGLShader::Bind() const {
-	glUseProgram(rendererID);
+	OpenGLGraphicsAPI::UseProgram(rendererID);
 }
 
 void OpenGLShader::Unbind() const {
-	glUseProgram(0);
+	OpenGLGraphicsAPI::UseProgram(0);
 }
 
 unsigned int OpenGLShader::GetAttribLocation(const std::string& name) {
 	return glGetAttribLocation(rendererID, name.c_str());
 }
 
-void OpenGLShader::UploadUniformInt(const std::string& name, int value) {
-	GLint location = glGetUniformLocation(rendererID, name.c_str());
-	glUniform1i(location, value);
+void OpenGLShader::BindUniformBlock(const std::string& blockName, unsigned int bindingPoint) {
+	auto it = uniformBlocks.find(blockName);
+	assert(it != uniformBlocks.end()); // uniform block is not used in this shader program
+	if (it == uniformBlocks.end()) { return; }
+	glUniformBlockBinding(rendererID, it->second, bindingPoint);
+	blockBindings[blockName] = bindingPoint;
 }
 
-void OpenGLShader::UploadUniformFloat(const std::string& name, float value) {
-	GLint location = glGetUniformLocation(rendererID, name.c_str());
-	glUniform1f(location, value);
+void OpenGLShader::BindStorageBlock(const std::string& blockName, unsigned int bindingPoint) {
+	auto it = storageBlocks.find(blockName);
+	assert(it != storageBlocks.end()); // storage block is not used in this shader program
+	if (it == storageBlocks.end()) { return; }
+	glShaderStorageBlockBinding(rendererID, it->second, bindingPoint);
+	storageBlockBindings[blockName] = bindingPoint;
 }
 
-void OpenGLShader::UploadUniformFloat2(const std::string& name, const glm::vec2& values) {
-	GLint location = glGetUniformLocation(rendererID, name.c_str());
-	glUniform2f(location, values.x, values.y);
+bool OpenGLShader::Uniform::Remember(const void* value, size_t size) {
+	assert(size <= lastValue.size());
+	if (!isCached) { return true; }
+	if (lastValueSize == size && std::memcmp(lastValue.data(), value, size) == 0) { return false; }
+	std::memcpy(lastValue.data(), value, size);
+	lastValueSize = size;
+	return true;
 }
 
-void OpenGLShader::UploadUniformFloat3(const std::string& name, const glm::vec3& values) {
-	GLint location = glGetUniformLocation(rendererID, name.c_str());
-	glUniform3f(location, values.x, values.y, values.z);
+OpenGLShader::Uniform* OpenGLShader::FindUniform(UniformHandle handle) {
+	auto it = uniforms.find(handle.hash);
+	if (it == uniforms.end()) { return nullptr; } // not in the shader, or optimized out
+	assert(it->second.name == handle.name); // hash collision with a name that is not in the shader
+	return &it->second;
 }
 
-void OpenGLShader::UploadUniformFloat4(const std::string& name, const glm::vec4& values) {
-	GLint location = glGetUniformLocation(rendererID, name.c_str());
-	glUniform4f(location, values.x, values.y, values.z, values.w);
+void OpenGLShader::UploadUniformInt(UniformHandle handle, int value) {
+	Uniform* uniform = FindUniform(handle);
+	if (uniform == nullptr || !uniform->Remember(&value, sizeof(value))) { return; }
+	glUniform1i(uniform->location, value);
 }
 
-void OpenGLShader::UploadUniformMat2(const std::string& name, const glm::mat2& matrix) {
-	GLint location = glGetUniformLocation(rendererID, name.c_str());
-	glUniformMatrix2fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+void OpenGLShader::UploadUniformFloat(UniformHandle handle, float value) {
+	Uniform* uniform = FindUniform(handle);
+	if (uniform == nullptr || !uniform->Remember(&value, sizeof(value))) { return; }
+	glUniform1f(uniform->location, value);
 }
 
-void OpenGLShader::UploadUniformMat3(const std::string& name, const glm::mat3& matrix) {
-	GLint location = glGetUniformLocation(rendererID, name.c_str());
-	glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+void OpenGLShader::UploadUniformFloat2(UniformHandle handle, const glm::vec2& values) {
+	Uniform* uniform = FindUniform(handle);
+	if (uniform == nullptr || !uniform->Remember(&values, sizeof(values))) { return; }
+	glUniform2f(uniform->location, values.x, values.y);
 }
 
-void OpenGLShader::UploadUniformMat4(const std::string& name, const glm::mat4& matrix) {
-	GLint location = glGetUniformLocation(rendererID, name.c_str());
-	glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
+void OpenGLShader::UploadUniformFloat3(UniformHandle handle, const glm::vec3& values) {
+	Uniform* uniform = FindUniform(handle);
+	if (uniform == nullptr || !uniform->Remember(&values, sizeof(values))) { return; }
+	glUniform3f(uniform->location, values.x, values.y, values.z);
 }
 
-void OpenGLShader::UploadUniformFloats(const std::string& name, const std::vector<float>& values) {
-	GLint location = glGetUniformLocation(rendererID, name.c_str());
-	glUniform1fv(location, (GLsizei)values.size(), values.data());
+void OpenGLShader::UploadUniformFloat4(UniformHandle handle, const glm::vec4& values) {
+	Uniform* uniform = FindUniform(handle);
+	if (uniform == nullptr || !uniform->Remember(&values, sizeof(values))) { return; }
+	glUniform4f(uniform->location, values.x, values.y, values.z, values.w);
 }
 
-void OpenGLShader::UploadUniformFloat2s(const std::string& name, const std::vector<glm::vec2>& values) {
-	GLint location = glGetUniformLocation(rendererID, name.c_str());
-	glUniform2fv(location, (GLsizei)values.size() * 2, glm::value_ptr(values.data()[0]));
+void OpenGLShader::UploadUniformMat2(UniformHandle handle, const glm::mat2& matrix) {
+	Uniform* uniform = FindUniform(handle);
+	if (uniform == nullptr || !uniform->Remember(&matrix, sizeof(matrix))) { return; }
+	glUniformMatrix2fv(uniform->location, 1, GL_FALSE, glm::value_ptr(matrix));
 }
 
-void OpenGLShader::UploadUniformFloat3s(const std::string& name, const std::vector<glm::vec3>& values) {
-	GLint location = glGetUniformLocation(rendererID, name.c_str());
-	glUniform3fv(location, (GLsizei)values.size() * 3, glm::value_ptr(values.data()[0]));
+void OpenGLShader::UploadUniformMat3(UniformHandle handle, const glm::mat3& matrix) {
+	Uniform* uniform = FindUniform(handle);
+	if (uniform == nullptr || !uniform->Remember(&matrix, sizeof(matrix))) { return; }
+	glUniformMatrix3fv(uniform->location, 1, GL_FALSE, glm::value_ptr(matrix));
 }
 
-void OpenGLShader::UploadUniformFloat4s(const std::string& name, const std::vector<glm::vec4>& values) {
-	GLint location = glGetUniformLocation(rendererID, name.c_str());
-	glUniform4fv(location, (GLsizei)values.size() * 4, glm::value_ptr(values.data()[0]));
+void OpenGLShader::UploadUniformMat4(UniformHandle handle, const glm::mat4& matrix) {
+	Uniform* uniform = FindUniform(handle);
+	if (uniform == nullptr || !uniform->Remember(&matrix, sizeof(matrix))) { return; }
+	glUniformMatrix4fv(uniform->location, 1, GL_FALSE, glm::value_ptr(matrix));
+}
+
+// Arrays are not compared with the last upload, they are always sent
+
+void OpenGLShader::UploadUniformFloats(UniformHandle handle, const std::vector<float>& values) {
+	Uniform* uniform = FindUniform(handle);
+	if (uniform == nullptr) { return; }
+	uniform->lastValueSize = 0;
+	glUniform1fv(uniform->location, (GLsizei)values.size(), values.data());
+}
+
+void OpenGLShader::UploadUniformFloat2s(UniformHandle handle, const std::vector<glm::vec2>& values) {
+	Uniform* uniform = FindUniform(handle);
+	if (uniform == nullptr) { return; }
+	uniform->lastValueSize = 0;
+	glUniform2fv(uniform->location, (GLsizei)values.size() * 2, glm::value_ptr(values.data()[0]));
+}
+
+void OpenGLShader::UploadUniformFloat3s(UniformHandle handle, const std::vector<glm::vec3>& values) {
+	Uniform* uniform = FindUniform(handle);
+	if (uniform == nullptr) { return; }
+	uniform->lastValueSize = 0;
+	glUniform3fv(uniform->location, (GLsizei)values.size() * 3, glm::value_ptr(values.data()[0]));
+}
+
+void OpenGLShader::UploadUniformFloat4s(UniformHandle handle, const std::vector<glm::vec4>& values) {
+	Uniform* uniform = FindUniform(handle);
+	if (uniform == nullptr) { return; }
+	uniform->lastValueSize = 0;
+	glUniform4fv(uniform->location, (GLsizei)values.size() * 4, glm::value_ptr(values.data()[0]));
 }
 
 std::string OpenGLShader::ReadFile(const std::string& filepath) {
@@ -108,6 +162,8 @@ static GLenum ShaderTypeFromString(const std::string& type) {
 		return GL_FRAGMENT_SHADER;
 	if (type == "geometry")
 		return GL_GEOMETRY_SHADER;
+	if (type == "compute")
+		return GL_COMPUTE_SHADER;
 
 	assert(false); // Unknown shader type
 	return 0;
@@ -133,13 +189,43 @@ std::unordered_map<GLenum, std::string> OpenGLShader::PreProcess(const std::stri
 			source.substr(nextLinePos, pos - nextLinePos);
 	}
 
+	const std::string directory = std::filesystem::path(filepath).parent_path().string();
+	for (auto& [type, stageSource] : shaderSources) {
+		std::unordered_set<std::string> includedPaths;
+		stageSource = ResolveIncludes(stageSource, directory, includedPaths);
+	}
 	return shaderSources;
 }
 
+std::string OpenGLShader::ResolveIncludes(const std::string& source, const std::string& directory, std::unordered_set<std::string>& includedPaths) {
+	const char* includeToken = "#include";
+	std::string resolved;
+	size_t lineBegin = 0;
+	while (lineBegin < source.size()) {
+		size_t lineEnd = source.find('\n', lineBegin);
+		lineEnd = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+		const std::string line = source.substr(lineBegin, lineEnd - lineBegin);
+		lineBegin = lineEnd;
+		if (line.rfind(includeToken, 0) != 0) {
+			resolved += line;
+			continue;
+		}
+		const size_t open = line.find('"');
+		const size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+		assert(close != std::string::npos); // Syntax Error, expected #include "path"
+		if (close == std::string::npos) { continue; }
+		const std::filesystem::path path = (std::filesystem::path(directory) / line.substr(open + 1, close - open - 1)).lexically_normal();
+		if (!includedPaths.insert(path.generic_string()).second) { continue; }
+		resolved += ResolveIncludes(ReadFile(path.string()), path.parent_path().string(), includedPaths);
+		resolved += "\n";
+	}
+	return resolved;
+}
+
 void OpenGLShader::Compile(std::unordered_map<GLenum, std::string>& shaderSources) {
 	// Stores Shader/Program ID until shader compilation/linking succeeds and stored in rendererID
 	GLuint program = glCreateProgram();
-	assert(shaderSources.size() <= 3); // We only support a geometry, a vertex and a fragment shaders for now.
+	assert(shaderSources.size() <= 3); // We only support a geometry, a vertex and a fragment shaders, or a compute shader, for now.
 	std::array<GLenum, 3> glShaderIDs;
 	int glShaderIdIndex = 0;
 	for (auto& kv : shaderSources) {
@@ -207,7 +293,80 @@ void OpenGLShader::Compile(std::unordered_map<GLenum, std::string>& shaderSource
 
 	// Delete old program associated with this Shader object.
 	if (rendererID != -1) {
-		glDeleteProgram(rendererID);
+		OpenGLGraphicsAPI::DeleteProgram(rendererID);
 	}
 	rendererID = program;
+	Reflect();
+}
+
+void OpenGLShader::Reflect() {
+	uniforms.clear();
+	uniformBlocks.clear();
+	storageBlocks.clear();
+
+	GLint numUniforms = 0;
+	GLint maxNameLength = 0;
+	glGetProgramiv(rendererID, GL_ACTIVE_UNIFORMS, &numUniforms);
+	glGetProgramiv(rendererID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	std::vector<GLchar> nameBuffer(std::max(maxNameLength, 1));
+	auto addUniform = [this](const std::string& name, GLint location, GLenum type, bool isCached) {
+		auto [it, isInserted] = uniforms.emplace(UniformHandle::Hash(name), Uniform{ name, location, type, isCached });
+		if (!isInserted) { Log::Error("Uniforms {} and {} of {} have the same hash. Rename one of them.", it->second.name, name, filepath); }
+		assert(isInserted);
+	};
+	for (GLint ix = 0; ix < numUniforms; ix++) {
+		GLsizei nameLength = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(rendererID, (GLuint)ix, (GLsizei)nameBuffer.size(), &nameLength, &size, &type, nameBuffer.data());
+		std::string name(nameBuffer.data(), nameLength);
+		GLint location = glGetUniformLocation(rendererID, name.c_str());
+		if (location == -1) { continue; } // member of a uniform block
+
+		// Arrays are reported as "name[0]". Make the array reachable by its name and each element by "name[i]".
+		// Their values are not cached, since the array and its elements alias each other.
+		const size_t bracket = name.rfind("[0]");
+		const bool isArray = bracket != std::string::npos && bracket + 3 == name.size();
+		if (isArray) {
+			const std::string arrayName = name.substr(0, bracket);
+			addUniform(arrayName, location, type, false);
+			for (GLint element = 1; element < size; element++) {
+				const std::string elementName = arrayName + "[" + std::to_string(element) + "]";
+				addUniform(elementName, glGetUniformLocation(rendererID, elementName.c_str()), type, false);
+			}
+		}
+		addUniform(name, location, type, !isArray);
+	}
+
+	GLint numBlocks = 0;
+	GLint maxBlockNameLength = 0;
+	glGetProgramiv(rendererID, GL_ACTIVE_UNIFORM_BLOCKS, &numBlocks);
+	glGetProgramiv(rendererID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockNameLength);
+	nameBuffer.resize(std::max(maxBlockNameLength, 1));
+	for (GLint ix = 0; ix < numBlocks; ix++) {
+		GLsizei nameLength = 0;
+		glGetActiveUniformBlockName(rendererID, (GLuint)ix, (GLsizei)nameBuffer.size(), &nameLength, nameBuffer.data());
+		uniformBlocks[std::string(nameBuffer.data(), nameLength)] = (GLuint)ix;
+	}
+	// A new program starts with all blocks at binding point 0
+	for (const auto& [blockName, bindingPoint] : blockBindings) {
+		auto it = uniformBlocks.find(blockName);
+		if (it != uniformBlocks.end()) { glUniformBlockBinding(rendererID, it->second, bindingPoint); }
+	}
+
+	GLint numStorageBlocks = 0;
+	GLint maxStorageBlockNameLength = 0;
+	glGetProgramInterfaceiv(rendererID, GL_SHADER_STORAGE_BLOCK, GL_ACTIVE_RESOURCES, &numStorageBlocks);
+	glGetProgramInterfaceiv(rendererID, GL_SHADER_STORAGE_BLOCK, GL_MAX_NAME_LENGTH, &maxStorageBlockNameLength);
+	nameBuffer.resize(std::max(maxStorageBlockNameLength, 1));
+	for (GLint ix = 0; ix < numStorageBlocks; ix++) {
+		GLsizei nameLength = 0;
+		glGetProgramResourceName(rendererID, GL_SHADER_STORAGE_BLOCK, (GLuint)ix, (GLsizei)nameBuffer.size(), &nameLength, nameBuffer.data());
+		storageBlocks[std::string(nameBuffer.data(), nameLength)] = (GLuint)ix;
+	}
+	for (const auto& [blockName, bindingPoint] : storageBlockBindings) {
+		auto it = storageBlocks.find(blockName);
+		if (it != storageBlocks.end()) { glShaderStorageBlockBinding(rendererID, it->second, bindingPoint); }
+	}
+	Log::Debug("Reflected {} uniforms, {} uniform blocks and {} storage blocks of {}", uniforms.size(), uniformBlocks.size(), storageBlocks.size(), filepath);
 }
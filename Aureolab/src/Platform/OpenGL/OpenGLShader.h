@@ -2,8 +2,11 @@
 
 #include <glad/glad.h>
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 class OpenGLShader : public Shader {
 public:
@@ -17,26 +20,66 @@ public:
 	virtual unsigned int GetRendererID() const override { return rendererID; };
 
 	virtual unsigned int GetAttribLocation(const std::string& name) override;
+	virtual void BindUniformBlock(const std::string& blockName, unsigned int bindingPoint) override;
+	virtual void BindStorageBlock(const std::string& blockName, unsigned int bindingPoint) override;
 
-	virtual void UploadUniformInt(const std::string& name, int value) override;
-	virtual void UploadUniformFloat(const std::string& name, float value) override;
-	virtual void UploadUniformFloat2(const std::string& name, const glm::vec2& values) override;
-	virtual void UploadUniformFloat3(const std::string& name, const glm::vec3& values) override;
-	virtual void UploadUniformFloat4(const std::string& name, const glm::vec4& values) override;
+	using Shader::UploadUniformInt;
+	using Shader::UploadUniformFloat;
+	using Shader::UploadUniformFloat2;
+	using Shader::UploadUniformFloat3;
+	using Shader::UploadUniformFloat4;
+	using Shader::UploadUniformMat2;
+	using Shader::UploadUniformMat3;
+	using Shader::UploadUniformMat4;
+	using Shader::UploadUniformFloats;
+	using Shader::UploadUniformFloat2s;
+	using Shader::UploadUniformFloat3s;
+	using Shader::UploadUniformFloat4s;
 
-	virtual void UploadUniformMat2(const std::string& name, const glm::mat2& matrix) override;
-	virtual void UploadUniformMat3(const std::string& name, const glm::mat3& matrix) override;
-	virtual void UploadUniformMat4(const std::string& name, const glm::mat4& matrix) override;
+	virtual void UploadUniformInt(UniformHandle handle, int value) override;
+	virtual void UploadUniformFloat(UniformHandle handle, float value) override;
+	virtual void UploadUniformFloat2(UniformHandle handle, const glm::vec2& values) override;
+	virtual void UploadUniformFloat3(UniformHandle handle, const glm::vec3& values) override;
+	virtual void UploadUniformFloat4(UniformHandle handle, const glm::vec4& values) override;
 
-	virtual void UploadUniformFloats(const std::string& name, const std::vector<float>& values) override;
-	virtual void UploadUniformFloat2s(const std::string& name, const std::vector<glm::vec2>& values) override;
-	virtual void UploadUniformFloat3s(const std::string& name, const std::vector<glm::vec3>& values) override;
-	virtual void UploadUniformFloat4s(const std::string& name, const std::vector<glm::vec4>& values) override;
+	virtual void UploadUniformMat2(UniformHandle handle, const glm::mat2& matrix) override;
+	virtual void UploadUniformMat3(UniformHandle handle, const glm::mat3& matrix) override;
+	virtual void UploadUniformMat4(UniformHandle handle, const glm::mat4& matrix) override;
+
+	virtual void UploadUniformFloats(UniformHandle handle, const std::vector<float>& values) override;
+	virtual void UploadUniformFloat2s(UniformHandle handle, const std::vector<glm::vec2>& values) override;
+	virtual void UploadUniformFloat3s(UniformHandle handle, const std::vector<glm::vec3>& values) override;
+	virtual void UploadUniformFloat4s(UniformHandle handle, const std::vector<glm::vec4>& values) override;
 
 	static std::string ReadFile(const std::string& filepath);
 private:
+	// An active uniform, reflected after linking, and the last value uploaded to it
+	struct Uniform {
+		std::string name;
+		GLint location = -1;
+		GLenum type = 0;
+		bool isCached = true; // false for arrays and their elements
+		std::array<unsigned char, sizeof(glm::mat4)> lastValue = {};
+		size_t lastValueSize = 0; // 0 when unknown
+
+		// Stores value as the last one. Returns false if it already was, i.e. when the upload can be skipped.
+		bool Remember(const void* value, size_t size);
+	};
+
 	unsigned int rendererID = -1;
 	std::string filepath;
+	std::unordered_map<uint32_t, Uniform> uniforms; // by UniformHandle::Hash of their names
+	std::unordered_map<std::string, GLuint> uniformBlocks; // block indices by name
+	std::unordered_map<std::string, unsigned int> blockBindings; // binding points by block name, to restore after recompilation
+	std::unordered_map<std::string, GLuint> storageBlocks; // shader storage block indices by name
+	std::unordered_map<std::string, unsigned int> storageBlockBindings;
+	// Splits the file into the sources of its stages, and resolves the includes of each
 	std::unordered_map<GLenum, std::string> PreProcess(const std::string& source);
+	// Replaces lines #include "path" with the content of the file at path, relative to directory, the one of the including file.
+	// A file is included once per stage, later includes of it are dropped.
+	static std::string ResolveIncludes(const std::string& source, const std::string& directory, std::unordered_set<std::string>& includedPaths);
 	void Compile(std::unordered_map<GLenum, std::string>& shaderSources);
+	// Fills uniforms, uniformBlocks and storageBlocks from the linked program
+	void Reflect();
+	Uniform* FindUniform(UniformHandle handle);
 };
\ No newline at end of file
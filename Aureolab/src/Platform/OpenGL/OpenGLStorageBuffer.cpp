@@ -0,0 +1,119 @@
+#include "OpenGLStorageBuffer.h"
+
+#include "OpenGLGraphicsAPI.h"
+
+#include "Core/Log.h"
+
+#include <algorithm>
+#include <cassert>
+
+static constexpr GLbitfield stagingFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+OpenGLStorageBuffer::OpenGLStorageBuffer(const std::string& name, unsigned int size)
+	: name(name), size(size) {
+	assert(size > 0);
+	bindingPoint = OpenGLStorageBuffer::bindingPointCounter++;
+
+	glGenBuffers(1, &rendererID);
+	OpenGLGraphicsAPI::BindBuffer(GL_SHADER_STORAGE_BUFFER, rendererID);
+	glBufferStorage(GL_SHADER_STORAGE_BUFFER, size, nullptr, 0); // only written by copies
+	OpenGLGraphicsAPI::BindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, rendererID);
+	CreateStaging(size);
+}
+
+OpenGLStorageBuffer::~OpenGLStorageBuffer() {
+	for (GLsync fence : fences) { if (fence != nullptr) { glDeleteSync(fence); } }
+	OpenGLGraphicsAPI::DeleteBuffer(stagingID);
+	OpenGLGraphicsAPI::DeleteBuffer(rendererID);
+}
+
+void OpenGLStorageBuffer::BlockBind(Shader* shader) {
+	shader->BindStorageBlock(name, bindingPoint);
+	OpenGLGraphicsAPI::BindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, rendererID);
+}
+
+void OpenGLStorageBuffer::Reserve(unsigned int newSize) {
+	if (newSize <= size) { return; }
+	IssueCopies(); // they target the old buffer
+	newSize = std::max(newSize, size * 2);
+
+	GLuint newID = 0;
+	glGenBuffers(1, &newID);
+	OpenGLGraphicsAPI::BindBuffer(GL_COPY_WRITE_BUFFER, newID);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, newSize, nullptr, 0);
+	OpenGLGraphicsAPI::BindBuffer(GL_COPY_READ_BUFFER, rendererID);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+	OpenGLGraphicsAPI::DeleteBuffer(rendererID); // freed by the driver once the copy is done
+	rendererID = newID;
+	size = newSize;
+	OpenGLGraphicsAPI::BindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, rendererID);
+}
+
+void* OpenGLStorageBuffer::Stage(unsigned int offset, unsigned int writeSize) {
+	assert(offset + writeSize <= size);
+	if (segmentHead + writeSize > segmentSize) {
+		IssueCopies();
+		if (writeSize > segmentSize) { CreateStaging(std::max(writeSize, segmentSize * 2)); }
+		else { NextSegment(); }
+	}
+	if (segmentHead == 0) { WaitForSegment(); }
+
+	const unsigned int stagingOffset = segment * segmentSize + segmentHead;
+	copies.push_back({ stagingOffset, offset, writeSize });
+	segmentHead += writeSize;
+	return stagingData + stagingOffset;
+}
+
+void OpenGLStorageBuffer::Flush() {
+	IssueCopies();
+	NextSegment();
+}
+
+void OpenGLStorageBuffer::CreateStaging(unsigned int newSegmentSize) {
+	// Deleting a buffer with copies in flight is fine, the driver keeps it until they are done
+	if (stagingData != nullptr) { OpenGLGraphicsAPI::DeleteBuffer(stagingID); }
+	for (GLsync& fence : fences) {
+		if (fence != nullptr) { glDeleteSync(fence); }
+		fence = nullptr;
+	}
+	segmentSize = newSegmentSize;
+	segment = 0;
+	segmentHead = 0;
+
+	glGenBuffers(1, &stagingID);
+	OpenGLGraphicsAPI::BindBuffer(GL_COPY_READ_BUFFER, stagingID);
+	glBufferStorage(GL_COPY_READ_BUFFER, segmentSize * numSegments, nullptr, stagingFlags);
+	stagingData = (unsigned char*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, segmentSize * numSegments, stagingFlags);
+	assert(stagingData != nullptr);
+	Log::Debug("Staging ring of storage buffer {} is {} bytes", name, segmentSize * numSegments);
+}
+
+void OpenGLStorageBuffer::IssueCopies() {
+	if (copies.empty()) { return; }
+	OpenGLGraphicsAPI::BindBuffer(GL_COPY_READ_BUFFER, stagingID);
+	OpenGLGraphicsAPI::BindBuffer(GL_COPY_WRITE_BUFFER, rendererID);
+	for (const Copy& copy : copies) {
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, copy.stagingOffset, copy.offset, copy.size);
+	}
+	copies.clear();
+}
+
+void OpenGLStorageBuffer::NextSegment() {
+	if (segmentHead == 0) { return; } // nothing to fence, keep using it
+	assert(fences[segment] == nullptr);
+	fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	segment = (segment + 1) % numSegments;
+	segmentHead = 0;
+}
+
+void OpenGLStorageBuffer::WaitForSegment() {
+	GLsync& fence = fences[segment];
+	if (fence == nullptr) { return; }
+	GLenum result = GL_TIMEOUT_EXPIRED;
+	while (result == GL_TIMEOUT_EXPIRED) {
+		result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+	}
+	if (result == GL_WAIT_FAILED) { Log::Error("Waiting for staging segment {} of storage buffer {} failed", segment, name); }
+	glDeleteSync(fence);
+	fence = nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Renderer/StorageBuffer.h"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <vector>
+
+// The staging memory is a persistently mapped ring of segments. Each frame writes into one segment,
+// which is fenced at Flush and written again only after the GPU has signaled that fence.
+class OpenGLStorageBuffer : public StorageBuffer {
+public:
+	OpenGLStorageBuffer(const std::string& name, unsigned int size);
+	~OpenGLStorageBuffer();
+
+	virtual void BlockBind(Shader* shader) override;
+	virtual unsigned int GetRendererID() const override { return rendererID; }
+
+	virtual void Reserve(unsigned int size) override;
+	virtual unsigned int GetSize() const override { return size; }
+
+	virtual void* Stage(unsigned int offset, unsigned int size) override;
+	virtual void Flush() override;
+
+private:
+	struct Copy {
+		unsigned int stagingOffset;
+		unsigned int offset;
+		unsigned int size;
+	};
+
+	void CreateStaging(unsigned int segmentSize);
+	void IssueCopies();
+	// Fences the current segment and moves on to the next one
+	void NextSegment();
+	// Blocks until the GPU is done with the copies out of the current segment
+	void WaitForSegment();
+
+	static constexpr int numSegments = 3; // frames the CPU may run ahead of the GPU
+
+	unsigned int rendererID = -1;
+	std::string name;
+	unsigned int size = 0;
+	int bindingPoint = -1;
+
+	unsigned int stagingID = -1;
+	unsigned char* stagingData = nullptr;
+	unsigned int segmentSize = 0;
+	int segment = 0;
+	unsigned int segmentHead = 0; // bytes staged in the current segment
+	std::array<GLsync, numSegments> fences = {};
+	std::vector<Copy> copies; // staged, not issued yet
+};
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "OpenGLUniformBuffer.h"
 
+#include "OpenGLGraphicsAPI.h"
+
 #include <glad/glad.h>
 
 OpenGLUniformBuffer::OpenGLUniformBuffer(const std::string& name, unsigned int size) 
@@ -7,16 +9,13 @@ OpenGLUniformBuffer::OpenGLUniformBuffer(const std::string& name, unsigned int s
 	bindingPoint = OpenGLUniformBuffer::bindingPointCounter++;
 
     glGenBuffers(1, &rendererID);
-    glBindBuffer(GL_UNIFORM_BUFFER, rendererID);
+    Bind();
     glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
 }
 
 void OpenGLUniformBuffer::BlockBind(Shader* shader) {
-    GLuint blockIndexForShader;
-    blockIndexForShader = glGetUniformBlockIndex(shader->GetRendererID(), name.c_str());
-    assert(blockIndexForShader != GL_INVALID_INDEX); // global uniform block is not used in this shader program
-    glUniformBlockBinding(shader->GetRendererID(), blockIndexForShader, bindingPoint);
-    glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, rendererID);
+    shader->BindUniformBlock(name, bindingPoint);
+    OpenGLGraphicsAPI::BindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, rendererID);
 }
 
 void OpenGLUniformBuffer::UploadData(const void* data) {
@@ -25,9 +24,9 @@ void OpenGLUniformBuffer::UploadData(const void* data) {
 }
 
 void OpenGLUniformBuffer::Bind() const {
-    glBindBuffer(GL_UNIFORM_BUFFER, rendererID);
+    OpenGLGraphicsAPI::BindBuffer(GL_UNIFORM_BUFFER, rendererID);
 }
 
 void OpenGLUniformBuffer::Unbind() const {
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    OpenGLGraphicsAPI::BindBuffer(GL_UNIFORM_BUFFER, 0);
 }
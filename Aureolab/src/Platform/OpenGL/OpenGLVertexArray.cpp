@@ -1,5 +1,6 @@
 #include "OpenGLVertexArray.h"
 
+#include "OpenGLGraphicsAPI.h"
 #include "OpenGLVertexSpecification.h"
 
 #include <glad/glad.h>
@@ -11,15 +12,15 @@ OpenGLVertexArray::OpenGLVertexArray() {
 }
 
 OpenGLVertexArray::~OpenGLVertexArray() {
-	glDeleteVertexArrays(1, &rendererID);
+	OpenGLGraphicsAPI::DeleteVertexArray(rendererID);
 }
 
 void OpenGLVertexArray::Bind() const {
-    glBindVertexArray(rendererID);
+    OpenGLGraphicsAPI::BindVertexArray(rendererID);
 }
 
 void OpenGLVertexArray::Unbind() const {
-    glBindVertexArray(0);
+    OpenGLGraphicsAPI::BindVertexArray(0);
 }
 
 void OpenGLVertexArray::AddVertexBuffer(VertexBuffer& vertexBuffer) {
@@ -40,8 +41,9 @@ void OpenGLVertexArray::AddVertexBuffer(VertexBuffer& vertexBuffer) {
 	vertexBuffers.push_back(&vertexBuffer);
 }
 
-void OpenGLVertexArray::SetIndexBuffer(const IndexBuffer& indexBuffer) {
+void OpenGLVertexArray::SetIndexBuffer(IndexBuffer& indexBuffer) {
 	Bind();
 	indexBuffer.Bind();
+	Unbind(); // so that later element buffer binds, e.g. uploads of other meshes' indices, do not change this VAO
 	this->indexBuffer = &indexBuffer;
 }
\ No newline at end of file
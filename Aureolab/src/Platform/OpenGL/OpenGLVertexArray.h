@@ -17,11 +17,11 @@ public:
 	virtual unsigned int GetRendererID() const { return rendererID; }
 
 	virtual void AddVertexBuffer(VertexBuffer& vertexBuffer) override;
-	virtual void SetIndexBuffer(const IndexBuffer& indexBuffer) override;
+	virtual void SetIndexBuffer(IndexBuffer& indexBuffer) override;
 	virtual const std::vector<VertexBuffer*>& GetVertexBuffers() const override { return vertexBuffers; };
-	virtual const IndexBuffer* GetIndexBuffer() const override { return indexBuffer; }
+	virtual IndexBuffer* GetIndexBuffer() const override { return indexBuffer; }
 private:
 	unsigned int rendererID = -1;
 	std::vector<VertexBuffer*> vertexBuffers = {};
-	const IndexBuffer* indexBuffer = nullptr;
+	IndexBuffer* indexBuffer = nullptr;
 };
\ No newline at end of file
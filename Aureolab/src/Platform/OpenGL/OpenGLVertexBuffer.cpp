@@ -1,5 +1,6 @@
 #include "OpenGLVertexBuffer.h"
 
+#include "OpenGLGraphicsAPI.h"
 #include "OpenGLVertexSpecification.h"
 
 #include <glad/glad.h>
@@ -19,7 +20,7 @@ OpenGLVertexBuffer::OpenGLVertexBuffer(const std::vector<VertexAttributeSpecific
 }
 
 OpenGLVertexBuffer::~OpenGLVertexBuffer() {
-	glDeleteBuffers(1, &rendererID);
+	OpenGLGraphicsAPI::DeleteBuffer(rendererID);
 }
 
 // Size of all Vertex Attributes in Bytes, aka stride
@@ -47,9 +48,9 @@ void OpenGLVertexBuffer::UploadBuffer(size_t size, void* data) {
 }
 
 void OpenGLVertexBuffer::Bind() const {
-	glBindBuffer(GL_ARRAY_BUFFER, rendererID);
+	OpenGLGraphicsAPI::BindBuffer(GL_ARRAY_BUFFER, rendererID);
 }
 
 void OpenGLVertexBuffer::Unbind() const {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	OpenGLGraphicsAPI::BindBuffer(GL_ARRAY_BUFFER, 0);
 }
\ No newline at end of file
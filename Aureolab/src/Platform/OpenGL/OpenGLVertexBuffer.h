@@ -18,6 +18,8 @@ public:
 
 	virtual void Bind() const override;
 	virtual void Unbind() const override;
+
+	virtual unsigned int GetRendererID() const override { return rendererID; }
 private:
 	unsigned int rendererID = -1;
 	unsigned int vertexSize = 0; // aka stride. total size of all attributes in bytes.
@@ -17,6 +17,8 @@ GLenum ALTypeToGLType(VertexAttributeType alType) {
 		return GL_INT;
 	case VertexAttributeType::uint32:
 		return GL_UNSIGNED_INT;
+	case VertexAttributeType::float16:
+		return GL_HALF_FLOAT;
 	case VertexAttributeType::float32:
 		return GL_FLOAT;
 	case VertexAttributeType::float64:
@@ -31,21 +33,23 @@ GLenum ALTypeToGLType(VertexAttributeType alType) {
 unsigned int TypeSize(VertexAttributeType type) {
 	switch (type) {
 	case VertexAttributeType::int8:
-		return sizeof(GL_BYTE);
+		return sizeof(GLbyte);
 	case VertexAttributeType::uint8:
-		return sizeof(GL_UNSIGNED_BYTE);
+		return sizeof(GLubyte);
 	case VertexAttributeType::int16:
-		return sizeof(GL_SHORT);
+		return sizeof(GLshort);
 	case VertexAttributeType::uint16:
-		return sizeof(GL_UNSIGNED_SHORT);
+		return sizeof(GLushort);
 	case VertexAttributeType::int32:
-		return sizeof(GL_INT);
+		return sizeof(GLint);
 	case VertexAttributeType::uint32:
-		return sizeof(GL_UNSIGNED_INT);
+		return sizeof(GLuint);
+	case VertexAttributeType::float16:
+		return sizeof(GLhalf);
 	case VertexAttributeType::float32:
-		return sizeof(GL_FLOAT);
+		return sizeof(GLfloat);
 	case VertexAttributeType::float64:
-		return sizeof(GL_DOUBLE);
+		return sizeof(GLdouble);
 	default:
 		assert(false); // AL type not implemented
 		return -1;
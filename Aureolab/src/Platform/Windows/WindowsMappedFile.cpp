@@ -0,0 +1,24 @@
+#include "WindowsMappedFile.h"
+
+#include <Windows.h>
+
+WindowsMappedFile::WindowsMappedFile(const std::string& filepath) {
+	HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) { return; }
+	fileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	// A mapping cannot be created for an empty file
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) { return; }
+	size = (size_t)fileSize.QuadPart;
+
+	mappingHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle == NULL) { return; }
+	view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+}
+
+WindowsMappedFile::~WindowsMappedFile() {
+	if (view != nullptr) { UnmapViewOfFile(view); }
+	if (mappingHandle != nullptr) { CloseHandle(mappingHandle); }
+	if (fileHandle != nullptr) { CloseHandle(fileHandle); }
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Core/MappedFile.h"
+
+class WindowsMappedFile : public MappedFile {
+public:
+	WindowsMappedFile(const std::string& filepath);
+	virtual ~WindowsMappedFile();
+
+	virtual const void* GetData() const override { return view; }
+	virtual size_t GetSize() const override { return size; }
+
+	bool IsValid() const { return view != nullptr; }
+private:
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+	const void* view = nullptr;
+	size_t size = 0;
+};
\ No newline at end of file
@@ -0,0 +1,26 @@
+#include "DeferredShading.h"
+
+#include "Renderer/GraphicsAPI.h"
+
+#include <cassert>
+
+DeferredShading::~DeferredShading() {
+	delete emptyVao;
+}
+
+void DeferredShading::Light(Shader* lightingShader, const FrameBuffer& gBuffer, const ViewData& viewData, View view) {
+	assert(gBuffer.GetSpec().attachments == gBufferSpec.attachments);
+	if (emptyVao == nullptr) { emptyVao = VertexArray::Create(); }
+	// Texture units are the bindings of the samplers of DeferredLighting.glsl, the depth after the color attachments
+	for (unsigned int ix = Albedo; ix <= Slot; ix++) { gBuffer.BindColorAttachmentTexture(ix, ix); }
+	gBuffer.BindDepthAttachmentTexture(Slot + 1);
+
+	lightingShader->Bind();
+	lightingShader->UploadUniformMat4("u_InverseView", glm::inverse(viewData.view));
+	lightingShader->UploadUniformMat4("u_InverseProjection", glm::inverse(viewData.projection));
+	lightingShader->UploadUniformInt("u_GBufferView", (int)view);
+	lightingShader->UploadUniformFloat("u_MaxShininess", maxShininess);
+	// Its vertices are made from gl_VertexID
+	GraphicsAPI::Get()->DrawArrayTriangles(*emptyVao, 0, 3);
+	Renderer::stats.numDrawCalls++;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Renderer/FrameBuffer.h"
+#include "Renderer/Renderer.h"
+#include "Renderer/Shader.h"
+#include "Renderer/VertexArray.h"
+
+enum class ShadingPath { Forward, Deferred, };
+static inline const char* shadingPathNames[] = { "Forward", "Deferred", }; // for GUI
+
+/*
+* Deferred shading. GBuffer.glsl draws the opaque entities into a G-buffer of albedo, specular color and shininess, octahedral normal and
+* UV, the slot of the entity, and depth. DeferredLighting.glsl then shades each pixel once with a triangle covering the viewport,
+* reading the lights of its cluster from LightClusters, and the rest of the material from the Entities block by slot.
+* Views other than Lit show an attribute of the G-buffer instead. The Normal, UV and Depth visualizations of entities are such views too.
+*/
+class DeferredShading {
+public:
+	// What the lighting pass shows, see DeferredLighting.glsl
+	enum class View { Lit, Albedo, Normal, Depth, UV, Specular, };
+	static inline const char* viewNames[] = { "Lit", "Albedo", "Normal", "Depth", "UV", "Specular", }; // for GUI
+
+	// Color attachments of the G-buffer, in the order of the outputs of GBuffer.glsl
+	enum GBufferAttachment : unsigned int {
+		Albedo, // RGBA8, rgb
+		Specular, // RGBA8, color in rgb, sqrt(shininess / maxShininess) in alpha
+		NormalUV, // RGBA16F, octahedral world space normal in xy, UV in zw
+		Slot, // R32I, slot of the entity in SceneBuffer, -1 where there is none
+	};
+	static inline const FrameBufferSpec gBufferSpec = { { FrameBuffer::TextureFormat::RGBA8, FrameBuffer::TextureFormat::RGBA8, FrameBuffer::TextureFormat::RGBA16F, FrameBuffer::TextureFormat::RED_INTEGER, FrameBuffer::TextureFormat::DEPTH24_STENCIL8, } };
+	static constexpr float maxShininess = 256.0f;
+
+	DeferredShading() = default;
+	DeferredShading(const DeferredShading&) = delete;
+	DeferredShading& operator=(const DeferredShading&) = delete;
+	~DeferredShading();
+
+	// Draws the lighting of gBuffer into the bound framebuffer with lightingShader, which gets bound. Pixels without an entity are kept.
+	void Light(Shader* lightingShader, const FrameBuffer& gBuffer, const ViewData& viewData, View view);
+
+private:
+	VertexArray* emptyVao = nullptr; // the triangle has no vertex buffers, created on first use
+};
\ No newline at end of file
@@ -6,10 +6,23 @@
 #include <cassert>
 
 FrameBuffer* FrameBuffer::Create(int width, int height, TextureFormat textureFormat) {
+	return Create(width, height, { textureFormat, TextureFormat::DEPTH24_STENCIL8 });
+}
+
+FrameBuffer* FrameBuffer::Create(int width, int height, const std::vector<TextureFormat>& attachmentFormats) {
+	FrameBufferSpec spec;
+	spec.attachments = attachmentFormats;
+	spec.width = width;
+	spec.height = height;
+	return Create(spec);
+}
+
+FrameBuffer* FrameBuffer::Create(const FrameBufferSpec& spec) {
+	assert(spec.width > 0 && spec.height > 0 && spec.samples > 0);
 	FrameBuffer* fbo = nullptr;
 	switch (GraphicsContext::graphicsAPI) {
 	case GraphicsContext::API::OPENGL:
-		fbo = new OpenGLFrameBuffer(width, height, textureFormat);
+		fbo = new OpenGLFrameBuffer(spec);
 		break;
 	default:
 		assert(false); // Only OpenGL is implemented
@@ -2,24 +2,87 @@
 
 #include <glm/glm.hpp>
 
+#include <functional>
+#include <vector>
+
+struct FrameBufferSpec;
+
 class FrameBuffer {
 public:
 	enum class TextureFormat {
-		RGBA8, RED_INTEGER,
+		RGBA8,
+		RED_INTEGER, // R32I
+		RGBA16F,
+		DEPTH24_STENCIL8, // depth attachment
+	};
+	// Region of a color attachment read back from the GPU. Rows go up from the bottom left of the region, with one int per pixel
+	// for RED_INTEGER attachments, four bytes for RGBA8 ones and four floats for RGBA16F ones. pixels is valid only during the callback.
+	struct Readback {
+		int x = 0;
+		int y = 0;
+		int width = 0;
+		int height = 0;
+		TextureFormat format = TextureFormat::RGBA8;
+		const void* pixels = nullptr;
 	};
+	using ReadbackCallback = std::function<void(const Readback&)>;
+	static constexpr int numReadbackBuffers = 4;
+
+	// A color attachment of given format and a depth attachment
 	static FrameBuffer* Create(int width, int height, TextureFormat textureFormat = TextureFormat::RGBA8);
+	// Color attachments in the order of their formats, which is also the order of fragment shader outputs, and a depth attachment when
+	// DEPTH24_STENCIL8 is among the formats. Indices of color attachments do not count the depth attachment.
+	static FrameBuffer* Create(int width, int height, const std::vector<TextureFormat>& attachmentFormats);
+	// Size, attachments and sample count of spec, which needs a width and a height
+	static FrameBuffer* Create(const FrameBufferSpec& spec);
 	virtual ~FrameBuffer() = default;
 
+	// Also sets the viewport to the whole framebuffer
 	virtual void Bind() const = 0;
 	virtual void Unbind() const = 0;
 
+	// Spec the framebuffer was created with, at its current size
+	virtual const FrameBufferSpec& GetSpec() const = 0;
 	virtual unsigned int GetColorAttachmentRendererID(unsigned int index = 0) const = 0;
+	virtual TextureFormat GetColorAttachmentFormat(unsigned int index = 0) const = 0;
+	virtual unsigned int GetNumColorAttachments() const = 0;
+	virtual unsigned int GetDepthAttachmentRendererID() const = 0; // 0 when there is none
+	virtual int GetWidth() const = 0;
+	virtual int GetHeight() const = 0;
 	virtual void Resize(int width, int height) = 0;
+	// Color attachments that draws write to, the others keep their content. All of them after creation. Binds the framebuffer.
+	virtual void SetDrawAttachments(const std::vector<unsigned int>& indices) = 0;
+	// Clear a RED_INTEGER attachment, or an RGBA8 or RGBA16F one, and the depth attachment
 	virtual void Clear(int clearValue, unsigned int index = 0) = 0;
 	virtual void Clear(glm::vec4 clearColor, unsigned int index = 0) = 0;
+	// Copies each color attachment into the one with the same index of target, and the depth attachment if both have one, resolving
+	// multisampled attachments. Sizes may differ, in which case texels are stretched without filtering.
+	// Without includeColors only depth and stencil are copied, e.g. from a G-buffer under overlays drawn into the target.
+	virtual void ResolveTo(FrameBuffer& target, bool includeColors = true) const = 0;
+	// Binds an attachment as the texture of given texture unit, for shaders reading it with texelFetch. Not while drawing into it.
+	virtual void BindColorAttachmentTexture(unsigned int index, unsigned int unit) const = 0;
+	virtual void BindDepthAttachmentTexture(unsigned int unit) const = 0;
+	// These wait for the GPU to finish rendering, prefer ReadPixelsAsync
 	virtual void ReadPixel(int& pixel, int x, int y, unsigned int index = 0) = 0;
 	virtual void ReadPixel(glm::vec4& pixel, int x, int y, unsigned int index = 0) = 0;
+	// Reading back needs a framebuffer that is not multisampled, ResolveTo one first.
+	// Starts copying a region of a color attachment of the bound framebuffer into one of numReadbackBuffers buffers, without waiting.
+	// PollReadbacks calls callback with the pixels once the GPU is done, usually a frame or two later. The region is clipped to the attachment.
+	// Returns false when the region is empty or all buffers are in flight, in which case callback is never called.
+	virtual bool ReadPixelsAsync(int x, int y, int width, int height, const ReadbackCallback& callback, unsigned int index = 0) = 0;
+	// Calls the callbacks of the readbacks the GPU has finished, oldest first. Call once per frame.
+	virtual void PollReadbacks() = 0;
+};
+
+// Describes a framebuffer to create, or to get from RenderTargetPool
+struct FrameBufferSpec {
+	// Color attachments in order and a depth attachment, as in FrameBuffer::Create
+	std::vector<FrameBuffer::TextureFormat> attachments = { FrameBuffer::TextureFormat::RGBA8, FrameBuffer::TextureFormat::DEPTH24_STENCIL8 };
+	int samples = 1; // above one for multisampled attachments
+	// Size in texels. When they are 0, RenderTargetPool uses its viewport size times scale instead.
+	int width = 0;
+	int height = 0;
+	float scale = 1.0f;
 
-	//virtual void AddColorAttachment() = 0;
-	//virtual void SetDepthAttachment() const = 0;
+	bool operator==(const FrameBufferSpec&) const = default;
 };
\ No newline at end of file
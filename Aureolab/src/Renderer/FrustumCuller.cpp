@@ -0,0 +1,99 @@
+#include "FrustumCuller.h"
+
+#include "Core/Math.h"
+#include "Renderer/Renderer.h"
+
+#include <array>
+#include <bit>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#define AL_SSE
+#endif
+
+const std::vector<uint32_t>& FrustumCuller::Cull(const SceneBuffer& sceneBuffer, const glm::mat4& viewProjection) {
+	const bool isSame = &sceneBuffer == lastSceneBuffer && sceneBuffer.GetVersion() == lastVersion
+		&& viewProjection == lastViewProjection && Renderer::isFrustumCullingEnabled == wasEnabled;
+	if (isSame) {
+		Renderer::stats.numCullingReuses++;
+	}
+	else {
+		Test(sceneBuffer.GetBounds(), viewProjection);
+		lastSceneBuffer = &sceneBuffer;
+		lastVersion = sceneBuffer.GetVersion();
+		lastViewProjection = viewProjection;
+		wasEnabled = Renderer::isFrustumCullingEnabled;
+	}
+	Renderer::stats.numEntitiesCulled += numCulled;
+	return visibleSlots;
+}
+
+void FrustumCuller::Test(const SlotBounds& bounds, const glm::mat4& viewProjection) {
+	visibleSlots.clear();
+	numCulled = 0;
+	const uint32_t numSlots = bounds.GetNumSlots();
+	if (!Renderer::isFrustumCullingEnabled) {
+		for (uint32_t slot = 0; slot < numSlots; slot++) {
+			if (bounds.radius[slot] >= 0.0f) { visibleSlots.push_back(slot); }
+		}
+		return;
+	}
+
+	// A sphere is outside when it is entirely behind a plane. A box is outside when even its corner furthest along the plane normal is behind it.
+	const std::array<glm::vec4, 6> planes = Math::ExtractFrustumPlanes(viewProjection);
+	int numWithMesh = 0;
+#ifdef AL_SSE
+	static_assert(SlotBounds::numSimdLanes == 4);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+	for (uint32_t first = 0; first < numSlots; first += 4) {
+		const __m128 sphereX = _mm_loadu_ps(&bounds.sphereX[first]);
+		const __m128 sphereY = _mm_loadu_ps(&bounds.sphereY[first]);
+		const __m128 sphereZ = _mm_loadu_ps(&bounds.sphereZ[first]);
+		const __m128 radius = _mm_loadu_ps(&bounds.radius[first]);
+		const __m128 negativeRadius = _mm_xor_ps(radius, signBit);
+		const __m128 boxX = _mm_loadu_ps(&bounds.boxX[first]);
+		const __m128 boxY = _mm_loadu_ps(&bounds.boxY[first]);
+		const __m128 boxZ = _mm_loadu_ps(&bounds.boxZ[first]);
+		const __m128 extentX = _mm_loadu_ps(&bounds.extentX[first]);
+		const __m128 extentY = _mm_loadu_ps(&bounds.extentY[first]);
+		const __m128 extentZ = _mm_loadu_ps(&bounds.extentZ[first]);
+
+		const __m128 hasMesh = _mm_cmpge_ps(radius, zero);
+		__m128 isInside = hasMesh;
+		for (const glm::vec4& plane : planes) {
+			const __m128 normalX = _mm_set1_ps(plane.x);
+			const __m128 normalY = _mm_set1_ps(plane.y);
+			const __m128 normalZ = _mm_set1_ps(plane.z);
+			const __m128 distance = _mm_set1_ps(plane.w);
+			const __m128 sphereDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, sphereX), _mm_mul_ps(normalY, sphereY)), _mm_add_ps(_mm_mul_ps(normalZ, sphereZ), distance));
+			isInside = _mm_and_ps(isInside, _mm_cmpge_ps(sphereDistance, negativeRadius));
+			const __m128 centerDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, boxX), _mm_mul_ps(normalY, boxY)), _mm_add_ps(_mm_mul_ps(normalZ, boxZ), distance));
+			const __m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signBit, normalX), extentX), _mm_mul_ps(_mm_andnot_ps(signBit, normalY), extentY)), _mm_mul_ps(_mm_andnot_ps(signBit, normalZ), extentZ));
+			isInside = _mm_and_ps(isInside, _mm_cmpge_ps(_mm_add_ps(centerDistance, reach), zero));
+		}
+		numWithMesh += std::popcount((unsigned int)_mm_movemask_ps(hasMesh));
+		for (unsigned int lanes = (unsigned int)_mm_movemask_ps(isInside); lanes != 0; lanes &= lanes - 1) {
+			visibleSlots.push_back(first + std::countr_zero(lanes));
+		}
+	}
+#else
+	for (uint32_t slot = 0; slot < numSlots; slot++) {
+		if (bounds.radius[slot] < 0.0f) { continue; }
+		numWithMesh++;
+		bool isInside = true;
+		for (const glm::vec4& plane : planes) {
+			const float sphereDistance = plane.x * bounds.sphereX[slot] + plane.y * bounds.sphereY[slot] + plane.z * bounds.sphereZ[slot] + plane.w;
+			const float centerDistance = plane.x * bounds.boxX[slot] + plane.y * bounds.boxY[slot] + plane.z * bounds.boxZ[slot] + plane.w;
+			const float reach = std::abs(plane.x) * bounds.extentX[slot] + std::abs(plane.y) * bounds.extentY[slot] + std::abs(plane.z) * bounds.extentZ[slot];
+			if (sphereDistance < -bounds.radius[slot] || centerDistance + reach < 0.0f) {
+				isInside = false;
+				break;
+			}
+		}
+		if (isInside) { visibleSlots.push_back(slot); }
+	}
+#endif
+	numCulled = numWithMesh - (int)visibleSlots.size();
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Renderer/SceneBuffer.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/*
+* Tests the world space bounding boxes and spheres of all entities of a SceneBuffer against a view frustum, four slots at a time with SSE.
+* The result is kept while neither the view nor the scene buffer changes, so a still camera over a still scene costs nothing.
+*/
+class FrustumCuller {
+public:
+	// Returns the slots of the entities with a mesh that is at least partly inside the frustum of viewProjection, in slot order
+	const std::vector<uint32_t>& Cull(const SceneBuffer& sceneBuffer, const glm::mat4& viewProjection);
+	const std::vector<uint32_t>& GetVisibleSlots() const { return visibleSlots; }
+
+private:
+	void Test(const SlotBounds& bounds, const glm::mat4& viewProjection);
+
+	std::vector<uint32_t> visibleSlots;
+	int numCulled = 0;
+	// What the visibility was computed for
+	const SceneBuffer* lastSceneBuffer = nullptr;
+	uint64_t lastVersion = 0;
+	glm::mat4 lastViewProjection = glm::mat4(0.0f);
+	bool wasEnabled = false;
+};
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "GeometryPool.h"
+
+#include "Core/GraphicsContext.h"
+#include "Platform/OpenGL/OpenGLGeometryPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+GeometryPool* GeometryPool::Create(VertexFormat format, IndexType indexType) {
+	GeometryPool* pool = nullptr;
+	switch (GraphicsContext::graphicsAPI) {
+	case GraphicsContext::API::OPENGL:
+		pool = new OpenGLGeometryPool(format, indexType);
+		break;
+	default:
+		assert(false); // Only OpenGL is implemented.
+	}
+	return pool;
+}
+
+GeometryPool* GeometryPool::Get(VertexFormat format, IndexType indexType) {
+	for (GeometryPool* pool : pools) {
+		if (pool->format == format && pool->indexType == indexType) { return pool; }
+	}
+	GeometryPool* pool = Create(format, indexType);
+	pool->index = (int)pools.size();
+	pools.push_back(pool);
+	return pool;
+}
+
+const PoolRange& GeometryPool::Add(const MeshAsset* asset) {
+	assert(asset->isReady);
+	PoolRange& range = asset->poolRange;
+	if (range.pool != nullptr) { return range; }
+
+	GeometryPool* pool = Get(asset->format, asset->ebo->GetIndexType());
+	range.pool = pool;
+	range.numVertices = asset->vbo->GetNumVertices();
+	range.numIndices = (uint32_t)asset->ebo->GetNumIndices();
+	const uint32_t firstVertex = pool->vertices.Allocate(range.numVertices);
+	range.baseVertex = (int32_t)firstVertex;
+	range.firstIndex = pool->indices.Allocate(range.numIndices);
+	pool->Reserve(pool->vertices.end, pool->indices.end);
+	pool->CopyIn(asset, firstVertex, range.firstIndex);
+	return range;
+}
+
+void GeometryPool::Remove(const MeshAsset* asset) {
+	PoolRange& range = asset->poolRange;
+	if (range.pool == nullptr) { return; }
+	range.pool->vertices.Free((uint32_t)range.baseVertex, range.numVertices);
+	range.pool->indices.Free(range.firstIndex, range.numIndices);
+	range = {};
+}
+
+uint32_t GeometryPool::Allocator::Allocate(uint32_t count) {
+	for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+		if (it->end - it->begin < count) { continue; }
+		const uint32_t begin = it->begin;
+		it->begin += count;
+		if (it->begin == it->end) { freeRanges.erase(it); }
+		return begin;
+	}
+	const uint32_t begin = end;
+	end += count;
+	return begin;
+}
+
+void GeometryPool::Allocator::Free(uint32_t begin, uint32_t count) {
+	if (count == 0) { return; }
+	Range range = { begin, begin + count };
+	auto it = std::lower_bound(freeRanges.begin(), freeRanges.end(), begin, [](const Range& free, uint32_t value) { return free.begin < value; });
+	// Merge with the free neighbors
+	if (it != freeRanges.end() && it->begin == range.end) {
+		range.end = it->end;
+		it = freeRanges.erase(it);
+	}
+	if (it != freeRanges.begin() && std::prev(it)->end == range.begin) {
+		--it;
+		it->end = range.end;
+	}
+	else {
+		it = freeRanges.insert(it, range);
+	}
+	// A free range at the end is just unused space
+	if (it->end == end) {
+		end = it->begin;
+		freeRanges.erase(it);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Renderer/GraphicsAPI.h"
+#include "Renderer/IndexBuffer.h"
+#include "Renderer/MeshAsset.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// A multi-draw-indirect command with the position decoding of its mesh, which differs per mesh for quantized positions.
+// Shaders read it from the IndirectDraws buffer at u_FirstDraw + gl_DrawID. Layout matches IndirectDraw in the shaders (std430).
+struct IndirectDraw {
+	DrawElementsIndirectCommand command;
+	uint32_t _pad[3];
+	glm::vec4 positionOffset; // vec3
+	glm::vec4 positionScale; // vec3
+};
+
+/*
+* Large vertex and index buffers shared by many meshes of the same vertex format and index type, so that all of them can be drawn with one VAO bind and one multi-draw-indirect call.
+* Meshes are copied in on the GPU from their own buffers, which stay in use for regular draws. Freed ranges are reused by later meshes.
+*/
+class GeometryPool {
+public:
+	virtual ~GeometryPool() = default;
+
+	// Copies the geometry of a ready asset into the pool of its format and index type, unless it is in one already. Sets asset->poolRange.
+	static const PoolRange& Add(const MeshAsset* asset);
+	// Frees the range of the asset, if it has one. Called when the asset is destroyed.
+	static void Remove(const MeshAsset* asset);
+
+	virtual void Bind() const = 0;
+	VertexFormat GetFormat() const { return format; }
+	IndexType GetIndexType() const { return indexType; }
+	// Identifies the pool among all pools, e.g. in sort keys
+	int GetIndex() const { return index; }
+
+protected:
+	GeometryPool(VertexFormat format, IndexType indexType)
+		: format(format), indexType(indexType) {}
+
+	// Grows the buffers to hold at least given number of vertices and indices, keeping their contents
+	virtual void Reserve(uint32_t numVertices, uint32_t numIndices) = 0;
+	// Copies all vertices and indices of the asset into the buffers, starting at given vertex and index
+	virtual void CopyIn(const MeshAsset* asset, uint32_t firstVertex, uint32_t firstIndex) = 0;
+
+	VertexFormat format;
+	IndexType indexType;
+private:
+	// First fit allocation of ranges of elements of one buffer
+	struct Allocator {
+		struct Range {
+			uint32_t begin;
+			uint32_t end;
+		};
+		std::vector<Range> freeRanges; // sorted, not touching each other
+		uint32_t end = 0; // of the used part of the buffer
+
+		uint32_t Allocate(uint32_t count);
+		void Free(uint32_t begin, uint32_t count);
+	};
+
+	static GeometryPool* Create(VertexFormat format, IndexType indexType);
+	static GeometryPool* Get(VertexFormat format, IndexType indexType);
+
+	int index = 0;
+	Allocator vertices;
+	Allocator indices;
+
+	// Never freed, so that assets destroyed at exit can still return their ranges. GPU buffers go away with the context.
+	static inline std::vector<GeometryPool*> pools;
+};
\ No newline at end of file
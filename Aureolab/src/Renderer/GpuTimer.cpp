@@ -0,0 +1,18 @@
+#include "GpuTimer.h"
+
+#include "Core/GraphicsContext.h"
+#include "Platform/OpenGL/OpenGLGpuTimer.h"
+
+#include <cassert>
+
+GpuTimer* GpuTimer::Create() {
+	GpuTimer* timer = nullptr;
+	switch (GraphicsContext::graphicsAPI) {
+	case GraphicsContext::API::OPENGL:
+		timer = new OpenGLGpuTimer();
+		break;
+	default:
+		assert(false); // Only OpenGL is implemented.
+	}
+	return timer;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*
+* Measures how long the GPU takes between points of a frame with timestamp queries. Results are read a few frames later, once they are
+* available, without waiting for the GPU. While all numFramesInFlight frames are still in flight, the new frame is not measured.
+*/
+class GpuTimer {
+public:
+	static GpuTimer* Create();
+	virtual ~GpuTimer() = default;
+
+	struct Timestamp {
+		std::string label;
+		double milliseconds = 0.0; // since the first timestamp of the frame
+	};
+
+	// Fetches the timestamps of earlier frames that are available, and starts recording the ones of a new frame
+	virtual void BeginFrame() = 0;
+	// Records the time at which the GPU is done with the commands issued so far
+	virtual void Record(const std::string& label) = 0;
+	// Timestamps of the latest measured frame whose results arrived, in the order they were recorded
+	const std::vector<Timestamp>& GetLatestFrame() const { return latestFrame; }
+
+	static constexpr int numFramesInFlight = 4;
+protected:
+	std::vector<Timestamp> latestFrame;
+};
\ No newline at end of file
@@ -4,8 +4,21 @@
 
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <unordered_set>
 
+class GeometryPool;
+class StorageBuffer;
+
+// Parameters of one draw of a multi-draw-indirect call, as the GPU reads them from the command buffer
+struct DrawElementsIndirectCommand {
+	uint32_t count;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	int32_t baseVertex;
+	uint32_t baseInstance;
+};
+
 enum class GraphicsAbility {
 	Blend, // Blend fragment color with buffer color
 	DepthTest, // Update buffer after depth comparison
@@ -17,7 +30,7 @@ enum class GraphicsAbility {
 	PolygonOffsetPoint,
 };
 
-enum class BlendingFactor {
+enum class BlendingFactor : uint8_t {
 	Zero,
 	One,
 	SourceAlpha,
@@ -25,22 +38,22 @@ enum class BlendingFactor {
 	OneMinusSourceAlpha,
 };
 
-enum class CullFace {
+enum class CullFace : uint8_t {
 	Back, Front, FrontAndBack,
 };
 static inline const char* CullFaceNames[] = { "Back", "Front", "FrontAndBack", }; // for GUI
 
-enum class PolygonMode {
+enum class PolygonMode : uint8_t {
 	Point, Line, Fill,
 };
 
-enum class BufferTestFunction {
+enum class BufferTestFunction : uint8_t {
 	Never, Always, 
 	Less, LessThanEqual, GreaterThanEqual, Greater,
 	Equal, NotEqual,
 };
 
-enum class StencilAction {
+enum class StencilAction : uint8_t {
 	Keep, Zero, Replace, IncrementClamp, InrecementWrap, DecrementClamp, DecrementWrap, BitwiseInvert,
 };
 
@@ -48,6 +61,37 @@ enum class ClearableBuffer {
 	Color, Depth, Stencil,
 };
 
+// Fixed-function state of draws. SetPipelineState applies only the parts that differ from the current state.
+struct PipelineState {
+	uint16_t enabledAbilities = 0; // bit 1 << GraphicsAbility of each enabled ability
+	BlendingFactor blendSource = BlendingFactor::One;
+	BlendingFactor blendDestination = BlendingFactor::Zero;
+	CullFace cullFace = CullFace::Back;
+	PolygonMode polygonMode = PolygonMode::Fill;
+	BufferTestFunction depthFunction = BufferTestFunction::Less;
+	BufferTestFunction stencilFunction = BufferTestFunction::Always;
+	StencilAction stencilTestFail = StencilAction::Keep;
+	StencilAction depthTestFail = StencilAction::Keep;
+	StencilAction depthTestPass = StencilAction::Keep;
+	int stencilReference = 0;
+	unsigned int stencilReadMask = 0xFFFFFFFF;
+	unsigned int stencilWriteMask = 0xFFFFFFFF;
+	float polygonOffsetFactor = 0.0f;
+	float polygonOffsetUnits = 0.0f;
+
+	bool IsEnabled(GraphicsAbility ability) const { return enabledAbilities & (1 << (int)ability); }
+	void SetEnabled(GraphicsAbility ability, bool isEnabled) {
+		if (isEnabled) { enabledAbilities |= 1 << (int)ability; }
+		else { enabledAbilities &= ~(1 << (int)ability); }
+	}
+};
+
+// Counters of a frame, reset by the caller
+struct GraphicsAPIStats {
+	int numStateChanges = 0; // state changes and binds that reached the driver
+	int numRedundantStateChanges = 0; // dropped because they would not change anything
+};
+
 
 class GraphicsAPI {
 public:
@@ -74,10 +118,25 @@ public:
 	virtual void SetStencilMask(unsigned int mask) = 0;
 	virtual void SetPolygonOffset(float factor, float units) = 0;
 
-	virtual void DrawIndexedTriangles(const VertexArray& vertexArray, unsigned int indexCount = 0) = 0;
-	virtual void DrawIndexedPoints(const VertexArray& vertexArray, unsigned int indexCount = 0) = 0;
+	// All of the above, except the point size, at once
+	virtual void SetPipelineState(const PipelineState& state) = 0;
+	virtual const PipelineState& GetPipelineState() const = 0;
+	// Forgets the cached state, e.g. after code outside of this API changed it, so that the next changes are all applied
+	virtual void InvalidateState() = 0;
+	// Debug mode comparing the cached state with the driver's at each draw. Slow.
+	static inline bool isStateValidationEnabled = false;
+	static inline GraphicsAPIStats stats;
+
+	// baseInstance is visible to shaders as gl_BaseInstance
+	virtual void DrawIndexedTriangles(const VertexArray& vertexArray, unsigned int indexCount = 0, unsigned int firstIndex = 0, unsigned int baseInstance = 0) = 0;
+	virtual void DrawIndexedPoints(const VertexArray& vertexArray, unsigned int indexCount = 0, unsigned int firstIndex = 0) = 0;
 	virtual void DrawArrayTriangles(const VertexArray& vertexArray, unsigned int start = 0, unsigned int count = 0) = 0;
 	virtual void DrawArrayPoints(const VertexArray& vertexArray, unsigned int start = 0, unsigned int count = 0) = 0;
+	// Draw instanceCount copies, whose gl_InstanceID goes from 0, and gl_BaseInstance is baseInstance
+	virtual void DrawIndexedTrianglesInstanced(const VertexArray& vertexArray, unsigned int instanceCount, unsigned int indexCount = 0, unsigned int firstIndex = 0, unsigned int baseInstance = 0) = 0;
+	virtual void DrawArrayTrianglesInstanced(const VertexArray& vertexArray, unsigned int instanceCount, unsigned int start = 0, unsigned int count = 0, unsigned int baseInstance = 0) = 0;
+	// Draw numCommands meshes of the pool with one call. Commands are DrawElementsIndirectCommands stride bytes apart, from index firstCommand in commands. gl_DrawID goes from 0.
+	virtual void MultiDrawIndexedTrianglesIndirect(const GeometryPool& pool, const StorageBuffer& commands, unsigned int firstCommand, unsigned int numCommands, unsigned int stride = sizeof(DrawElementsIndirectCommand)) = 0;
 protected:
 	static GraphicsAPI* instance;
 };
\ No newline at end of file
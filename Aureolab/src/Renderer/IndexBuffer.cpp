@@ -3,7 +3,9 @@
 #include "Core/GraphicsContext.h"
 #include "Platform/OpenGL/OpenGLIndexBuffer.h"
 
+#include <algorithm>
 #include <cassert>
+#include <limits>
 
 IndexBuffer* IndexBuffer::Create() {
 	IndexBuffer* ebo = nullptr;
@@ -16,3 +18,13 @@ IndexBuffer* IndexBuffer::Create() {
 	}
 	return ebo;
 }
+
+void IndexBuffer::UploadCompactIndices(const std::vector<unsigned int>& indices) {
+	unsigned int maxIndex = indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end());
+	if (maxIndex > std::numeric_limits<unsigned short>::max()) {
+		UploadIndices(indices);
+		return;
+	}
+	std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+	UploadIndices(shortIndices);
+}
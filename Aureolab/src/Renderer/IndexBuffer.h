@@ -1,7 +1,13 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
 
+enum class IndexType {
+	uint16,
+	uint32,
+};
+
 class IndexBuffer {
 public:
 	static IndexBuffer* Create();
@@ -10,6 +16,15 @@ public:
 	virtual void Bind() const = 0;
 	virtual void Unbind() const = 0;
 
-	virtual void UploadIndices(const std::vector<unsigned int>& indices) = 0;
+	virtual unsigned int GetRendererID() const = 0;
+
+	// Pointer versions allow uploading from memory not owned by a vector, e.g. a memory mapped file.
+	virtual void UploadIndices(const unsigned int* indices, size_t numIndices) = 0;
+	virtual void UploadIndices(const unsigned short* indices, size_t numIndices) = 0;
+	void UploadIndices(const std::vector<unsigned int>& indices) { UploadIndices(indices.data(), indices.size()); }
+	void UploadIndices(const std::vector<unsigned short>& indices) { UploadIndices(indices.data(), indices.size()); }
+	// Uploads 16-bit indices when all of them fit, 32-bit ones otherwise.
+	void UploadCompactIndices(const std::vector<unsigned int>& indices);
 	virtual const size_t GetNumIndices() const = 0;
+	virtual IndexType GetIndexType() const = 0;
 };
\ No newline at end of file
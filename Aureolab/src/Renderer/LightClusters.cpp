@@ -0,0 +1,242 @@
+#include "LightClusters.h"
+
+#include "Core/ThreadPool.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <thread>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#define AL_SSE
+#endif
+
+void LightClusters::Spheres::Clear() {
+	x.clear();
+	y.clear();
+	z.clear();
+	radius.clear();
+	lights.clear();
+}
+
+void LightClusters::Spheres::Add(const glm::vec3& center, float sphereRadius, uint32_t light) {
+	x.push_back(center.x);
+	y.push_back(center.y);
+	z.push_back(center.z);
+	radius.push_back(sphereRadius);
+	lights.push_back(light);
+}
+
+void LightClusters::Spheres::Pad() {
+	// Far behind the camera, with no radius
+	while (x.size() % 4 != 0) { Add({ 0.0f, 0.0f, 1e30f }, 0.0f, 0); }
+}
+
+LightClusters::~LightClusters() {
+	delete lightsBuffer;
+	delete clustersBuffer;
+	delete indicesBuffer;
+}
+
+void LightClusters::BlockBind(Shader* shader) {
+	GetLights()->BlockBind(shader);
+	GetClusters()->BlockBind(shader);
+	GetIndices()->BlockBind(shader);
+}
+
+float LightClusters::ComputeRange(const Light& light) {
+	// Where intensity * color / (c + l * d + q * d^2) is cutoff
+	const float brightness = light.intensity * std::max({ light.color.r, light.color.g, light.color.b });
+	const glm::vec3 attenuation = glm::vec3(light.pointParams.attenuation);
+	const float denominator = brightness / cutoff;
+	if (attenuation.z > 0.0f) {
+		const float c = attenuation.x - denominator;
+		return std::max((-attenuation.y + std::sqrt(std::max(attenuation.y * attenuation.y - 4.0f * attenuation.z * c, 0.0f))) / (2.0f * attenuation.z), 0.0f);
+	}
+	if (attenuation.y > 0.0f) { return std::max((denominator - attenuation.x) / attenuation.y, 0.0f); }
+	return -1.0f;
+}
+
+void LightClusters::Update(const std::vector<Light>& lights, const glm::vec3& ambientLight, const ViewData& viewData, int width, int height) {
+	if (viewData.projection != lastProjection) { ComputeClusterBounds(viewData.projection); }
+
+	// Global lights first, then the point lights of the view with their spheres of influence in view space
+	gpuLights.clear();
+	spheres.Clear();
+	for (const Light& light : lights) {
+		if (light.type != 0 || ComputeRange(light) < 0.0f) { gpuLights.push_back(light); }
+	}
+	const uint32_t numGlobalLights = (uint32_t)gpuLights.size();
+	for (const Light& light : lights) {
+		if (light.type != 0) { continue; }
+		const float range = ComputeRange(light);
+		if (range <= 0.0f) { continue; }
+		const glm::vec3 center = glm::vec3(viewData.view * glm::vec4(glm::vec3(light.pointParams.position), 1.0f));
+		if (-center.z + range < nearDistance || -center.z - range > farDistance) { continue; }
+		spheres.Add(center, range, (uint32_t)gpuLights.size());
+		gpuLights.push_back(light);
+	}
+	const size_t numClusteredLights = spheres.x.size();
+	spheres.Pad();
+
+	// Chunks of slices, each assigned by one thread
+	const size_t numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	const size_t numChunks = numClusteredLights < parallelMinLights ? 1 : std::min<size_t>(numThreads, numSlices);
+	chunks.resize(std::max(chunks.size(), numChunks));
+	clusterRanges.resize(numClusters);
+	auto assignChunk = [&](size_t chunk) { AssignSlices((int)(numSlices * chunk / numChunks), (int)(numSlices * (chunk + 1) / numChunks), chunks[chunk]); };
+	if (numChunks == 1) { assignChunk(0); }
+	else { ThreadPool::GetShared().RunInParallel(numChunks, assignChunk); }
+	// Ranges are relative to their chunk until here
+	uint32_t numIndices = 0;
+	for (size_t chunk = 0; chunk < numChunks; chunk++) {
+		const int firstCluster = numTilesX * numTilesY * (int)(numSlices * chunk / numChunks);
+		const int endCluster = numTilesX * numTilesY * (int)(numSlices * (chunk + 1) / numChunks);
+		for (int cluster = firstCluster; cluster < endCluster; cluster++) { clusterRanges[cluster].x += numIndices; }
+		numIndices += (uint32_t)chunks[chunk].indices.size();
+	}
+
+	LightsHeader header;
+	header.ambientLight = glm::vec4(ambientLight, 1.0f);
+	header.clusterGrid = { numTilesX, numTilesY, numSlices, (int)numGlobalLights };
+	header.clusterParams = { nearDistance, numSlices / std::log(farDistance / nearDistance), (float)width, (float)height };
+	StorageBuffer* buffer = GetLights();
+	buffer->Reserve((unsigned int)(sizeof(LightsHeader) + gpuLights.size() * sizeof(Light)));
+	*(LightsHeader*)buffer->Stage(0, sizeof(LightsHeader)) = header;
+	if (!gpuLights.empty()) { std::copy(gpuLights.begin(), gpuLights.end(), (Light*)buffer->Stage(sizeof(LightsHeader), (unsigned int)(gpuLights.size() * sizeof(Light)))); }
+	buffer->Flush();
+
+	buffer = GetClusters();
+	std::copy(clusterRanges.begin(), clusterRanges.end(), (glm::uvec2*)buffer->Stage(0, numClusters * sizeof(glm::uvec2)));
+	buffer->Flush();
+
+	if (numIndices > 0) {
+		buffer = GetIndices();
+		buffer->Reserve(numIndices * sizeof(uint32_t));
+		uint32_t* staged = (uint32_t*)buffer->Stage(0, numIndices * sizeof(uint32_t));
+		for (size_t chunk = 0; chunk < numChunks; chunk++) { staged = std::copy(chunks[chunk].indices.begin(), chunks[chunk].indices.end(), staged); }
+		buffer->Flush();
+	}
+
+	Renderer::stats.numGlobalLights += (int)numGlobalLights;
+	Renderer::stats.numClusteredLights += (int)numClusteredLights;
+	Renderer::stats.numLightIndices += (int)numIndices;
+}
+
+void LightClusters::ComputeClusterBounds(const glm::mat4& projection) {
+	lastProjection = projection;
+	// Of a perspective projection, where the clip space w is the distance from the camera plane
+	nearDistance = projection[3][2] / (projection[2][2] - 1.0f);
+	farDistance = projection[3][2] / (projection[2][2] + 1.0f);
+	sliceDepths.resize(numSlices + 1);
+	for (int slice = 0; slice <= numSlices; slice++) { sliceDepths[slice] = nearDistance * std::pow(farDistance / nearDistance, (float)slice / numSlices); }
+
+	// Tile corners at unit distance from the camera plane, so that a point at distance d is the corner times d
+	const glm::mat4 inverseProjection = glm::inverse(projection);
+	auto getCorner = [&](int x, int y) {
+		const glm::vec4 point = inverseProjection * glm::vec4(2.0f * x / numTilesX - 1.0f, 2.0f * y / numTilesY - 1.0f, -1.0f, 1.0f);
+		const glm::vec3 view = glm::vec3(point) / point.w;
+		return view / -view.z;
+	};
+	clusterMin.resize(numClusters);
+	clusterMax.resize(numClusters);
+	for (int slice = 0; slice < numSlices; slice++) {
+		for (int y = 0; y < numTilesY; y++) {
+			for (int x = 0; x < numTilesX; x++) {
+				const int cluster = (slice * numTilesY + y) * numTilesX + x;
+				clusterMin[cluster] = glm::vec3(INFINITY);
+				clusterMax[cluster] = glm::vec3(-INFINITY);
+				for (int corner = 0; corner < 4; corner++) {
+					const glm::vec3 direction = getCorner(x + (corner & 1), y + (corner >> 1));
+					for (float depth : { sliceDepths[slice], sliceDepths[slice + 1] }) {
+						clusterMin[cluster] = glm::min(clusterMin[cluster], direction * depth);
+						clusterMax[cluster] = glm::max(clusterMax[cluster], direction * depth);
+					}
+				}
+			}
+		}
+	}
+}
+
+void LightClusters::AssignSlices(int firstSlice, int endSlice, Chunk& chunk) {
+	chunk.indices.clear();
+	const size_t numSpheres = spheres.x.size();
+	for (int slice = firstSlice; slice < endSlice; slice++) {
+		// The lights reaching the depths of the slice, then each tile's lights among them
+		Spheres& candidates = chunk.candidates;
+		candidates.Clear();
+		const float sliceNear = sliceDepths[slice];
+		const float sliceFar = sliceDepths[slice + 1];
+#ifdef AL_SSE
+		const __m128 nearDepth = _mm_set1_ps(sliceNear);
+		const __m128 farDepth = _mm_set1_ps(sliceFar);
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+		for (size_t first = 0; first < numSpheres; first += 4) {
+			const __m128 depth = _mm_xor_ps(_mm_loadu_ps(&spheres.z[first]), signBit);
+			const __m128 radius = _mm_loadu_ps(&spheres.radius[first]);
+			const __m128 isInside = _mm_and_ps(_mm_cmple_ps(_mm_sub_ps(depth, radius), farDepth), _mm_cmpge_ps(_mm_add_ps(depth, radius), nearDepth));
+			for (unsigned int lanes = (unsigned int)_mm_movemask_ps(isInside); lanes != 0; lanes &= lanes - 1) {
+				const size_t ix = first + std::countr_zero(lanes);
+				candidates.Add({ spheres.x[ix], spheres.y[ix], spheres.z[ix] }, spheres.radius[ix], spheres.lights[ix]);
+			}
+		}
+#else
+		for (size_t ix = 0; ix < numSpheres; ix++) {
+			const float depth = -spheres.z[ix];
+			if (depth - spheres.radius[ix] <= sliceFar && depth + spheres.radius[ix] >= sliceNear) {
+				candidates.Add({ spheres.x[ix], spheres.y[ix], spheres.z[ix] }, spheres.radius[ix], spheres.lights[ix]);
+			}
+		}
+#endif
+		candidates.Pad();
+
+		// A sphere overlaps a box when the squared distance from its center to the box is at most its squared radius
+		for (int cluster = slice * numTilesX * numTilesY; cluster < (slice + 1) * numTilesX * numTilesY; cluster++) {
+			const glm::vec3& boxMin = clusterMin[cluster];
+			const glm::vec3& boxMax = clusterMax[cluster];
+			const uint32_t firstIndex = (uint32_t)chunk.indices.size();
+#ifdef AL_SSE
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 minX = _mm_set1_ps(boxMin.x), minY = _mm_set1_ps(boxMin.y), minZ = _mm_set1_ps(boxMin.z);
+			const __m128 maxX = _mm_set1_ps(boxMax.x), maxY = _mm_set1_ps(boxMax.y), maxZ = _mm_set1_ps(boxMax.z);
+			for (size_t first = 0; first < candidates.x.size(); first += 4) {
+				const __m128 x = _mm_loadu_ps(&candidates.x[first]);
+				const __m128 y = _mm_loadu_ps(&candidates.y[first]);
+				const __m128 z = _mm_loadu_ps(&candidates.z[first]);
+				const __m128 radius = _mm_loadu_ps(&candidates.radius[first]);
+				const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, x), _mm_sub_ps(x, maxX)), zero);
+				const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, y), _mm_sub_ps(y, maxY)), zero);
+				const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, z), _mm_sub_ps(z, maxZ)), zero);
+				const __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+				const __m128 isInside = _mm_cmple_ps(distanceSquared, _mm_mul_ps(radius, radius));
+				for (unsigned int lanes = (unsigned int)_mm_movemask_ps(isInside); lanes != 0; lanes &= lanes - 1) {
+					chunk.indices.push_back(candidates.lights[first + std::countr_zero(lanes)]);
+				}
+			}
+#else
+			for (size_t ix = 0; ix < candidates.x.size(); ix++) {
+				const glm::vec3 center = { candidates.x[ix], candidates.y[ix], candidates.z[ix] };
+				const glm::vec3 delta = glm::max(glm::max(boxMin - center, center - boxMax), glm::vec3(0.0f));
+				if (glm::dot(delta, delta) <= candidates.radius[ix] * candidates.radius[ix]) { chunk.indices.push_back(candidates.lights[ix]); }
+			}
+#endif
+			clusterRanges[cluster] = { firstIndex, (uint32_t)chunk.indices.size() - firstIndex };
+		}
+	}
+}
+
+StorageBuffer* LightClusters::GetLights() {
+	if (lightsBuffer == nullptr) { lightsBuffer = StorageBuffer::Create("Lights", sizeof(LightsHeader) + 64 * sizeof(Light)); }
+	return lightsBuffer;
+}
+
+StorageBuffer* LightClusters::GetClusters() {
+	if (clustersBuffer == nullptr) { clustersBuffer = StorageBuffer::Create("LightClusters", numClusters * sizeof(glm::uvec2)); }
+	return clustersBuffer;
+}
+
+StorageBuffer* LightClusters::GetIndices() {
+	if (indicesBuffer == nullptr) { indicesBuffer = StorageBuffer::Create("LightIndices", 1024 * sizeof(uint32_t)); }
+	return indicesBuffer;
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Renderer/Renderer.h"
+#include "Renderer/Shader.h"
+#include "Renderer/StorageBuffer.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/*
+* Clustered forward lighting. The view frustum is split into tiles across the viewport and slices of exponentially growing depth, and each
+* point light is listed in the clusters its sphere of influence overlaps, which ends where attenuation brings the light below cutoff.
+* A fragment is lit by the lights of its cluster, and by the global ones: directional lights and point lights without distance attenuation.
+* Lights are assigned on the CPU, chunks of slices on the shared ThreadPool when there are many, testing four spheres at a time with SSE.
+* The results go to the storage blocks Lights, LightClusters and LightIndices of BasicShader, and of DeferredLighting for deferred shading.
+*/
+class LightClusters {
+public:
+	LightClusters() = default;
+	LightClusters(const LightClusters&) = delete;
+	LightClusters& operator=(const LightClusters&) = delete;
+	~LightClusters();
+
+	void BlockBind(Shader* shader);
+	// Assigns the world space lights to the clusters of the view, for a viewport of width x height pixels, and uploads them
+	void Update(const std::vector<Light>& lights, const glm::vec3& ambientLight, const ViewData& viewData, int width, int height);
+
+	static constexpr int numTilesX = 16;
+	static constexpr int numTilesY = 9;
+	static constexpr int numSlices = 24;
+	static constexpr int numClusters = numTilesX * numTilesY * numSlices;
+	// Brightness under which a point light stops lighting
+	static inline float cutoff = 1.0f / 256.0f;
+	// Fewer clustered lights are assigned on the main thread only
+	static inline size_t parallelMinLights = 256;
+
+private:
+	// Spheres of lights in view space, padded to a multiple of four with spheres that overlap nothing
+	struct Spheres {
+		std::vector<float> x, y, z, radius;
+		std::vector<uint32_t> lights; // indices of the lights in gpuLights
+
+		void Clear();
+		void Add(const glm::vec3& center, float sphereRadius, uint32_t light);
+		void Pad();
+	};
+	// Indices of the lights of the clusters of a chunk of slices, assigned by one thread
+	struct Chunk {
+		Spheres candidates; // of the slice being assigned
+		std::vector<uint32_t> indices;
+	};
+
+	// Distance from a point light at which it goes below cutoff, negative if it never does
+	static float ComputeRange(const Light& light);
+	void ComputeClusterBounds(const glm::mat4& projection);
+	void AssignSlices(int firstSlice, int endSlice, Chunk& chunk);
+	StorageBuffer* GetLights();
+	StorageBuffer* GetClusters();
+	StorageBuffer* GetIndices();
+
+	std::vector<Light> gpuLights; // the global ones first
+	Spheres spheres; // of the clustered lights
+	std::vector<float> sliceDepths; // numSlices + 1 distances from the camera plane
+	std::vector<glm::vec3> clusterMin; // view space bounds of the tiles, by tile, slice after slice
+	std::vector<glm::vec3> clusterMax;
+	glm::mat4 lastProjection = glm::mat4(0.0f); // of the bounds
+	float nearDistance = 0.1f;
+	float farDistance = 100.0f;
+	std::vector<Chunk> chunks;
+	std::vector<glm::uvec2> clusterRanges; // first index and number of lights of each cluster
+	StorageBuffer* lightsBuffer = nullptr;
+	StorageBuffer* clustersBuffer = nullptr;
+	StorageBuffer* indicesBuffer = nullptr;
+};
\ No newline at end of file
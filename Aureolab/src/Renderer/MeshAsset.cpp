@@ -0,0 +1,26 @@
+#include "MeshAsset.h"
+
+#include "Renderer/GeometryPool.h"
+
+static constexpr UniformHandle uPositionOffset = "u_PositionOffset"_uniform;
+static constexpr UniformHandle uPositionScale = "u_PositionScale"_uniform;
+static constexpr UniformHandle uOctahedralNormals = "u_OctahedralNormals"_uniform;
+
+void VertexDecoding::UploadUniforms(Shader* shader) const {
+	shader->UploadUniformFloat3(uPositionOffset, positionOffset);
+	shader->UploadUniformFloat3(uPositionScale, positionScale);
+	shader->UploadUniformInt(uOctahedralNormals, octahedralNormals);
+}
+
+MeshAsset::MeshAsset(VertexBuffer* vbo, IndexBuffer* ebo, VertexFormat format)
+	: vao(VertexArray::Create()), vbo(vbo), ebo(ebo), format(format) {
+	vao->AddVertexBuffer(*vbo);
+	vao->SetIndexBuffer(*ebo);
+}
+
+MeshAsset::~MeshAsset() {
+	GeometryPool::Remove(this);
+	delete vao;
+	delete vbo;
+	delete ebo;
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "Modeling/Modeling.h"
+#include "Modeling/Bvh.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+enum class VertexFormat {
+	Basic, // float32 everything, 48 bytes
+	Packed, // float32 position, octahedral normal, half UV, unorm8 color, 24 bytes
+	PackedQuantized, // Packed, and position quantized to unorm16 against mesh bounds, 20 bytes
+};
+static inline const char* vertexFormatNames[] = { "Basic", "Packed", "PackedQuantized", }; // for GUI
+
+// Parameters shaders need to turn compact vertex attributes back into floats.
+// Defaults leave BasicVertex attributes unchanged.
+struct VertexDecoding {
+	glm::vec3 positionOffset = { 0.0f, 0.0f, 0.0f };
+	glm::vec3 positionScale = { 1.0f, 1.0f, 1.0f };
+	bool octahedralNormals = false;
+
+	void UploadUniforms(Shader* shader) const;
+};
+
+class GeometryPool;
+
+// Where the geometry of a mesh is in a GeometryPool
+struct PoolRange {
+	GeometryPool* pool = nullptr;
+	uint32_t firstIndex = 0;
+	int32_t baseVertex = 0;
+	uint32_t numIndices = 0;
+	uint32_t numVertices = 0;
+};
+
+// GPU buffers of a mesh together with what is needed to draw it. Owns the buffers.
+struct MeshAsset {
+	VertexArray* vao = nullptr;
+	VertexBuffer* vbo = nullptr;
+	IndexBuffer* ebo = nullptr;
+	VertexFormat format;
+	VertexDecoding decoding;
+	std::vector<MeshLod> lods; // empty when the whole index buffer is a single LOD
+	std::vector<Meshlet> meshlets; // sorted by indexOffset, empty when the mesh is not split into meshlets
+	BoundingSphere bounds; // in model space
+	BoundingBox box; // in model space
+	TriangleBvh bvh; // CPU copy of the triangles of LOD 0 for picking, in model space
+	bool isReady = true; // false while the geometry is still loading in the background, see MeshAssetRegistry
+	mutable PoolRange poolRange; // set when the geometry is copied into a pool for multi-draws, which can happen while drawing
+
+	MeshAsset(VertexBuffer* vbo, IndexBuffer* ebo, VertexFormat format);
+	MeshAsset(const MeshAsset&) = delete;
+	MeshAsset& operator=(const MeshAsset&) = delete;
+	~MeshAsset();
+
+	// Format of meshes created from now on. Compact formats are opt-in because they lose some precision.
+	static inline VertexFormat defaultFormat = VertexFormat::Basic;
+};
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "OcclusionCuller.h"
+
+#include "Core/GraphicsContext.h"
+#include "Renderer/Renderer.h"
+#include "Platform/OpenGL/OpenGLOcclusionCuller.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+OcclusionCuller* OcclusionCuller::Create(Shader* downsampleShader, Shader* boxShader) {
+	OcclusionCuller* culler = nullptr;
+	switch (GraphicsContext::graphicsAPI) {
+	case GraphicsContext::API::OPENGL:
+		culler = new OpenGLOcclusionCuller(downsampleShader, boxShader);
+		break;
+	default:
+		assert(false); // Only OpenGL is implemented.
+	}
+	return culler;
+}
+
+const std::vector<uint32_t>& OcclusionCuller::Cull(const SlotBounds& bounds, const std::vector<uint32_t>& candidates) {
+	Fetch();
+	visibleSlots.clear();
+	occludedSlots.clear();
+	// Counts advance once per pyramid, not per frame, since the same pyramid stays the latest until the next readback finishes.
+	// Counts of slots that are not candidates start over, so entities entering the frustum are drawn at least until the next pyramid.
+	const bool isCounted = isPyramidNew;
+	isPyramidNew = false;
+	nextNumPyramidsOccluded.assign(bounds.GetNumSlots(), 0);
+	for (uint32_t slot : candidates) {
+		if (levels.empty() || !IsOccluded(bounds, slot)) {
+			visibleSlots.push_back(slot);
+			continue;
+		}
+		const uint8_t numPyramids = slot < numPyramidsOccluded.size() ? numPyramidsOccluded[slot] : 0;
+		nextNumPyramidsOccluded[slot] = isCounted ? std::min<uint8_t>(numPyramids + 1, numPyramidsToCull) : numPyramids;
+		if (nextNumPyramidsOccluded[slot] < numPyramidsToCull) { visibleSlots.push_back(slot); }
+		else {
+			occludedSlots.push_back(slot);
+			Renderer::stats.numOcclusionCulled++;
+		}
+	}
+	std::swap(numPyramidsOccluded, nextNumPyramidsOccluded);
+	Renderer::stats.numOcclusionTested += levels.empty() ? 0 : (int)candidates.size();
+	return visibleSlots;
+}
+
+void OcclusionCuller::DrawRevealed(const SlotBounds& bounds, const glm::mat4& viewProjection, const std::function<void(uint32_t slot)>& drawSlot) {
+	// Boxes crossing the camera plane would be clipped where the camera is inside them, so they are drawn without a test
+	testedSlots.clear();
+	for (uint32_t slot : occludedSlots) {
+		if (IsInFrontOfCamera(bounds, slot, viewProjection)) { testedSlots.push_back(slot); }
+		else { drawSlot(slot); }
+	}
+	Renderer::stats.numOcclusionRetested += (int)testedSlots.size();
+	if (testedSlots.empty()) { return; }
+	// All boxes are tested before any entity is drawn, so that the entities do not hide each other's boxes
+	TestBoxes(bounds, viewProjection, testedSlots);
+	for (size_t test = 0; test < testedSlots.size(); test++) {
+		BeginConditionalDraw(test);
+		drawSlot(testedSlots[test]);
+		EndConditionalDraw();
+	}
+}
+
+void OcclusionCuller::SetBase(const float* tiles, int width, int height, int fboWidth, int fboHeight, const glm::mat4& viewProjection) {
+	assert(width > 0 && height > 0);
+	isPyramidNew = true;
+	viewportSize = glm::vec2((float)fboWidth / tileSize, (float)fboHeight / tileSize);
+	pyramidViewProjection = viewProjection;
+
+	int numLevels = 1;
+	for (int size = std::max(width, height); size > 1; size = (size + 1) / 2) { numLevels++; }
+	levels.resize(numLevels);
+	levels[0].width = width;
+	levels[0].height = height;
+	levels[0].depths.assign(tiles, tiles + width * height);
+	// Each texel is the farthest of the 2x2 texels below it, the last row and column repeated at odd sizes
+	for (int l = 1; l < numLevels; l++) {
+		const Level& below = levels[l - 1];
+		Level& level = levels[l];
+		level.width = (below.width + 1) / 2;
+		level.height = (below.height + 1) / 2;
+		level.depths.resize(level.width * level.height);
+		for (int y = 0; y < level.height; y++) {
+			const float* row0 = &below.depths[2 * y * below.width];
+			const float* row1 = &below.depths[std::min(2 * y + 1, below.height - 1) * below.width];
+			for (int x = 0; x < level.width; x++) {
+				const int x0 = 2 * x;
+				const int x1 = std::min(2 * x + 1, below.width - 1);
+				level.depths[y * level.width + x] = std::max({ row0[x0], row0[x1], row1[x0], row1[x1] });
+			}
+		}
+	}
+}
+
+bool OcclusionCuller::IsOccluded(const SlotBounds& bounds, uint32_t slot) const {
+	const glm::vec3 center = { bounds.boxX[slot], bounds.boxY[slot], bounds.boxZ[slot] };
+	const glm::vec3 extent = { bounds.extentX[slot], bounds.extentY[slot], bounds.extentZ[slot] };
+	glm::vec2 rectMin = glm::vec2(1.0f);
+	glm::vec2 rectMax = glm::vec2(-1.0f);
+	float nearestDepth = 1.0f;
+	for (int corner = 0; corner < 8; corner++) {
+		const glm::vec3 sign = { (corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f };
+		const glm::vec4 clip = pyramidViewProjection * glm::vec4(center + extent * sign, 1.0f);
+		if (clip.w <= 1e-5f) { return false; } // the box crosses the camera plane
+		const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		rectMin = glm::min(rectMin, glm::vec2(ndc));
+		rectMax = glm::max(rectMax, glm::vec2(ndc));
+		nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+	}
+	// From NDC to texels of the base level. Boxes off the pyramid's view were not seen by it.
+	rectMin = (rectMin * 0.5f + 0.5f) * viewportSize;
+	rectMax = (rectMax * 0.5f + 0.5f) * viewportSize;
+	if (rectMax.x < 0.0f || rectMax.y < 0.0f || rectMin.x >= viewportSize.x || rectMin.y >= viewportSize.y) { return false; }
+	rectMin = glm::max(rectMin, glm::vec2(0.0f));
+	rectMax = glm::min(rectMax, viewportSize);
+
+	// At this level the rectangle is at most one texel wide, so it touches at most 2x2 texels
+	const float size = std::max(rectMax.x - rectMin.x, rectMax.y - rectMin.y);
+	const int l = std::min(size > 1.0f ? (int)std::ceil(std::log2(size)) : 0, (int)levels.size() - 1);
+	const Level& level = levels[l];
+	const float scale = 1.0f / (float)(1 << l);
+	const int x0 = std::clamp((int)(rectMin.x * scale), 0, level.width - 1);
+	const int x1 = std::clamp((int)(rectMax.x * scale), 0, level.width - 1);
+	const int y0 = std::clamp((int)(rectMin.y * scale), 0, level.height - 1);
+	const int y1 = std::clamp((int)(rectMax.y * scale), 0, level.height - 1);
+	float farthestDepth = 0.0f;
+	for (int y = y0; y <= y1; y++) {
+		for (int x = x0; x <= x1; x++) {
+			farthestDepth = std::max(farthestDepth, level.depths[y * level.width + x]);
+		}
+	}
+	return nearestDepth > farthestDepth;
+}
+
+bool OcclusionCuller::IsInFrontOfCamera(const SlotBounds& bounds, uint32_t slot, const glm::mat4& viewProjection) {
+	const glm::vec3 center = { bounds.boxX[slot], bounds.boxY[slot], bounds.boxZ[slot] };
+	const glm::vec3 extent = { bounds.extentX[slot], bounds.extentY[slot], bounds.extentZ[slot] };
+	for (int corner = 0; corner < 8; corner++) {
+		const glm::vec3 sign = { (corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f };
+		if ((viewProjection * glm::vec4(center + extent * sign, 1.0f)).w <= 1e-5f) { return false; }
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Renderer/FrameBuffer.h"
+#include "Renderer/SceneBuffer.h"
+#include "Renderer/Shader.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/*
+* Hierarchical-Z occlusion culling. The depth buffer of a frame is reduced on the GPU to the farthest depth of each tile and read back
+* without waiting, and coarser levels of a depth pyramid are built from it on the CPU. The screen rectangle of an entity's bounding box
+* is compared against the level where it covers at most 2x2 texels, and entities entirely behind the depth there are occluded.
+* The pyramid is a few frames old, so it is tested with the view it was rendered from, and an entity is culled only after being occluded
+* in numPyramidsToCull pyramids in a row. Since then it may have come out from behind an occluder, so culling has a second phase:
+* once the entities Cull passed are drawn, DrawRevealed tests the boxes of the culled ones against that depth with occlusion queries,
+* and draws those not entirely behind it in the same frame. The GPU skips the others itself, so the CPU never waits for the results.
+*/
+class OcclusionCuller {
+public:
+	// downsampleShader is the compute shader reducing the depth buffer, DepthDownsample.glsl, and boxShader draws the tested boxes, OcclusionBox.glsl
+	static OcclusionCuller* Create(Shader* downsampleShader, Shader* boxShader);
+	virtual ~OcclusionCuller() = default;
+
+	// Starts reducing and reading back the depth attachment of fbo, which was rendered with viewProjection. Call after DrawRevealed.
+	virtual void Capture(const FrameBuffer& fbo, const glm::mat4& viewProjection) = 0;
+	// Returns the candidate slots that are not behind the latest pyramid, in the order of candidates. All of them while there is no pyramid.
+	const std::vector<uint32_t>& Cull(const SlotBounds& bounds, const std::vector<uint32_t>& candidates);
+	// Calls drawSlot for each slot the last Cull culled, after the slots it returned are drawn into the bound frame buffer with viewProjection.
+	// Draws of a slot whose box is entirely behind the depth there are skipped by the GPU. drawSlot binds its shader, the tests bind their own.
+	void DrawRevealed(const SlotBounds& bounds, const glm::mat4& viewProjection, const std::function<void(uint32_t slot)>& drawSlot);
+
+	static constexpr int tileSize = 8; // depth buffer texels per side of a texel of the base level
+	static constexpr uint8_t numPyramidsToCull = 2;
+
+protected:
+	// Takes the newest finished readback, if any, and calls SetBase with it
+	virtual void Fetch() = 0;
+	// Starts an occlusion query for each slot, drawing its bounding box without writing color, depth or stencil
+	virtual void TestBoxes(const SlotBounds& bounds, const glm::mat4& viewProjection, const std::vector<uint32_t>& slots) = 0;
+	// Draws between the two happen only if samples of the box of test ix of the last TestBoxes passed the depth test
+	virtual void BeginConditionalDraw(size_t test) = 0;
+	virtual void EndConditionalDraw() = 0;
+	// Builds the pyramid over a base level of width x height tiles, read from a depth buffer of fboWidth x fboHeight texels
+	void SetBase(const float* tiles, int width, int height, int fboWidth, int fboHeight, const glm::mat4& viewProjection);
+
+private:
+	bool IsOccluded(const SlotBounds& bounds, uint32_t slot) const;
+	static bool IsInFrontOfCamera(const SlotBounds& bounds, uint32_t slot, const glm::mat4& viewProjection);
+
+	struct Level {
+		int width = 0;
+		int height = 0;
+		std::vector<float> depths; // farthest depth of the texels below, row by row
+	};
+	std::vector<Level> levels;
+	glm::vec2 viewportSize = glm::vec2(0.0f); // in texels of the base level
+	glm::mat4 pyramidViewProjection = glm::mat4(1.0f);
+	bool isPyramidNew = false; // not yet counted by Cull
+
+	std::vector<uint32_t> visibleSlots;
+	std::vector<uint32_t> occludedSlots; // culled by the last Cull
+	std::vector<uint32_t> testedSlots; // of occludedSlots, in front of the camera
+	std::vector<uint8_t> numPyramidsOccluded; // by slot
+	std::vector<uint8_t> nextNumPyramidsOccluded;
+};
\ No newline at end of file
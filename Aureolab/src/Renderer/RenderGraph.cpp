@@ -0,0 +1,205 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+RenderGraph::Resource RenderGraph::PassBuilder::Create(const std::string& name, const FrameBufferSpec& spec) {
+	const Resource resource = (Resource)graph.resources.size();
+	ResourceNode& node = graph.resources.emplace_back();
+	node.name = name;
+	node.spec = spec;
+	node.lastWriter = pass;
+	graph.passes[pass].writes.push_back(resource);
+	return resource;
+}
+
+void RenderGraph::PassBuilder::Read(Resource resource) {
+	assert(resource < graph.resources.size());
+	ResourceNode& node = graph.resources[resource];
+	PassNode& passNode = graph.passes[pass];
+	if (node.lastWriter != noPass && node.lastWriter != pass) {
+		passNode.producers.push_back(node.lastWriter);
+		passNode.predecessors.push_back(node.lastWriter);
+	}
+	node.readersSinceWrite.push_back(pass);
+	passNode.reads.push_back(resource);
+}
+
+void RenderGraph::PassBuilder::Write(Resource resource) {
+	assert(resource < graph.resources.size());
+	ResourceNode& node = graph.resources[resource];
+	PassNode& passNode = graph.passes[pass];
+	if (node.lastWriter != noPass && node.lastWriter != pass) {
+		passNode.producers.push_back(node.lastWriter);
+		passNode.predecessors.push_back(node.lastWriter);
+	}
+	// Readers of the previous content run before it is overwritten
+	for (uint32_t reader : node.readersSinceWrite) {
+		if (reader != pass) { passNode.predecessors.push_back(reader); }
+	}
+	node.readersSinceWrite.clear();
+	node.lastWriter = pass;
+	passNode.writes.push_back(resource);
+}
+
+void RenderGraph::PassBuilder::SetDrawAttachments(const std::vector<unsigned int>& indices) {
+	graph.passes[pass].drawAttachments = indices;
+	graph.passes[pass].hasDrawAttachments = true;
+}
+
+PipelineState& RenderGraph::PassBuilder::State() {
+	return graph.passes[pass].state;
+}
+
+void RenderGraph::PassBuilder::SetSideEffects() {
+	graph.passes[pass].hasSideEffects = true;
+}
+
+void RenderGraph::Reset(const PipelineState& baseState) {
+	passes.clear();
+	resources.clear();
+	this->baseState = baseState;
+}
+
+RenderGraph::Resource RenderGraph::Import(const std::string& name, FrameBuffer* fbo) {
+	assert(fbo != nullptr);
+	const Resource resource = (Resource)resources.size();
+	ResourceNode& node = resources.emplace_back();
+	node.name = name;
+	node.spec = fbo->GetSpec();
+	node.fbo = fbo;
+	node.isImported = true;
+	return resource;
+}
+
+void RenderGraph::AddPass(const std::string& name, const SetupFunction& setup, const ExecuteFunction& execute) {
+	const uint32_t pass = (uint32_t)passes.size();
+	PassNode& node = passes.emplace_back();
+	node.name = name;
+	node.execute = execute;
+	node.state = baseState;
+	PassBuilder builder(*this, pass);
+	setup(builder);
+}
+
+FrameBuffer* RenderGraph::GetFrameBuffer(Resource resource) const {
+	assert(resource < resources.size() && resources[resource].fbo != nullptr); // not a resource of a pass that is running
+	return resources[resource].fbo;
+}
+
+void RenderGraph::Cull() {
+	// From the passes kept for their own sake back through the passes whose writes they need
+	std::vector<uint32_t> stack;
+	for (uint32_t pass = 0; pass < passes.size(); pass++) {
+		PassNode& node = passes[pass];
+		node.isKept = node.hasSideEffects || std::any_of(node.writes.begin(), node.writes.end(), [&](Resource resource) { return resources[resource].isImported; });
+		if (node.isKept) { stack.push_back(pass); }
+	}
+	while (!stack.empty()) {
+		const uint32_t pass = stack.back();
+		stack.pop_back();
+		for (uint32_t producer : passes[pass].producers) {
+			if (passes[producer].isKept) { continue; }
+			passes[producer].isKept = true;
+			stack.push_back(producer);
+		}
+	}
+}
+
+void RenderGraph::Order() {
+	// Predecessors were added before their passes, so there are no cycles
+	std::vector<uint32_t> numWaiting(passes.size(), 0); // kept predecessors that have not run yet
+	std::vector<std::vector<uint32_t>> successors(passes.size());
+	std::vector<uint32_t> ready;
+	for (uint32_t pass = 0; pass < passes.size(); pass++) {
+		if (!passes[pass].isKept) { continue; }
+		for (uint32_t predecessor : passes[pass].predecessors) {
+			if (!passes[predecessor].isKept) { continue; }
+			successors[predecessor].push_back(pass);
+			numWaiting[pass]++;
+		}
+		if (numWaiting[pass] == 0) { ready.push_back(pass); }
+	}
+
+	auto getTarget = [&](uint32_t pass) { return passes[pass].writes.empty() ? invalidResource : passes[pass].writes[0]; };
+	order.clear();
+	Resource boundTarget = invalidResource;
+	while (!ready.empty()) {
+		// The first added of the passes drawing into the bound framebuffer, else the first added
+		auto next = std::min_element(ready.begin(), ready.end(), [&](uint32_t a, uint32_t b) {
+			const bool isBoundA = boundTarget != invalidResource && getTarget(a) == boundTarget;
+			const bool isBoundB = boundTarget != invalidResource && getTarget(b) == boundTarget;
+			return isBoundA != isBoundB ? isBoundA : a < b;
+		});
+		const uint32_t pass = *next;
+		ready.erase(next);
+		order.push_back(pass);
+		if (getTarget(pass) != invalidResource) { boundTarget = getTarget(pass); }
+		for (uint32_t successor : successors[pass]) {
+			if (--numWaiting[successor] == 0) { ready.push_back(successor); }
+		}
+	}
+}
+
+void RenderGraph::Execute(RenderTargetPool& pool) {
+	if (!gpuTimer) { gpuTimer.reset(GpuTimer::Create()); }
+	gpuTimer->BeginFrame();
+	// Each pass is measured from the timestamp before it
+	const std::vector<GpuTimer::Timestamp>& timestamps = gpuTimer->GetLatestFrame();
+	for (size_t ix = 1; ix < timestamps.size(); ix++) {
+		gpuMilliseconds[timestamps[ix].label] = (float)(timestamps[ix].milliseconds - timestamps[ix - 1].milliseconds);
+	}
+
+	Cull();
+	Order();
+	for (uint32_t position = 0; position < order.size(); position++) {
+		const PassNode& pass = passes[order[position]];
+		for (Resource resource : pass.reads) { resources[resource].lastUse = position; }
+		for (Resource resource : pass.writes) { resources[resource].lastUse = position; }
+	}
+
+	timings.clear();
+	std::vector<unsigned int> allAttachments;
+	FrameBuffer* boundFbo = nullptr;
+	gpuTimer->Record("");
+	for (uint32_t position = 0; position < order.size(); position++) {
+		const PassNode& pass = passes[order[position]];
+		const auto start = std::chrono::steady_clock::now();
+		// Transient framebuffers from their first pass to their last one
+		for (Resource resource : pass.writes) {
+			ResourceNode& node = resources[resource];
+			if (node.fbo == nullptr) { node.fbo = pool.Acquire(node.spec); }
+		}
+		GraphicsAPI::Get()->SetPipelineState(pass.state);
+		if (!pass.writes.empty()) {
+			boundFbo = resources[pass.writes[0]].fbo;
+			if (!pass.hasDrawAttachments) {
+				allAttachments.resize(boundFbo->GetNumColorAttachments());
+				for (unsigned int ix = 0; ix < allAttachments.size(); ix++) { allAttachments[ix] = ix; }
+			}
+			boundFbo->SetDrawAttachments(pass.hasDrawAttachments ? pass.drawAttachments : allAttachments); // also binds it
+		}
+
+		pass.execute(*this);
+
+		for (const std::vector<Resource>* used : { &pass.reads, &pass.writes }) {
+			for (Resource resource : *used) {
+				ResourceNode& node = resources[resource];
+				if (node.isImported || node.fbo == nullptr || node.lastUse != position) { continue; }
+				pool.Release(node.fbo);
+				node.fbo = nullptr;
+			}
+		}
+		gpuTimer->Record(pass.name);
+		const std::chrono::duration<float, std::milli> cpuTime = std::chrono::steady_clock::now() - start;
+		auto gpuTime = gpuMilliseconds.find(pass.name);
+		timings.push_back({ pass.name, false, cpuTime.count(), gpuTime != gpuMilliseconds.end() ? gpuTime->second : -1.0f });
+	}
+	for (const PassNode& pass : passes) {
+		if (!pass.isKept) { timings.push_back({ pass.name, true }); }
+	}
+
+	GraphicsAPI::Get()->SetPipelineState(baseState);
+	if (boundFbo != nullptr) { boundFbo->Unbind(); }
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Renderer/FrameBuffer.h"
+#include "Renderer/GraphicsAPI.h"
+#include "Renderer/GpuTimer.h"
+#include "Renderer/RenderTargetPool.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+* A frame as passes that declare the framebuffers they read and write. Execute orders the passes by these dependencies and culls the
+* ones whose writes are not needed: a pass is kept when it has side effects, writes an imported framebuffer, or writes what a kept pass
+* reads. Passes writing the same framebuffer run in the order they were added, since each draws over what the earlier ones left.
+* Among passes that are ready, the one drawing into the framebuffer bound last goes first.
+* Transient framebuffers come from a RenderTargetPool for the span of passes using them, so the ones that do not overlap share targets.
+* Before each pass, the graph binds the first framebuffer it writes with its draw attachments, and sets its pipeline state, which
+* GraphicsAPI reduces to the changes. The graph is declared again every frame, which only stores the passes and their functions.
+*/
+class RenderGraph {
+public:
+	using Resource = uint32_t;
+	static constexpr Resource invalidResource = UINT32_MAX;
+
+	// Declares what a pass uses, in the setup function of AddPass
+	class PassBuilder {
+	public:
+		// Framebuffer of this frame, got from the pool when the pass runs. The pass writes it.
+		Resource Create(const std::string& name, const FrameBufferSpec& spec);
+		void Read(Resource resource);
+		// The pass draws into resource, over what earlier passes writing it left
+		void Write(Resource resource);
+		// Color attachments of the bound framebuffer that the pass draws into, all of them by default
+		void SetDrawAttachments(const std::vector<unsigned int>& indices);
+		// Starts as the state of the last Reset
+		PipelineState& State();
+		// Keeps the pass even if nothing reads what it writes, e.g. for readbacks
+		void SetSideEffects();
+	private:
+		friend class RenderGraph;
+		PassBuilder(RenderGraph& graph, uint32_t pass) : graph(graph), pass(pass) {}
+		RenderGraph& graph;
+		uint32_t pass;
+	};
+	using SetupFunction = std::function<void(PassBuilder&)>;
+	using ExecuteFunction = std::function<void(const RenderGraph&)>;
+
+	// Forgets the passes and resources of the previous frame. Passes start with baseState, which is set again after the last one.
+	void Reset(const PipelineState& baseState);
+	// Framebuffer owned outside of the graph. Its content is an output of the frame.
+	Resource Import(const std::string& name, FrameBuffer* fbo);
+	// setup runs right away, execute during Execute if the pass is not culled
+	void AddPass(const std::string& name, const SetupFunction& setup, const ExecuteFunction& execute);
+	// Orders, culls and runs the passes. Transient framebuffers come from pool.
+	void Execute(RenderTargetPool& pool);
+	// For execute functions, valid during the passes using resource
+	FrameBuffer* GetFrameBuffer(Resource resource) const;
+
+	struct PassTiming {
+		std::string name;
+		bool isCulled = false;
+		float cpuMilliseconds = 0.0f;
+		float gpuMilliseconds = -1.0f; // of the latest measured frame the pass ran in, negative until measured
+	};
+	// Passes of the last Execute in the order they ran, then the culled ones
+	const std::vector<PassTiming>& GetTimings() const { return timings; }
+
+private:
+	static constexpr uint32_t noPass = UINT32_MAX;
+	struct ResourceNode {
+		std::string name;
+		FrameBufferSpec spec;
+		FrameBuffer* fbo = nullptr; // imported, or from the pool while its passes run
+		bool isImported = false;
+		uint32_t lastWriter = noPass; // while passes are added
+		std::vector<uint32_t> readersSinceWrite; // same
+		uint32_t lastUse = 0; // position in the execution order
+	};
+	struct PassNode {
+		std::string name;
+		ExecuteFunction execute;
+		std::vector<Resource> reads;
+		std::vector<Resource> writes;
+		std::vector<unsigned int> drawAttachments;
+		bool hasDrawAttachments = false;
+		PipelineState state;
+		bool hasSideEffects = false;
+		std::vector<uint32_t> producers; // passes that write what this one reads or draws over
+		std::vector<uint32_t> predecessors; // producers, and passes reading what this one overwrites
+		bool isKept = false;
+	};
+	void Cull();
+	void Order();
+
+	std::vector<PassNode> passes;
+	std::vector<ResourceNode> resources;
+	PipelineState baseState;
+	std::vector<uint32_t> order; // of kept passes
+	std::vector<PassTiming> timings;
+	std::unique_ptr<GpuTimer> gpuTimer; // created at the first Execute
+	std::unordered_map<std::string, float> gpuMilliseconds; // by pass name, of the latest measured frame
+};
\ No newline at end of file
@@ -0,0 +1,311 @@
+#include "RenderQueue.h"
+
+#include "Core/ThreadPool.h"
+#include "Renderer/GraphicsAPI.h"
+#include "Scene/MeshAssetRegistry.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+// Sort key layout, from the most significant bit:
+// opaque:      pass (2) | state (32) | depth (24)
+// transparent: pass (2) | inverted depth (24) | state (32)
+// where state is shader (8) | visualization (4) | vertex array (16) | LOD (3) | stencil mask is set (1).
+// The vertex array field holds the low 15 bits of the VAO id, its top bit is pooledGeometryBit.
+// Packets of pooled meshes have the pool instead of the vertex array, and no visualization and LOD, so that a pool is not split into several multi-draws.
+static constexpr int passShift = 62;
+static constexpr int numDepthBits = 24;
+static constexpr int numStateBits = 32;
+static constexpr uint64_t pooledGeometryBit = 0x8000;
+static constexpr UniformHandle uFirstDraw = "u_FirstDraw"_uniform;
+
+// The bits of a non-negative float sort like the float. Dropping low mantissa bits keeps the order, with ties.
+static uint64_t QuantizeDepth(float depth) {
+	depth = std::max(depth, 0.0f);
+	uint32_t bits = 0;
+	std::memcpy(&bits, &depth, sizeof(bits));
+	return bits >> (32 - numDepthBits);
+}
+
+// Least significant digit first radix sort on bytes of the key. Skips bytes that are the same for all items. scratch has the same size as items.
+template <class Item>
+static void RadixSort(Item* items, Item* scratch, size_t numItems) {
+	if (numItems < 2) { return; }
+	uint64_t differingBits = 0;
+	for (size_t ix = 1; ix < numItems; ix++) { differingBits |= items[ix].key ^ items[0].key; }
+
+	Item* source = items;
+	Item* destination = scratch;
+	for (int shift = 0; shift < 64; shift += 8) {
+		if (((differingBits >> shift) & 0xFF) == 0) { continue; }
+		size_t offsets[256] = {};
+		for (size_t ix = 0; ix < numItems; ix++) { offsets[(source[ix].key >> shift) & 0xFF]++; }
+		size_t sum = 0;
+		for (size_t& offset : offsets) {
+			const size_t count = offset;
+			offset = sum;
+			sum += count;
+		}
+		for (size_t ix = 0; ix < numItems; ix++) { destination[offsets[(source[ix].key >> shift) & 0xFF]++] = source[ix]; }
+		std::swap(source, destination);
+	}
+	if (source != items) { std::copy(source, source + numItems, items); }
+}
+
+RenderQueue::~RenderQueue() {
+	delete indirectDraws;
+}
+
+void RenderQueue::BlockBind(Shader* shader) {
+	GetIndirectDraws()->BlockBind(shader);
+}
+
+void RenderQueue::Clear() {
+	packets.clear();
+	items.clear();
+	shaders.clear();
+	batches.clear();
+	firstTransparentBatch = 0;
+}
+
+void RenderQueue::Add(Shader* shader, const ViewData& viewData, const SceneBuffer& sceneBuffer, entt::entity ent, const MeshComponent& mesh, unsigned int stencilMask) {
+	const uint32_t slot = sceneBuffer.GetSlot(ent);
+	if (slot == SceneBuffer::invalidSlot) { return; }
+	mesh.lod = Renderer::SelectLod(viewData, sceneBuffer.GetEntityData(slot).model, mesh.asset.get(), mesh.lod);
+	Add(shader, viewData, sceneBuffer, slot, mesh.asset.get(), mesh.lod, stencilMask);
+}
+
+void RenderQueue::Add(Shader* shader, const ViewData& viewData, const SceneBuffer& sceneBuffer, entt::entity ent, const ProceduralMeshComponent& pMesh, unsigned int stencilMask) {
+	const uint32_t slot = sceneBuffer.GetSlot(ent);
+	if (slot == SceneBuffer::invalidSlot) { return; }
+	Add(shader, viewData, sceneBuffer, slot, pMesh.asset.get(), 0, stencilMask);
+}
+
+void RenderQueue::Add(Shader* shader, const ViewData& viewData, const SceneBuffer& sceneBuffer, uint32_t slot, const MeshAsset* asset, int lod, unsigned int stencilMask) {
+	if (asset == nullptr) { return; }
+	if (!asset->isReady) { asset = MeshAssetRegistry::GetPlaceholder(); }
+	const EntityData& data = sceneBuffer.GetEntityData(slot);
+
+	uint64_t state = ShaderIndex(shader) << 24 | (uint64_t)(stencilMask != 0);
+	if (Renderer::isMultiDrawIndirectEnabled) {
+		state |= ((uint64_t)GeometryPool::Add(asset).pool->GetIndex() | pooledGeometryBit) << 4;
+	}
+	else {
+		state |= (uint64_t)(data.visualization & 0xF) << 20
+			| (uint64_t)(asset->vao->GetRendererID() & (pooledGeometryBit - 1)) << 4
+			| (uint64_t)(std::min(lod, 7)) << 1;
+	}
+	const glm::vec3 centerView = glm::vec3(viewData.view * data.model * glm::vec4(asset->bounds.center, 1.0f));
+	const uint64_t depth = QuantizeDepth(-centerView.z);
+	const uint64_t key = IsTransparent(data)
+		? (uint64_t)RenderPass::Transparent << passShift | (~depth & ((1ull << numDepthBits) - 1)) << numStateBits | state
+		: (uint64_t)RenderPass::Opaque << passShift | state << numDepthBits | depth;
+
+	items.push_back({ key, (uint32_t)packets.size() });
+	packets.push_back({ shader, asset, slot, lod, stencilMask });
+}
+
+bool RenderQueue::IsTransparent(const EntityData& data) {
+	return data.visualization == (int)MeshRendererComponent::Visualization::Lit && data.alpha < 1.0f;
+}
+
+uint64_t RenderQueue::ShaderIndex(Shader* shader) {
+	auto it = std::find(shaders.begin(), shaders.end(), shader);
+	if (it == shaders.end()) {
+		shaders.push_back(shader);
+		it = shaders.end() - 1;
+	}
+	assert(shaders.size() <= 256); // has 8 bits in the sort key
+	return (uint64_t)(it - shaders.begin());
+}
+
+void RenderQueue::Sort() {
+	scratch.resize(items.size());
+	const size_t numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	if (items.size() < parallelSortMinPackets || numThreads == 1) {
+		RadixSort(items.data(), scratch.data(), items.size());
+		return;
+	}
+
+	// Sort chunks in parallel, then merge pairs of neighboring chunks in parallel until one is left
+	ThreadPool& workers = ThreadPool::GetShared();
+	const size_t numChunks = std::min(numThreads, items.size() / (parallelSortMinPackets / 2));
+	std::vector<size_t> bounds(numChunks + 1);
+	for (size_t ix = 0; ix <= numChunks; ix++) { bounds[ix] = items.size() * ix / numChunks; }
+	workers.RunInParallel(numChunks, [&](size_t chunk) {
+		RadixSort(items.data() + bounds[chunk], scratch.data() + bounds[chunk], bounds[chunk + 1] - bounds[chunk]);
+	});
+	auto byKey = [](const SortItem& a, const SortItem& b) { return a.key < b.key; };
+	while (bounds.size() > 2) {
+		const size_t numPairs = bounds.size() / 2; // of chunks, the last one may be alone
+		workers.RunInParallel(numPairs, [&](size_t pair) {
+			const size_t begin = bounds[2 * pair];
+			const size_t middle = bounds[std::min(2 * pair + 1, bounds.size() - 1)];
+			const size_t end = bounds[std::min(2 * pair + 2, bounds.size() - 1)];
+			std::merge(items.begin() + begin, items.begin() + middle, items.begin() + middle, items.begin() + end, scratch.begin() + begin, byKey);
+		});
+		std::swap(items, scratch);
+		std::vector<size_t> merged;
+		for (size_t ix = 0; ix < bounds.size(); ix += 2) { merged.push_back(bounds[ix]); }
+		if (merged.back() != bounds.back()) { merged.push_back(bounds.back()); }
+		bounds = std::move(merged);
+	}
+}
+
+// Appends the command of a packet of a pooled mesh
+void RenderQueue::AddIndirectDraw(const DrawPacket& packet) {
+	const MeshAsset* asset = packet.asset;
+	const PoolRange& range = asset->poolRange;
+	uint32_t firstIndex = 0;
+	uint32_t count = range.numIndices;
+	if (!asset->lods.empty()) {
+		const MeshLod& meshLod = asset->lods[std::clamp(packet.lod, 0, (int)asset->lods.size() - 1)];
+		firstIndex = meshLod.indexOffset;
+		count = meshLod.indexCount;
+	}
+	IndirectDraw draw;
+	draw.command = { count, 1, range.firstIndex + firstIndex, range.baseVertex, packet.slot }; // the instance buffer maps the slot to itself
+	draw._pad[0] = draw._pad[1] = draw._pad[2] = 0;
+	draw.positionOffset = glm::vec4(asset->decoding.positionOffset, 0.0f);
+	draw.positionScale = glm::vec4(asset->decoding.positionScale, 0.0f);
+	draws.push_back(draw);
+}
+
+// Packets that can be drawn instanced together, if there are enough of them
+static bool IsSameDraw(const DrawPacket& a, const DrawPacket& b) {
+	return a.shader == b.shader && a.asset == b.asset && a.lod == b.lod && a.stencilMask == b.stencilMask;
+}
+
+void RenderQueue::Prepare(SceneBuffer& sceneBuffer) {
+	Sort();
+	Renderer::stats.numDrawPackets += (int)packets.size();
+
+	// Group runs of packets of the same draw, and stage the slots of the instanced ones and the commands of multi-draws before any draw
+	batches.clear();
+	draws.clear();
+	for (size_t begin = 0; begin < items.size();) {
+		const DrawPacket& first = packets[items[begin].packet];
+		const GeometryPool* pool = first.asset->poolRange.pool;
+		const bool isMultiDraw = Renderer::isMultiDrawIndirectEnabled && pool != nullptr;
+		size_t end = begin + 1;
+		while (end < items.size() && items[end].key >> passShift == items[begin].key >> passShift) {
+			const DrawPacket& packet = packets[items[end].packet];
+			const bool isSame = isMultiDraw
+				? packet.shader == first.shader && packet.stencilMask == first.stencilMask && packet.asset->poolRange.pool == pool
+				: IsSameDraw(packet, first);
+			if (!isSame) { break; }
+			end++;
+		}
+		Batch batch;
+		batch.first = (uint32_t)begin;
+		batch.count = (uint32_t)(end - begin);
+		if (isMultiDraw) {
+			batch.pool = pool;
+			batch.firstDraw = (uint32_t)draws.size();
+			for (size_t ix = begin; ix < end; ix++) { AddIndirectDraw(packets[items[ix].packet]); }
+		}
+		else if (Renderer::isInstancingEnabled && batch.count >= (uint32_t)Renderer::minInstances) {
+			uint32_t* slots = sceneBuffer.StageInstances(batch.count, batch.baseInstance);
+			for (uint32_t ix = 0; ix < batch.count; ix++) { slots[ix] = packets[items[begin + ix].packet].slot; }
+		}
+		batches.push_back(batch);
+		begin = end;
+	}
+	firstTransparentBatch = batches.size();
+	for (size_t ix = 0; ix < batches.size(); ix++) {
+		if (items[batches[ix].first].key >> passShift == (uint64_t)RenderPass::Transparent) {
+			firstTransparentBatch = ix;
+			break;
+		}
+	}
+	if (!draws.empty()) {
+		StorageBuffer* buffer = GetIndirectDraws();
+		const unsigned int size = (unsigned int)(draws.size() * sizeof(IndirectDraw));
+		buffer->Reserve(size);
+		std::memcpy(buffer->Stage(0, size), draws.data(), size);
+		buffer->Flush();
+	}
+}
+
+void RenderQueue::Submit(const ViewData& viewData, const SceneBuffer& sceneBuffer, const std::function<void()>& afterOpaque) {
+	Draw(0, batches.size(), viewData, sceneBuffer, afterOpaque);
+}
+
+void RenderQueue::Submit(RenderPass pass, const ViewData& viewData, const SceneBuffer& sceneBuffer) {
+	if (pass == RenderPass::Opaque) { Draw(0, firstTransparentBatch, viewData, sceneBuffer, {}); }
+	else { Draw(firstTransparentBatch, batches.size(), viewData, sceneBuffer, {}); }
+}
+
+void RenderQueue::Draw(size_t firstBatch, size_t endBatch, const ViewData& viewData, const SceneBuffer& sceneBuffer, const std::function<void()>& afterOpaque) {
+	GraphicsAPI* api = GraphicsAPI::Get();
+	const bool wasBlending = api->IsEnabled(GraphicsAbility::Blend);
+	bool isTransparentPass = false;
+	Shader* boundShader = nullptr;
+	const MeshAsset* boundAsset = nullptr;
+	unsigned int stencilMask = 0;
+	bool isStencilMaskSet = false;
+	for (size_t batchIx = firstBatch; batchIx < endBatch; batchIx++) {
+		const Batch& batch = batches[batchIx];
+		const SortItem& item = items[batch.first];
+		const DrawPacket& packet = packets[item.packet];
+		if (!isTransparentPass && item.key >> passShift == (uint64_t)RenderPass::Transparent) {
+			isTransparentPass = true;
+			if (afterOpaque) {
+				afterOpaque();
+				boundShader = nullptr; // it may have bound others, and set other uniforms and stencil masks
+				isStencilMaskSet = false;
+			}
+			api->Enable(GraphicsAbility::Blend);
+			api->SetBlendingFunction(BlendingFactor::SourceAlpha, BlendingFactor::OneMinusSourceAlpha);
+		}
+		if (packet.shader != boundShader) {
+			packet.shader->Bind();
+			boundShader = packet.shader;
+			boundAsset = nullptr; // uniforms are per program
+			Renderer::stats.numStateChanges++;
+		}
+		if (batch.pool != nullptr) {
+			// Positions are decoded per draw, only the normal encoding is the same for the whole pool
+			VertexDecoding decoding;
+			decoding.octahedralNormals = batch.pool->GetFormat() != VertexFormat::Basic;
+			decoding.UploadUniforms(packet.shader);
+			packet.shader->UploadUniformInt(uFirstDraw, (int)batch.firstDraw);
+			boundAsset = nullptr;
+			Renderer::stats.numStateChanges++;
+		}
+		else if (packet.asset != boundAsset) {
+			packet.asset->decoding.UploadUniforms(packet.shader);
+			packet.shader->UploadUniformInt(uFirstDraw, -1);
+			boundAsset = packet.asset;
+			Renderer::stats.numStateChanges++;
+		}
+		if (!isStencilMaskSet || packet.stencilMask != stencilMask) {
+			api->SetStencilMask(packet.stencilMask);
+			stencilMask = packet.stencilMask;
+			isStencilMaskSet = true;
+			Renderer::stats.numStateChanges++;
+		}
+		if (batch.pool != nullptr) {
+			Renderer::MultiDrawIndirect(*batch.pool, *GetIndirectDraws(), batch.firstDraw, batch.count);
+			continue;
+		}
+		if (batch.baseInstance != SceneBuffer::invalidSlot) {
+			Renderer::DrawMeshAssetInstanced(packet.asset, packet.lod, batch.count, batch.baseInstance);
+			continue;
+		}
+		for (uint32_t ix = batch.first; ix < batch.first + batch.count; ix++) {
+			const DrawPacket& single = packets[items[ix].packet];
+			Renderer::DrawMeshAsset(viewData, sceneBuffer, single.slot, single.asset, single.lod);
+		}
+	}
+	if (!isTransparentPass && afterOpaque) { afterOpaque(); }
+	if (isTransparentPass && !wasBlending) { api->Disable(GraphicsAbility::Blend); }
+}
+
+StorageBuffer* RenderQueue::GetIndirectDraws() {
+	if (indirectDraws == nullptr) { indirectDraws = StorageBuffer::Create("IndirectDraws", 1024 * sizeof(IndirectDraw)); }
+	return indirectDraws;
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Renderer/GeometryPool.h"
+#include "Renderer/MeshAsset.h"
+#include "Renderer/Renderer.h"
+#include "Renderer/SceneBuffer.h"
+#include "Renderer/Shader.h"
+#include "Renderer/StorageBuffer.h"
+#include "Scene/Components.h"
+
+#include <entt/entt.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+enum class RenderPass {
+	Opaque, // front to back
+	Transparent, // back to front, blended
+};
+
+// What is needed to draw one mesh of an entity
+struct DrawPacket {
+	Shader* shader = nullptr;
+	const MeshAsset* asset = nullptr;
+	uint32_t slot = SceneBuffer::invalidSlot;
+	int lod = 0;
+	unsigned int stencilMask = 0xFF;
+};
+
+/*
+* Collects the draws of a pass from all renderable component types, and submits them in an order that changes little state between draws.
+* Each packet has a 64-bit sort key. Opaque packets are ordered by shader, visualization, vertex array and stencil mask, then front to back.
+* Transparent ones come after them, back to front, since their order matters more than the state changes.
+* Runs of packets that differ only in the entity are drawn with one instanced draw call, see Renderer::isInstancingEnabled.
+* With Renderer::isMultiDrawIndirectEnabled, packets of meshes in the same geometry pool are grouped instead, and drawn with one multi-draw.
+*/
+class RenderQueue {
+public:
+	RenderQueue() = default;
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+	~RenderQueue();
+
+	// The shader can then read the commands of multi-draws
+	void BlockBind(Shader* shader);
+	void Clear();
+	void Add(Shader* shader, const ViewData& viewData, const SceneBuffer& sceneBuffer, entt::entity ent, const MeshComponent& mesh, unsigned int stencilMask = 0xFF);
+	void Add(Shader* shader, const ViewData& viewData, const SceneBuffer& sceneBuffer, entt::entity ent, const ProceduralMeshComponent& pMesh, unsigned int stencilMask = 0xFF);
+	// Sorts the packets, and stages the slots of instanced draws and the commands of multi-draws. Call after the last Add of the frame,
+	// then SceneBuffer::FlushInstances once, so that the staged slots of the whole frame become visible to the draws together.
+	void Prepare(SceneBuffer& sceneBuffer);
+	// Draws the prepared packets. Binds shaders as needed, and leaves the last one bound.
+	// afterOpaque is called once the opaque packets are drawn, before the transparent ones, e.g. to capture the depth of opaque geometry.
+	void Submit(const ViewData& viewData, const SceneBuffer& sceneBuffer, const std::function<void()>& afterOpaque = {});
+	// Draws the prepared packets of one pass only, e.g. when other passes of the frame come between them
+	void Submit(RenderPass pass, const ViewData& viewData, const SceneBuffer& sceneBuffer);
+
+	size_t GetNumPackets() const { return packets.size(); }
+	// Lit entities that are not fully opaque, which go to the Transparent pass
+	static bool IsTransparent(const EntityData& data);
+
+	// Queues with at least this many packets are sorted in chunks on worker threads
+	static inline size_t parallelSortMinPackets = 16384;
+private:
+	struct SortItem {
+		uint64_t key;
+		uint32_t packet; // index in packets
+	};
+	// Sorted items drawn together
+	struct Batch {
+		uint32_t first; // index in items
+		uint32_t count;
+		uint32_t baseInstance = SceneBuffer::invalidSlot; // of the staged slots if drawn instanced
+		const GeometryPool* pool = nullptr; // if drawn with a multi-draw
+		uint32_t firstDraw = 0; // in indirectDraws
+	};
+
+	void Add(Shader* shader, const ViewData& viewData, const SceneBuffer& sceneBuffer, uint32_t slot, const MeshAsset* asset, int lod, unsigned int stencilMask);
+	uint64_t ShaderIndex(Shader* shader);
+	StorageBuffer* GetIndirectDraws();
+	void AddIndirectDraw(const DrawPacket& packet);
+	void Sort();
+	// Draws the batches in [firstBatch, endBatch)
+	void Draw(size_t firstBatch, size_t endBatch, const ViewData& viewData, const SceneBuffer& sceneBuffer, const std::function<void()>& afterOpaque);
+
+	std::vector<DrawPacket> packets;
+	std::vector<SortItem> items;
+	std::vector<SortItem> scratch;
+	std::vector<Batch> batches; // of the last Prepare
+	size_t firstTransparentBatch = 0;
+	std::vector<IndirectDraw> draws; // of this Submit
+	StorageBuffer* indirectDraws = nullptr; // created on first use, when a graphics context is current
+	std::vector<Shader*> shaders; // of this frame's packets, index is part of the sort key
+};
\ No newline at end of file
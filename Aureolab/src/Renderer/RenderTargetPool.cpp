@@ -0,0 +1,130 @@
+#include "RenderTargetPool.h"
+
+#include "Core/Log.h"
+
+#include <algorithm>
+#include <cassert>
+
+// Bytes per sample of an attachment, as the driver is likely to store it
+static size_t GetTexelSize(FrameBuffer::TextureFormat textureFormat) {
+	return textureFormat == FrameBuffer::TextureFormat::RGBA16F ? 8 : 4;
+}
+
+void RenderTargetPool::SetViewportSize(int width, int height) {
+	width = std::max(width, 1);
+	height = std::max(height, 1);
+	if (!hasViewportSize) {
+		// Nothing was drawn at a real size yet, so there is nothing to keep
+		viewportWidth = width;
+		viewportHeight = height;
+		hasViewportSize = true;
+	}
+	if (width != pendingWidth || height != pendingHeight) { numStableFrames = 0; }
+	pendingWidth = width;
+	pendingHeight = height;
+}
+
+void RenderTargetPool::BeginFrame() {
+	frame++;
+	if (IsResizePending() && ++numStableFrames >= resizeDelayFrames) {
+		viewportWidth = pendingWidth;
+		viewportHeight = pendingHeight;
+	}
+	// Names nobody got for that long, e.g. of a mode that was switched off, let go of their targets, which are then freed like the others
+	std::erase_if(namedTargets, [&](const auto& entry) {
+		Target* target = Find(entry.second);
+		assert(target != nullptr && target->isHeld);
+		if (frame - target->lastUsedFrame <= maxUnusedFrames) { return false; }
+		target->isHeld = false;
+		return true;
+	});
+	for (auto& [key, bucket] : buckets) {
+		std::erase_if(bucket, [&](const Target& target) { return !target.isHeld && frame - target.lastUsedFrame > maxUnusedFrames; });
+	}
+	std::erase_if(buckets, [](const auto& entry) { return entry.second.empty(); });
+}
+
+void RenderTargetPool::Clear() {
+	namedTargets.clear();
+	buckets.clear();
+}
+
+FrameBuffer* RenderTargetPool::Get(const std::string& name, const FrameBufferSpec& spec) {
+	const FrameBufferSpec resolvedSpec = Resolve(spec);
+	FrameBuffer*& fbo = namedTargets[name];
+	if (fbo != nullptr && fbo->GetSpec() == resolvedSpec) {
+		Find(fbo)->lastUsedFrame = frame;
+		return fbo;
+	}
+	// The previous target stays in the pool, and comes back if the size does, e.g. when a drag returns to where it started
+	if (fbo != nullptr) { Release(fbo); }
+	fbo = Take(resolvedSpec);
+	return fbo;
+}
+
+FrameBuffer* RenderTargetPool::Acquire(const FrameBufferSpec& spec) {
+	return Take(Resolve(spec));
+}
+
+void RenderTargetPool::Release(FrameBuffer* fbo) {
+	Target* target = Find(fbo);
+	assert(target != nullptr && target->isHeld); // not a held target of this pool
+	target->isHeld = false;
+	target->lastUsedFrame = frame;
+}
+
+size_t RenderTargetPool::GetNumTargets() const {
+	size_t numTargets = 0;
+	for (const auto& [key, bucket] : buckets) { numTargets += bucket.size(); }
+	return numTargets;
+}
+
+size_t RenderTargetPool::GetNumBytes() const {
+	size_t numBytes = 0;
+	for (const auto& [key, bucket] : buckets) {
+		for (const Target& target : bucket) {
+			const FrameBufferSpec& spec = target.fbo->GetSpec();
+			for (FrameBuffer::TextureFormat textureFormat : spec.attachments) {
+				numBytes += (size_t)spec.width * spec.height * spec.samples * GetTexelSize(textureFormat);
+			}
+		}
+	}
+	return numBytes;
+}
+
+FrameBufferSpec RenderTargetPool::Resolve(const FrameBufferSpec& spec) const {
+	FrameBufferSpec resolvedSpec = spec;
+	if (spec.width == 0 || spec.height == 0) {
+		resolvedSpec.width = std::max((int)(viewportWidth * spec.scale), 1);
+		resolvedSpec.height = std::max((int)(viewportHeight * spec.scale), 1);
+	}
+	resolvedSpec.scale = 1.0f; // the size is final, so specs that resolve to the same one are the same
+	return resolvedSpec;
+}
+
+std::string RenderTargetPool::GetBucketKey(const FrameBufferSpec& resolvedSpec) {
+	std::string key = std::to_string(resolvedSpec.width) + "x" + std::to_string(resolvedSpec.height) + "x" + std::to_string(resolvedSpec.samples);
+	for (FrameBuffer::TextureFormat textureFormat : resolvedSpec.attachments) { key += "," + std::to_string((int)textureFormat); }
+	return key;
+}
+
+RenderTargetPool::Target* RenderTargetPool::Find(FrameBuffer* fbo) {
+	auto bucket = buckets.find(GetBucketKey(fbo->GetSpec()));
+	if (bucket == buckets.end()) { return nullptr; }
+	auto target = std::find_if(bucket->second.begin(), bucket->second.end(), [fbo](const Target& target) { return target.fbo.get() == fbo; });
+	return target != bucket->second.end() ? &*target : nullptr;
+}
+
+FrameBuffer* RenderTargetPool::Take(const FrameBufferSpec& resolvedSpec) {
+	const std::string key = GetBucketKey(resolvedSpec);
+	std::vector<Target>& bucket = buckets[key];
+	auto target = std::find_if(bucket.begin(), bucket.end(), [](const Target& target) { return !target.isHeld; });
+	if (target == bucket.end()) {
+		Log::Debug("Allocating render target {}", key);
+		bucket.push_back({ std::unique_ptr<FrameBuffer>(FrameBuffer::Create(resolvedSpec)) });
+		target = bucket.end() - 1;
+	}
+	target->isHeld = true;
+	target->lastUsedFrame = frame;
+	return target->fbo.get();
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Renderer/FrameBuffer.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+* Owns the framebuffers that render passes draw into. Targets are bucketed by size, sample count and attachment formats, and a request
+* is served by a target of its bucket that nobody holds before a new one is allocated. Specs without a size follow the viewport size.
+* A new viewport size is applied only after it has stayed the same for resizeDelayFrames frames, so dragging a panel border allocates
+* once at the end of the drag instead of every frame. Until then targets keep their old size and are stretched on display.
+* Transient targets are held from Acquire to Release, so passes that do not overlap in a frame share the same target.
+* Named targets are held across frames, for content that has to outlive the frame, like the image a panel displays, until their name is not requested for a while.
+*/
+class RenderTargetPool {
+public:
+	RenderTargetPool() = default;
+	RenderTargetPool(const RenderTargetPool&) = delete;
+	RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+	// Size that specs without one get, times their scale. The first one is applied right away, later ones by BeginFrame once stable.
+	void SetViewportSize(int width, int height);
+	// Call once per frame before getting targets. Applies a stable viewport size, and frees targets nobody held, and named ones nobody got,
+	// for maxUnusedFrames frames.
+	void BeginFrame();
+	// Deletes all targets, while the graphics context is still alive
+	void Clear();
+
+	// Target held under name until a request with another spec or after a resize, when the previous one goes back to the pool.
+	// Call every frame the target is used, which keeps it from being freed.
+	FrameBuffer* Get(const std::string& name, const FrameBufferSpec& spec);
+	// Target held until Release. Its content and draw attachments are as an earlier pass that released it left them.
+	FrameBuffer* Acquire(const FrameBufferSpec& spec);
+	void Release(FrameBuffer* target);
+
+	int GetViewportWidth() const { return viewportWidth; }
+	int GetViewportHeight() const { return viewportHeight; }
+	bool IsResizePending() const { return pendingWidth != viewportWidth || pendingHeight != viewportHeight; }
+	size_t GetNumTargets() const;
+	size_t GetNumBytes() const; // GPU memory taken by the attachments of all targets
+
+	static inline int resizeDelayFrames = 8;
+	static inline int maxUnusedFrames = 120;
+private:
+	struct Target {
+		std::unique_ptr<FrameBuffer> fbo;
+		bool isHeld = false;
+		int lastUsedFrame = 0;
+	};
+	// spec with the viewport size times its scale if it has no size
+	FrameBufferSpec Resolve(const FrameBufferSpec& spec) const;
+	static std::string GetBucketKey(const FrameBufferSpec& resolvedSpec);
+	Target* Find(FrameBuffer* fbo);
+	FrameBuffer* Take(const FrameBufferSpec& resolvedSpec);
+
+	std::unordered_map<std::string, std::vector<Target>> buckets;
+	std::unordered_map<std::string, FrameBuffer*> namedTargets;
+	bool hasViewportSize = false;
+	int viewportWidth = 1;
+	int viewportHeight = 1;
+	int pendingWidth = 1;
+	int pendingHeight = 1;
+	int numStableFrames = 0; // since pendingWidth and pendingHeight last changed
+	int frame = 0;
+};
\ No newline at end of file
@@ -1,50 +1,132 @@
 #include "Renderer.h"
 
 #include "Core/Math.h"
+#include "Renderer/GeometryPool.h"
 #include "Renderer/GraphicsAPI.h"
 #include "Renderer/Shader.h"
+#include "Modeling/Meshlets.h"
+#include "Scene/MeshAssetRegistry.h"
 
-void Renderer::RenderMesh(Shader* shader, const ViewData& viewData, const TransformComponent& transform, const MeshComponent& mesh, const MeshRendererComponent& meshRenderer) {
-	Renderer::RenderVertexArray(shader, viewData, transform, mesh.vao, meshRenderer);
-}
-
-void Renderer::RenderProceduralMesh(Shader* shader, const ViewData& viewData, const TransformComponent& transform, const ProceduralMeshComponent& pMesh, const MeshRendererComponent& meshRenderer) {
-	Renderer::RenderVertexArray(shader, viewData, transform, pMesh.vao, meshRenderer);
-}
-
-void Renderer::RenderVertexArray(Shader* shader, const ViewData& viewData, const TransformComponent& transform, VertexArray* vao, const MeshRendererComponent& meshRenderer) {
-	const glm::vec3& translation = transform.translation;
-	const glm::mat4 model = Math::ComposeTransform(transform.translation, transform.rotation, transform.scale);
-	const glm::mat4 modelView = viewData.view * model;
-	const glm::mat4 modelViewProjection = viewData.projection * modelView;
-	const glm::mat4 normalMatrix = glm::transpose(glm::inverse(modelView));
-	shader->UploadUniformMat4("u_Model", model);
-	shader->UploadUniformMat4("u_ModelView", modelView);
-	shader->UploadUniformMat4("u_ModelViewPerspective", modelViewProjection);
-	shader->UploadUniformMat4("u_NormalMatrix", normalMatrix);
-
-	shader->UploadUniformInt("u_RenderType", (int)meshRenderer.visualization);
-	shader->UploadUniformFloat4("u_SolidColor", meshRenderer.solidColor);
-	shader->UploadUniformFloat3("u_Material.ambient", meshRenderer.material.ambientColor);
-	shader->UploadUniformFloat3("u_Material.diffuse", meshRenderer.material.diffuseColor);
-	shader->UploadUniformFloat3("u_Material.specular", meshRenderer.material.specularColor);
-	shader->UploadUniformFloat("u_Material.shininess", meshRenderer.material.shininess);
-	shader->UploadUniformFloat("u_Material.alpha", meshRenderer.material.alpha);
-	shader->UploadUniformFloat("u_DepthMax", meshRenderer.depthParams.max);
-	shader->UploadUniformFloat("u_DepthPow", meshRenderer.depthParams.pow);
-
-	if (vao == nullptr) { return; }
-	GraphicsAPI::Get()->DrawArrayTriangles(*vao);
-}
-
-void Renderer::RenderVertexArrayEntityID(entt::entity ent, Shader* shader, const ViewData& viewData, const TransformComponent& transform, VertexArray* vao, const MeshRendererComponent& meshRenderer) {
-	const glm::vec3& translation = transform.translation;
-	const glm::mat4 model = Math::ComposeTransform(transform.translation, transform.rotation, transform.scale);
-	const glm::mat4 modelView = viewData.view * model;
-	const glm::mat4 modelViewProjection = viewData.projection * modelView;
-	const glm::mat4 normalMatrix = glm::inverse(modelView);
-	shader->UploadUniformMat4("u_ModelViewPerspective", modelViewProjection);
-	shader->UploadUniformInt("u_EntityID", (int)ent);
-	if (vao == nullptr) { return; }
-	GraphicsAPI::Get()->DrawArrayTriangles(*vao);
+#include <algorithm>
+#include <array>
+#include <iterator>
+
+static constexpr UniformHandle uFirstDraw = "u_FirstDraw"_uniform;
+
+// Range of the index buffer of given LOD, or the whole index buffer if the mesh has no LODs
+static void GetLodRange(const MeshAsset* asset, int lod, uint32_t& first, uint32_t& count) {
+	first = 0;
+	count = (uint32_t)asset->ebo->GetNumIndices();
+	if (!asset->lods.empty()) {
+		const MeshLod& meshLod = asset->lods[std::clamp(lod, 0, (int)asset->lods.size() - 1)];
+		first = meshLod.indexOffset;
+		count = meshLod.indexCount;
+	}
+}
+
+static void DrawRange(const MeshAsset* asset, uint32_t count, uint32_t first, uint32_t slot) {
+	GraphicsAPI::Get()->DrawIndexedTriangles(*asset->vao, count, first, slot);
+	Renderer::stats.numDrawCalls++;
 }
+
+// Draws given LOD of the mesh, or the whole index buffer if the mesh has no LODs. slot becomes gl_BaseInstance, which the instance buffer maps to itself.
+// Meshlets outside the frustum or facing away from the camera are skipped, and runs of visible ones are drawn together.
+static void DrawLod(const MeshAsset* asset, int lod, uint32_t slot, const EntityData& entityData, const glm::mat4& modelViewProjection, const glm::vec3& cameraPosition) {
+	uint32_t first = 0;
+	uint32_t count = 0;
+	GetLodRange(asset, lod, first, count);
+	if (!Renderer::isMeshletCullingEnabled || asset->meshlets.empty()) {
+		DrawRange(asset, count, first, slot);
+		return;
+	}
+
+	const std::array<glm::vec4, 6> planes = Math::ExtractFrustumPlanes(modelViewProjection);
+	const glm::mat4& model = entityData.model;
+	// The inverse of the upper 3x3 of model is the transpose of the normal matrix's, so no matrix is inverted here
+	const glm::vec3 cameraPositionModel = glm::transpose(glm::mat3(entityData.normalMatrix)) * (cameraPosition - glm::vec3(model[3]));
+	// A mirroring transform flips the winding, and the GPU then culls the other side than the normal cones assume
+	const bool canCullBackfaces = Renderer::areBackFacesCulled && glm::determinant(glm::mat3(model)) > 0.0f;
+	auto begin = std::lower_bound(asset->meshlets.begin(), asset->meshlets.end(), first, [](const Meshlet& meshlet, uint32_t offset) { return meshlet.indexOffset < offset; });
+	uint32_t runFirst = first;
+	uint32_t runCount = 0;
+	for (auto meshlet = begin; meshlet != asset->meshlets.end() && meshlet->indexOffset < first + count; ++meshlet) {
+		const bool isVisible = !Math::IsSphereOutsideFrustum(planes, meshlet->bounds.center, meshlet->bounds.radius)
+			&& !(canCullBackfaces && IsMeshletBackfacing(*meshlet, cameraPositionModel));
+		if (isVisible) {
+			if (runCount == 0) { runFirst = meshlet->indexOffset; }
+			runCount += meshlet->indexCount;
+			Renderer::stats.numMeshletsDrawn++;
+			continue;
+		}
+		Renderer::stats.numMeshletsCulled++;
+		if (runCount > 0) {
+			DrawRange(asset, runCount, runFirst, slot);
+			runCount = 0;
+		}
+	}
+	if (runCount > 0) { DrawRange(asset, runCount, runFirst, slot); }
+}
+
+int Renderer::SelectLod(const ViewData& viewData, const glm::mat4& model, const MeshAsset* asset, int previousLod) {
+	if (!isLodEnabled || asset == nullptr || asset->lods.size() < 2) { return 0; }
+	const glm::vec3 centerView = glm::vec3(viewData.view * model * glm::vec4(asset->bounds.center, 1.0f));
+	const float maxScale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+	const float radius = asset->bounds.radius * maxScale;
+	const float distance = glm::length(centerView);
+	if (distance <= radius) { return 0; } // camera is inside the sphere
+	// projection[1][1] is cot(fovy / 2), which maps view space heights at unit distance to NDC, where viewport height is 2
+	const float screenSize = radius * viewData.projection[1][1] / distance;
+
+	const int numLods = (int)asset->lods.size();
+	const int maxLod = std::min(numLods - 1, (int)std::size(lodScreenSizes));
+	int lod = 0;
+	while (lod < maxLod && screenSize < lodScreenSizes[lod]) { lod++; }
+	previousLod = std::clamp(previousLod, 0, maxLod);
+	// Move towards a coarser LOD only after going clearly below its threshold, and towards a finer one only after going clearly above
+	while (lod > previousLod && screenSize > lodScreenSizes[lod - 1] * (1.0f - lodHysteresis)) { lod--; }
+	while (lod < previousLod && screenSize < lodScreenSizes[lod] * (1.0f + lodHysteresis)) { lod++; }
+	return lod;
+}
+
+void Renderer::RenderMesh(Shader* shader, const ViewData& viewData, const SceneBuffer& sceneBuffer, entt::entity ent, const MeshComponent& mesh) {
+	const uint32_t slot = sceneBuffer.GetSlot(ent);
+	if (slot == SceneBuffer::invalidSlot) { return; }
+	mesh.lod = SelectLod(viewData, sceneBuffer.GetEntityData(slot).model, mesh.asset.get(), mesh.lod);
+	Renderer::RenderMeshAsset(shader, viewData, sceneBuffer, ent, mesh.asset.get(), mesh.lod);
+}
+
+void Renderer::RenderProceduralMesh(Shader* shader, const ViewData& viewData, const SceneBuffer& sceneBuffer, entt::entity ent, const ProceduralMeshComponent& pMesh) {
+	Renderer::RenderMeshAsset(shader, viewData, sceneBuffer, ent, pMesh.asset.get());
+}
+
+void Renderer::RenderMeshAsset(Shader* shader, const ViewData& viewData, const SceneBuffer& sceneBuffer, entt::entity ent, const MeshAsset* asset, int lod) {
+	const uint32_t slot = sceneBuffer.GetSlot(ent);
+	if (asset == nullptr || slot == SceneBuffer::invalidSlot) { return; }
+	// Meshes that are still loading are drawn as a box of their bounds, see SceneBuffer
+	if (!asset->isReady) { asset = MeshAssetRegistry::GetPlaceholder(); }
+	asset->decoding.UploadUniforms(shader);
+	shader->UploadUniformInt(uFirstDraw, -1); // a multi-draw of RenderQueue may have set it on the same shader
+	DrawMeshAsset(viewData, sceneBuffer, slot, asset, lod);
+}
+
+void Renderer::DrawMeshAsset(const ViewData& viewData, const SceneBuffer& sceneBuffer, uint32_t slot, const MeshAsset* asset, int lod) {
+	const EntityData& entityData = sceneBuffer.GetEntityData(slot);
+	const glm::mat4 modelViewProjection = viewData.projection * viewData.view * entityData.model;
+	DrawLod(asset, lod, slot, entityData, modelViewProjection, glm::vec3(viewData.viewPosition));
+}
+
+void Renderer::DrawMeshAssetInstanced(const MeshAsset* asset, int lod, uint32_t instanceCount, uint32_t baseInstance) {
+	uint32_t first = 0;
+	uint32_t count = 0;
+	GetLodRange(asset, lod, first, count);
+	GraphicsAPI::Get()->DrawIndexedTrianglesInstanced(*asset->vao, instanceCount, count, first, baseInstance);
+	stats.numDrawCalls++;
+	stats.numInstancedDraws++;
+}
+
+void Renderer::MultiDrawIndirect(const GeometryPool& pool, const StorageBuffer& draws, uint32_t firstDraw, uint32_t numDraws) {
+	GraphicsAPI::Get()->MultiDrawIndexedTrianglesIndirect(pool, draws, firstDraw, numDraws, sizeof(IndirectDraw));
+	stats.numDrawCalls++;
+	stats.numMultiDraws++;
+	stats.numIndirectDraws += numDraws;
+}
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "Scene/Components.h"
 #include "Renderer/Shader.h"
+#include "Renderer/SceneBuffer.h"
+#include "Renderer/StorageBuffer.h"
 
 #include <glm/glm.hpp>
 #include <entt/entt.hpp>
@@ -12,8 +14,6 @@ struct ViewData {
 	glm::vec4 viewPosition;
 };
 
-#define MAX_LIGHTS 10
-
 struct PointLight {
 	glm::vec4 attenuation; // vec3
 	glm::vec4 position; // vec3
@@ -31,18 +31,64 @@ struct Light {
 	float _pad4;
 };
 
-struct Lights {
-	Light lights[MAX_LIGHTS];
+// Start of the Lights storage block, which the lights follow, see LightClusters
+struct LightsHeader {
 	glm::vec4 ambientLight = { 0.0f, 0.0f, 0.0f, 1.0f };
-	int numLights;
+	glm::ivec4 clusterGrid = glm::ivec4(0); // tiles across, tiles up, depth slices, and the number of global lights
+	glm::vec4 clusterParams = glm::vec4(0.0f); // near distance, slices / log(far / near), viewport width and height
 };
 
+// Counters of a frame
+struct RenderStats {
+	int numMeshletsDrawn = 0;
+	int numMeshletsCulled = 0;
+	int numEntitiesUploaded = 0; // to the scene buffer
+	int numDrawPackets = 0;
+	int numStateChanges = 0; // shader, mesh or stencil mask changes between draw packets
+	int numDrawCalls = 0;
+	int numInstancedDraws = 0; // of numDrawCalls
+	int numMultiDraws = 0; // of numDrawCalls
+	int numIndirectDraws = 0; // commands of the multi-draws
+	int numEntitiesCulled = 0; // by the frustum
+	int numCullingReuses = 0; // of the visibility of the previous frame
+	int numOcclusionTested = 0; // entities in the frustum tested against the depth pyramid
+	int numOcclusionCulled = 0; // of numOcclusionTested
+	int numOcclusionRetested = 0; // of numOcclusionCulled, with occlusion queries against the depth of the frame
+	int numGlobalLights = 0; // lighting every fragment
+	int numClusteredLights = 0; // point lights of the view, in the clusters they reach
+	int numLightIndices = 0; // in the light lists of all clusters
+};
 
 class Renderer {
 public:
-	static void RenderMesh(Shader* shader, const ViewData& viewData, const TransformComponent& transform, const MeshComponent& mesh, const MeshRendererComponent& meshRenderer);
-	static void RenderProceduralMesh(Shader* shader, const ViewData& viewData, const TransformComponent& transform, const ProceduralMeshComponent& mesh, const MeshRendererComponent& meshRenderer);
-	static void RenderVertexArray(Shader* shader, const ViewData& viewData, const TransformComponent& transform, VertexArray* vao, const MeshRendererComponent& meshRenderer);
+	// Projected sphere diameter, as a fraction of the viewport height, under which LOD i + 1 is used instead of LOD i
+	static inline float lodScreenSizes[] = { 0.25f, 0.125f, 0.0625f, };
+	// How far past a threshold the size has to go before switching LODs, as a fraction of the threshold
+	static inline float lodHysteresis = 0.1f;
+	static inline bool isLodEnabled = true;
+	static inline bool isFrustumCullingEnabled = true; // of whole entities, see FrustumCuller
+	static inline bool isOcclusionCullingEnabled = false; // of whole entities behind the depth of earlier frames, see OcclusionCuller
+	static inline bool isMeshletCullingEnabled = true;
+	// Draw packets of the same mesh, LOD, shader and stencil mask are drawn with one instanced draw call, without meshlet culling
+	static inline bool isInstancingEnabled = true;
+	static inline int minInstances = 2;
+	// Meshes are copied into geometry pools, and packets of the same pool, shader and stencil mask are drawn with one multi-draw-indirect call, without meshlet culling.
+	static inline bool isMultiDrawIndirectEnabled = false;
+	// Meshlets facing away are skipped only when the GPU would cull their triangles anyway. Keep in sync with GraphicsAbility::FaceCulling and CullFace.
+	static inline bool areBackFacesCulled = true;
+	static inline RenderStats stats; // reset by the caller each frame
+
+	// Chooses the LOD of a mesh by the projected size of its bounding sphere. Stays at previousLod while the size is within the hysteresis band.
+	static int SelectLod(const ViewData& viewData, const glm::mat4& model, const MeshAsset* asset, int previousLod);
 
-	static void RenderVertexArrayEntityID(entt::entity ent, Shader* shader, const ViewData& viewData, const TransformComponent& transform, VertexArray* vao, const MeshRendererComponent& meshRenderer);
+	// Draw an entity whose transform and material are in sceneBuffer. Nothing is drawn for entities without data there.
+	static void RenderMesh(Shader* shader, const ViewData& viewData, const SceneBuffer& sceneBuffer, entt::entity ent, const MeshComponent& mesh);
+	static void RenderProceduralMesh(Shader* shader, const ViewData& viewData, const SceneBuffer& sceneBuffer, entt::entity ent, const ProceduralMeshComponent& mesh);
+	static void RenderMeshAsset(Shader* shader, const ViewData& viewData, const SceneBuffer& sceneBuffer, entt::entity ent, const MeshAsset* asset, int lod = 0);
+	// Draws a ready asset for the entity in given slot of sceneBuffer. Expects the shader bound, with the vertex decoding uniforms of the asset.
+	static void DrawMeshAsset(const ViewData& viewData, const SceneBuffer& sceneBuffer, uint32_t slot, const MeshAsset* asset, int lod);
+	// Draws the whole LOD of a ready asset once per instance, for the slots staged with SceneBuffer::StageInstances
+	static void DrawMeshAssetInstanced(const MeshAsset* asset, int lod, uint32_t instanceCount, uint32_t baseInstance);
+	// Draws numDraws IndirectDraws of draws from firstDraw on. Expects the shader bound, with u_FirstDraw set to firstDraw.
+	static void MultiDrawIndirect(const GeometryPool& pool, const StorageBuffer& draws, uint32_t firstDraw, uint32_t numDraws);
 };
\ No newline at end of file
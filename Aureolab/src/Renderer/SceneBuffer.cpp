@@ -0,0 +1,249 @@
+#include "SceneBuffer.h"
+
+#include "Renderer/Renderer.h"
+#include "Scene/Components.h"
+#include "Scene/MeshAssetRegistry.h"
+#include "Scene/TransformCache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+static_assert(sizeof(EntityData) % 16 == 0, "std430 arrays of structs with vec4 members have a stride of a multiple of 16 bytes");
+
+static constexpr uint32_t initialCapacity = 64; // entities
+
+static const MeshAsset* FindMeshAsset(const entt::registry& registry, entt::entity ent) {
+	if (const auto* mesh = registry.try_get<MeshComponent>(ent)) { return mesh->asset.get(); }
+	if (const auto* pMesh = registry.try_get<ProceduralMeshComponent>(ent)) { return pMesh->asset.get(); }
+	return nullptr;
+}
+
+void SlotBounds::Resize(uint32_t numSlots) {
+	const uint32_t oldSize = GetNumSlots();
+	const uint32_t newSize = (numSlots + numSimdLanes - 1) / numSimdLanes * numSimdLanes;
+	for (std::vector<float>* values : { &boxX, &boxY, &boxZ, &extentX, &extentY, &extentZ, &sphereX, &sphereY, &sphereZ, &radius }) { values->resize(newSize, 0.0f); }
+	for (uint32_t slot = oldSize; slot < newSize; slot++) { SetEmpty(slot); }
+}
+
+void SlotBounds::Set(uint32_t slot, const MeshAsset& asset, const glm::mat4& model) {
+	const glm::vec3 center = glm::vec3(model * glm::vec4((asset.box.min + asset.box.max) * 0.5f, 1.0f));
+	const glm::vec3 halfSize = (asset.box.max - asset.box.min) * 0.5f;
+	// Box of the transformed box, each axis gets the absolute contributions of all three local axes
+	glm::vec3 extent;
+	for (int axis = 0; axis < 3; axis++) {
+		extent[axis] = std::abs(model[0][axis]) * halfSize.x + std::abs(model[1][axis]) * halfSize.y + std::abs(model[2][axis]) * halfSize.z;
+	}
+	const glm::vec3 sphereCenter = glm::vec3(model * glm::vec4(asset.bounds.center, 1.0f));
+	const float maxScale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+	boxX[slot] = center.x;
+	boxY[slot] = center.y;
+	boxZ[slot] = center.z;
+	extentX[slot] = extent.x;
+	extentY[slot] = extent.y;
+	extentZ[slot] = extent.z;
+	sphereX[slot] = sphereCenter.x;
+	sphereY[slot] = sphereCenter.y;
+	sphereZ[slot] = sphereCenter.z;
+	radius[slot] = asset.bounds.radius * maxScale;
+}
+
+void SlotBounds::SetEmpty(uint32_t slot) {
+	boxX[slot] = boxY[slot] = boxZ[slot] = 0.0f;
+	extentX[slot] = extentY[slot] = extentZ[slot] = 0.0f;
+	sphereX[slot] = sphereY[slot] = sphereZ[slot] = 0.0f;
+	radius[slot] = std::numeric_limits<float>::lowest();
+}
+
+SceneBuffer::SceneBuffer(entt::registry& registry)
+	: registry(registry) {
+	registry.on_construct<TransformComponent>().connect<&SceneBuffer::OnChanged>(this);
+	registry.on_update<TransformComponent>().connect<&SceneBuffer::OnChanged>(this);
+	registry.on_destroy<TransformComponent>().connect<&SceneBuffer::OnDestroyed>(this);
+	registry.on_construct<MeshRendererComponent>().connect<&SceneBuffer::OnChanged>(this);
+	registry.on_update<MeshRendererComponent>().connect<&SceneBuffer::OnChanged>(this);
+	registry.on_destroy<MeshRendererComponent>().connect<&SceneBuffer::OnDestroyed>(this);
+	// A new mesh may be a placeholder until it is loaded, which changes the model matrix
+	registry.on_construct<MeshComponent>().connect<&SceneBuffer::OnChanged>(this);
+	registry.on_update<MeshComponent>().connect<&SceneBuffer::OnChanged>(this);
+	registry.on_destroy<MeshComponent>().connect<&SceneBuffer::OnChanged>(this);
+	registry.on_construct<ProceduralMeshComponent>().connect<&SceneBuffer::OnChanged>(this);
+	registry.on_update<ProceduralMeshComponent>().connect<&SceneBuffer::OnChanged>(this);
+	registry.on_destroy<ProceduralMeshComponent>().connect<&SceneBuffer::OnChanged>(this);
+}
+
+SceneBuffer::~SceneBuffer() {
+	registry.on_construct<TransformComponent>().disconnect(this);
+	registry.on_update<TransformComponent>().disconnect(this);
+	registry.on_destroy<TransformComponent>().disconnect(this);
+	registry.on_construct<MeshRendererComponent>().disconnect(this);
+	registry.on_update<MeshRendererComponent>().disconnect(this);
+	registry.on_destroy<MeshRendererComponent>().disconnect(this);
+	registry.on_construct<MeshComponent>().disconnect(this);
+	registry.on_update<MeshComponent>().disconnect(this);
+	registry.on_destroy<MeshComponent>().disconnect(this);
+	registry.on_construct<ProceduralMeshComponent>().disconnect(this);
+	registry.on_update<ProceduralMeshComponent>().disconnect(this);
+	registry.on_destroy<ProceduralMeshComponent>().disconnect(this);
+	delete storage;
+	delete instances;
+}
+
+void SceneBuffer::Update() {
+	ResetInstances();
+	if (dirtySlots.empty()) { return; }
+	StorageBuffer* buffer = GetStorage();
+	buffer->Reserve((unsigned int)(entities.size() * sizeof(EntityData)));
+	bounds.Resize((uint32_t)entities.size());
+	slotMeshes.resize(entities.size(), nullptr);
+	version++;
+
+	// Upload runs of consecutive slots with one copy each
+	std::sort(dirtySlots.begin(), dirtySlots.end());
+	std::vector<uint32_t> notFinal;
+	size_t runBegin = 0;
+	while (runBegin < dirtySlots.size()) {
+		size_t runEnd = runBegin + 1;
+		while (runEnd < dirtySlots.size() && dirtySlots[runEnd] == dirtySlots[runEnd - 1] + 1) { runEnd++; }
+		const uint32_t firstSlot = dirtySlots[runBegin];
+		const uint32_t numSlots = (uint32_t)(runEnd - runBegin);
+		EntityData* staged = (EntityData*)buffer->Stage(firstSlot * sizeof(EntityData), numSlots * sizeof(EntityData));
+		for (uint32_t slot = firstSlot; slot < firstSlot + numSlots; slot++) {
+			isDirty[slot] = false;
+			const entt::entity ent = slotEntities[slot];
+			const MeshAsset* asset = ent == entt::null ? nullptr : FindMeshAsset(registry, ent);
+			if (ent != entt::null) { // else freed after being marked
+				bool isFinal = true;
+				entities[slot] = ComputeEntityData(ent, isFinal);
+				if (!isFinal) { notFinal.push_back(slot); }
+			}
+			// Meshes that are not ready are drawn as the placeholder, which the model matrix maps onto their bounds
+			slotMeshes[slot] = asset == nullptr || asset->isReady ? asset : MeshAssetRegistry::GetPlaceholder();
+			if (asset == nullptr) { bounds.SetEmpty(slot); }
+			else { bounds.Set(slot, *slotMeshes[slot], entities[slot].model); }
+			staged[slot - firstSlot] = entities[slot];
+		}
+		Renderer::stats.numEntitiesUploaded += numSlots;
+		runBegin = runEnd;
+	}
+	dirtySlots.clear();
+	for (uint32_t slot : notFinal) { MarkDirty(slot); }
+	buffer->Flush();
+}
+
+void SceneBuffer::BlockBind(Shader* shader) {
+	GetStorage()->BlockBind(shader);
+	GetInstances()->BlockBind(shader);
+}
+
+void SceneBuffer::BlockBindEntities(Shader* shader) {
+	GetStorage()->BlockBind(shader);
+}
+
+uint32_t* SceneBuffer::StageInstances(uint32_t count, uint32_t& baseInstance) {
+	assert(count > 0);
+	StorageBuffer* buffer = GetInstances();
+	buffer->Reserve((instanceHead + count) * sizeof(uint32_t));
+	baseInstance = instanceHead;
+	instanceHead += count;
+	return (uint32_t*)buffer->Stage(baseInstance * sizeof(uint32_t), count * sizeof(uint32_t));
+}
+
+void SceneBuffer::FlushInstances() {
+	GetInstances()->Flush();
+}
+
+uint32_t SceneBuffer::GetSlot(entt::entity ent) const {
+	auto it = slots.find(ent);
+	return it == slots.end() ? invalidSlot : it->second;
+}
+
+void SceneBuffer::OnChanged(entt::registry& registry, entt::entity ent) {
+	if (!registry.all_of<TransformComponent, MeshRendererComponent>(ent)) { return; }
+	auto [it, isNew] = slots.try_emplace(ent, invalidSlot);
+	if (isNew) {
+		if (freeSlots.empty()) {
+			it->second = (uint32_t)entities.size();
+			entities.emplace_back();
+			slotEntities.push_back(ent);
+			isDirty.push_back(false);
+		}
+		else {
+			it->second = freeSlots.back();
+			freeSlots.pop_back();
+			slotEntities[it->second] = ent;
+		}
+	}
+	MarkDirty(it->second);
+}
+
+void SceneBuffer::OnDestroyed(entt::registry& registry, entt::entity ent) {
+	auto it = slots.find(ent);
+	if (it == slots.end()) { return; }
+	slotEntities[it->second] = entt::null;
+	freeSlots.push_back(it->second);
+	MarkDirty(it->second); // so that Update clears its bounds
+	slots.erase(it);
+}
+
+void SceneBuffer::MarkDirty(uint32_t slot) {
+	if (isDirty[slot]) { return; }
+	isDirty[slot] = true;
+	dirtySlots.push_back(slot);
+}
+
+EntityData SceneBuffer::ComputeEntityData(entt::entity ent, bool& isFinal) const {
+	const auto* cached = registry.try_get<WorldTransformComponent>(ent);
+	const WorldTransformComponent world = cached != nullptr ? *cached : TransformCache::Compute(registry.get<TransformComponent>(ent));
+	const auto& meshRenderer = registry.get<MeshRendererComponent>(ent);
+
+	glm::mat4 model = world.world;
+	glm::mat4 normalMatrix = glm::mat4(world.normal);
+	const MeshAsset* asset = FindMeshAsset(registry, ent);
+	isFinal = asset == nullptr || asset->isReady;
+	if (!isFinal) {
+		model = model * MeshAssetRegistry::GetPlaceholderTransform(asset);
+		normalMatrix = glm::transpose(glm::inverse(model));
+	}
+
+	const MeshRendererComponent::Material& material = meshRenderer.material;
+	EntityData data;
+	data.model = model;
+	data.normalMatrix = normalMatrix;
+	data.solidColor = meshRenderer.solidColor;
+	data.ambientColor = glm::vec4(material.ambientColor, 0.0f);
+	data.diffuseColor = glm::vec4(material.diffuseColor, 0.0f);
+	data.specularColor = glm::vec4(material.specularColor, 0.0f);
+	data.shininess = material.shininess;
+	data.alpha = material.alpha;
+	data.depthMax = meshRenderer.depthParams.max;
+	data.depthPow = meshRenderer.depthParams.pow;
+	data.visualization = (int)meshRenderer.visualization;
+	data.entityID = (int)ent;
+	data._pad1 = 0;
+	data._pad2 = 0;
+	return data;
+}
+
+void SceneBuffer::ResetInstances() {
+	const uint32_t numSlots = (uint32_t)entities.size();
+	if (numSlots > numIdentityInstances) {
+		StorageBuffer* buffer = GetInstances();
+		buffer->Reserve(numSlots * sizeof(uint32_t));
+		uint32_t* staged = (uint32_t*)buffer->Stage(numIdentityInstances * sizeof(uint32_t), (numSlots - numIdentityInstances) * sizeof(uint32_t));
+		for (uint32_t slot = numIdentityInstances; slot < numSlots; slot++) { staged[slot - numIdentityInstances] = slot; }
+		numIdentityInstances = numSlots; // flushed with the instances of the frame
+	}
+	instanceHead = numIdentityInstances;
+}
+
+StorageBuffer* SceneBuffer::GetStorage() {
+	if (storage == nullptr) { storage = StorageBuffer::Create("Entities", initialCapacity * sizeof(EntityData)); }
+	return storage;
+}
+
+StorageBuffer* SceneBuffer::GetInstances() {
+	if (instances == nullptr) { instances = StorageBuffer::Create("Instances", initialCapacity * 4 * sizeof(uint32_t)); }
+	return instances;
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Renderer/MeshAsset.h"
+#include "Renderer/Shader.h"
+#include "Renderer/StorageBuffer.h"
+
+#include <entt/entt.hpp>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Data of an entity that shaders read from the scene buffer at the slot of the instance, see StageInstances. Layout matches EntityData in the shaders (std430).
+struct EntityData {
+	glm::mat4 model;
+	glm::mat4 normalMatrix; // transpose of inverse of model
+	glm::vec4 solidColor;
+	glm::vec4 ambientColor; // vec3
+	glm::vec4 diffuseColor; // vec3
+	glm::vec4 specularColor; // vec3
+	float shininess;
+	float alpha;
+	float depthMax;
+	float depthPow;
+	int visualization;
+	int entityID;
+	int _pad1;
+	int _pad2;
+};
+
+// World space bounds of the meshes of all slots, as a structure of arrays for culling several slots at once. Padded to a multiple of numSimdLanes slots.
+// Slots without a mesh have a radius of lowest float, which no frustum test passes.
+struct SlotBounds {
+	static constexpr uint32_t numSimdLanes = 4;
+
+	std::vector<float> boxX, boxY, boxZ; // center of the bounding box
+	std::vector<float> extentX, extentY, extentZ; // half size of the bounding box
+	std::vector<float> sphereX, sphereY, sphereZ, radius;
+
+	void Resize(uint32_t numSlots);
+	void Set(uint32_t slot, const MeshAsset& asset, const glm::mat4& model);
+	void SetEmpty(uint32_t slot);
+	uint32_t GetNumSlots() const { return (uint32_t)radius.size(); }
+};
+
+/*
+* GPU resident EntityData of all entities with a TransformComponent and a MeshRendererComponent.
+* Follows component changes through registry signals, and each Update uploads only the entities changed since the previous one.
+* Components modified in place have to be marked as changed, e.g. with registry.patch<TransformComponent>(ent).
+* Matrices come from WorldTransformComponent, so update the TransformCache of the registry first.
+* Shaders find the slot of an instance in a second buffer at gl_BaseInstance + gl_InstanceID. Its first entries hold their own index,
+* so that a single draw can pass the slot as base instance, and the lists of slots of instanced draws follow.
+*/
+class SceneBuffer {
+public:
+	static constexpr uint32_t invalidSlot = UINT32_MAX;
+
+	SceneBuffer(entt::registry& registry);
+	SceneBuffer(const SceneBuffer&) = delete;
+	SceneBuffer& operator=(const SceneBuffer&) = delete;
+	~SceneBuffer();
+
+	// Uploads the data of changed entities. Call once per frame before rendering, on the thread of the graphics context.
+	void Update();
+	void BlockBind(Shader* shader);
+	// Only the Entities block, for shaders that read entities by slot without drawing instances
+	void BlockBindEntities(Shader* shader);
+
+	// Returns memory for the slots of count instances, which become visible to draws after FlushInstances. baseInstance is set to what to draw them with.
+	// Valid until the next Update, once per frame.
+	uint32_t* StageInstances(uint32_t count, uint32_t& baseInstance);
+	// Copies the slots staged since Update into the buffer. Call once per frame, after all instances of the frame are staged and before drawing entities.
+	// Each flush takes a segment of the staging ring, so flushing per pass would wait for the GPU to finish earlier passes of the same frame.
+	void FlushInstances();
+
+	// Index of the data of the entity in the buffer, invalidSlot if it has none
+	uint32_t GetSlot(entt::entity ent) const;
+	// CPU copy of the data in given slot, as of the last Update
+	const EntityData& GetEntityData(uint32_t slot) const { return entities[slot]; }
+	// Entity in given slot, entt::null for free slots
+	entt::entity GetEntity(uint32_t slot) const { return slotEntities[slot]; }
+	// Mesh drawn for given slot, the placeholder while it loads, nullptr if none. As of the last Update.
+	const MeshAsset* GetMeshAsset(uint32_t slot) const { return slotMeshes[slot]; }
+	// Bounds of the meshes of all slots, as of the last Update
+	const SlotBounds& GetBounds() const { return bounds; }
+	// Changes at each Update that changes the data of any slot
+	uint64_t GetVersion() const { return version; }
+
+private:
+	void OnChanged(entt::registry& registry, entt::entity ent);
+	void OnDestroyed(entt::registry& registry, entt::entity ent);
+	void MarkDirty(uint32_t slot);
+	// isFinal is false when the data has to be computed again next frame, e.g. while the mesh is still loading
+	EntityData ComputeEntityData(entt::entity ent, bool& isFinal) const;
+	StorageBuffer* GetStorage();
+	StorageBuffer* GetInstances();
+	// Extends the identity part of the instance buffer to all slots, and drops the instance lists of the previous frame
+	void ResetInstances();
+
+	entt::registry& registry;
+	StorageBuffer* storage = nullptr; // created on first use, when a graphics context is current
+	std::unordered_map<entt::entity, uint32_t> slots;
+	std::vector<entt::entity> slotEntities; // entt::null for free slots
+	std::vector<uint32_t> freeSlots;
+	std::vector<EntityData> entities; // by slot
+	std::vector<const MeshAsset*> slotMeshes; // by slot
+	std::vector<bool> isDirty; // by slot
+	std::vector<uint32_t> dirtySlots;
+	SlotBounds bounds;
+	uint64_t version = 0;
+	StorageBuffer* instances = nullptr;
+	uint32_t numIdentityInstances = 0;
+	uint32_t instanceHead = 0; // where the next instance list goes
+};
\ No newline at end of file
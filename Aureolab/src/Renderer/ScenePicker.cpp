@@ -0,0 +1,137 @@
+#include "ScenePicker.h"
+
+#include "Core/Math.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+static BoundingBox GetSlotBox(const SlotBounds& bounds, uint32_t slot) {
+	const glm::vec3 center = { bounds.boxX[slot], bounds.boxY[slot], bounds.boxZ[slot] };
+	const glm::vec3 extent = { bounds.extentX[slot], bounds.extentY[slot], bounds.extentZ[slot] };
+	return BoundingBox{ center - extent, center + extent };
+}
+
+// Sum of the surface areas of all nodes, which is proportional to the cost of tracing random rays through the BVH
+static float GetTotalArea(const std::vector<BvhNode>& nodes) {
+	float area = 0.0f;
+	for (const BvhNode& node : nodes) { area += SurfaceArea(node.min, node.max); }
+	return area;
+}
+
+void ScenePicker::Update(const SceneBuffer& sceneBuffer) {
+	if (&sceneBuffer == lastSceneBuffer && sceneBuffer.GetVersion() == lastVersion) { return; }
+	const SlotBounds& bounds = sceneBuffer.GetBounds();
+	bool isSameSlots = &sceneBuffer == lastSceneBuffer && bounds.GetNumSlots() == hasMesh.size();
+	for (uint32_t slot = 0; isSameSlots && slot < bounds.GetNumSlots(); slot++) {
+		isSameSlots = (bounds.radius[slot] >= 0.0f) == hasMesh[slot];
+	}
+	lastSceneBuffer = &sceneBuffer;
+	lastVersion = sceneBuffer.GetVersion();
+	if (!isSameSlots) {
+		Build(bounds);
+		return;
+	}
+
+	for (size_t item = 0; item < items.size(); item++) { boxes[item] = GetSlotBox(bounds, items[item]); }
+	RefitBvh(nodes, boxes, order);
+	if (GetTotalArea(nodes) > builtArea * maxRefitGrowth) { Build(bounds); }
+}
+
+void ScenePicker::Build(const SlotBounds& bounds) {
+	items.clear();
+	boxes.clear();
+	hasMesh.assign(bounds.GetNumSlots(), false);
+	for (uint32_t slot = 0; slot < bounds.GetNumSlots(); slot++) {
+		if (bounds.radius[slot] < 0.0f) { continue; }
+		hasMesh[slot] = true;
+		items.push_back(slot);
+		boxes.push_back(GetSlotBox(bounds, slot));
+	}
+	nodes = BuildBvh(boxes, order, 2);
+	builtArea = GetTotalArea(nodes);
+}
+
+uint32_t ScenePicker::PickRay(const SceneBuffer& sceneBuffer, const glm::vec3& origin, const glm::vec3& direction, float* distance) const {
+	uint32_t nearestSlot = SceneBuffer::invalidSlot;
+	float nearest = bvhNoHit;
+	const BvhRay ray(origin, direction);
+	if (nodes.empty() || IntersectRayBox(ray, nodes[0].min, nodes[0].max, nearest) == bvhNoHit) { return nearestSlot; }
+	uint32_t stack[maxBvhDepth + 1];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		const BvhNode& node = nodes[stack[--stackSize]];
+		if (node.IsLeaf()) {
+			for (uint32_t ix = node.first; ix < node.first + node.count; ix++) {
+				const uint32_t slot = items[order[ix]];
+				const MeshAsset* asset = sceneBuffer.GetMeshAsset(slot);
+				if (asset == nullptr || IntersectRayBox(ray, boxes[order[ix]].min, boxes[order[ix]].max, nearest) == bvhNoHit) { continue; }
+				// Into model space, where distances along the ray stay the same. The upper 3x3 of the normal matrix is the transposed inverse of the model's.
+				const EntityData& data = sceneBuffer.GetEntityData(slot);
+				const glm::mat3 inverseModel = glm::transpose(glm::mat3(data.normalMatrix));
+				const BvhRay modelRay(inverseModel * (origin - glm::vec3(data.model[3])), inverseModel * direction);
+				const float hit = asset->bvh.IsEmpty() ? IntersectRayBox(modelRay, asset->box.min, asset->box.max, nearest) : asset->bvh.Intersect(modelRay, nearest);
+				if (hit < nearest) {
+					nearest = hit;
+					nearestSlot = slot;
+				}
+			}
+			continue;
+		}
+		// Visit the nearer child first, so that the farther one is likely skipped once something is hit
+		float leftDistance = IntersectRayBox(ray, nodes[node.first].min, nodes[node.first].max, nearest);
+		float rightDistance = IntersectRayBox(ray, nodes[node.first + 1].min, nodes[node.first + 1].max, nearest);
+		uint32_t nearChild = node.first;
+		uint32_t farChild = node.first + 1;
+		if (rightDistance < leftDistance) {
+			std::swap(leftDistance, rightDistance);
+			std::swap(nearChild, farChild);
+		}
+		if (rightDistance != bvhNoHit) { stack[stackSize++] = farChild; }
+		if (leftDistance != bvhNoHit) { stack[stackSize++] = nearChild; }
+	}
+	if (distance != nullptr) { *distance = nearest; }
+	return nearestSlot;
+}
+
+const std::vector<uint32_t>& ScenePicker::PickRect(const glm::mat4& viewProjection, const glm::vec2& ndcMin, const glm::vec2& ndcMax) {
+	rectSlots.clear();
+	if (nodes.empty()) { return rectSlots; }
+	// Stretch the rectangle over the whole NDC square, so that the frustum of the product is the part of the view inside the rectangle
+	const glm::vec2 size = glm::max(ndcMax - ndcMin, glm::vec2(1e-6f));
+	glm::mat4 rectToNdc(1.0f);
+	rectToNdc[0][0] = 2.0f / size.x;
+	rectToNdc[1][1] = 2.0f / size.y;
+	rectToNdc[3][0] = -(ndcMin.x + ndcMax.x) / size.x;
+	rectToNdc[3][1] = -(ndcMin.y + ndcMax.y) / size.y;
+	const std::array<glm::vec4, 6> planes = Math::ExtractFrustumPlanes(rectToNdc * viewProjection);
+	// A box is outside when even its corner furthest along a plane normal is behind the plane
+	auto isOutside = [&planes](const glm::vec3& min, const glm::vec3& max) {
+		const glm::vec3 center = (min + max) * 0.5f;
+		const glm::vec3 extent = (max - min) * 0.5f;
+		for (const glm::vec4& plane : planes) {
+			const glm::vec3 normal = glm::vec3(plane);
+			if (glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), extent) < 0.0f) { return true; }
+		}
+		return false;
+	};
+
+	uint32_t stack[maxBvhDepth + 1];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		const BvhNode& node = nodes[stack[--stackSize]];
+		if (isOutside(node.min, node.max)) { continue; }
+		if (!node.IsLeaf()) {
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = node.first + 1;
+			continue;
+		}
+		for (uint32_t ix = node.first; ix < node.first + node.count; ix++) {
+			if (!isOutside(boxes[order[ix]].min, boxes[order[ix]].max)) { rectSlots.push_back(items[order[ix]]); }
+		}
+	}
+	std::sort(rectSlots.begin(), rectSlots.end());
+	return rectSlots;
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Renderer/SceneBuffer.h"
+#include "Modeling/Bvh.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/*
+* Finds entities under the mouse or inside a rectangle on the CPU, without rendering them. A BVH over the world space bounding boxes of the
+* slots of a SceneBuffer leads a ray to the entities it may hit, whose meshes' own TriangleBvhs find the exact hit in model space.
+* The BVH is refitted when entities move, and rebuilt when entities come or go, or when refitting has made it much looser than a new one.
+*/
+class ScenePicker {
+public:
+	// Brings the BVH up to date with the scene buffer. Call after SceneBuffer::Update.
+	void Update(const SceneBuffer& sceneBuffer);
+	// Slot of the nearest entity the world space ray hits, SceneBuffer::invalidSlot if none. distance receives where, in units of direction.
+	uint32_t PickRay(const SceneBuffer& sceneBuffer, const glm::vec3& origin, const glm::vec3& direction, float* distance = nullptr) const;
+	// Slots of the entities whose bounding boxes are at least partly inside the rectangle between ndcMin and ndcMax, in NDC of viewProjection
+	const std::vector<uint32_t>& PickRect(const glm::mat4& viewProjection, const glm::vec2& ndcMin, const glm::vec2& ndcMax);
+
+	// Refitting rebuilds once the root grows this many times larger in surface area than at the last build
+	static inline float maxRefitGrowth = 2.0f;
+private:
+	void Build(const SlotBounds& bounds);
+
+	std::vector<BvhNode> nodes;
+	std::vector<uint32_t> items; // slots with a mesh, which leaves refer to through order
+	std::vector<uint32_t> order;
+	std::vector<BoundingBox> boxes; // by item
+	std::vector<bool> hasMesh; // by slot, as of the last build
+	float builtArea = 0.0f;
+	std::vector<uint32_t> rectSlots;
+	// What the BVH was computed for
+	const SceneBuffer* lastSceneBuffer = nullptr;
+	uint64_t lastVersion = 0;
+};
\ No newline at end of file
@@ -2,13 +2,37 @@
 
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
+// Name of a uniform hashed at compile time when declared constexpr, e.g. constexpr UniformHandle model = "u_Model"_uniform;
+// Shaders find uniforms by the hash, so uploading through a handle involves no string operations.
+struct UniformHandle {
+	uint32_t hash = 0;
+	const char* name = nullptr; // for diagnostics
+
+	// 32-bit FNV-1a
+	static constexpr uint32_t Hash(std::string_view name) {
+		uint32_t hash = 2166136261u;
+		for (char c : name) {
+			hash ^= (uint8_t)c;
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+};
+
+constexpr UniformHandle operator""_uniform(const char* name, size_t length) {
+	return UniformHandle{ UniformHandle::Hash(std::string_view(name, length)), name };
+}
+
 class Shader {
 public:
 	static Shader* Create(const std::string& filepath);
 
+	// Rebuilds the program from its file. Uniform values are reset, uniform and storage block bindings are kept.
 	virtual void Recompile() = 0;
 
 	virtual void Bind() const = 0;
@@ -16,19 +40,43 @@ public:
 	virtual unsigned int GetRendererID() const = 0;
 
 	virtual unsigned int GetAttribLocation(const std::string& name) = 0;
+	// Connects the uniform block to the buffer bound at bindingPoint. Kept over recompilations.
+	virtual void BindUniformBlock(const std::string& blockName, unsigned int bindingPoint) = 0;
+	// Same for shader storage blocks
+	virtual void BindStorageBlock(const std::string& blockName, unsigned int bindingPoint) = 0;
+
+	// Uploads of values equal to the last ones uploaded to the same uniform are skipped. Unknown or inactive uniforms are ignored.
+	virtual void UploadUniformInt(UniformHandle handle, int value) = 0;
+	virtual void UploadUniformFloat(UniformHandle handle, float value) = 0;
+	virtual void UploadUniformFloat2(UniformHandle handle, const glm::vec2& values) = 0;
+	virtual void UploadUniformFloat3(UniformHandle handle, const glm::vec3& values) = 0;
+	virtual void UploadUniformFloat4(UniformHandle handle, const glm::vec4& values) = 0;
+
+	virtual void UploadUniformMat2(UniformHandle handle, const glm::mat2& matrix) = 0;
+	virtual void UploadUniformMat3(UniformHandle handle, const glm::mat3& matrix) = 0;
+	virtual void UploadUniformMat4(UniformHandle handle, const glm::mat4& matrix) = 0;
+
+	virtual void UploadUniformFloats(UniformHandle handle, const std::vector<float>& values) = 0;
+	virtual void UploadUniformFloat2s(UniformHandle handle, const std::vector<glm::vec2>& values) = 0;
+	virtual void UploadUniformFloat3s(UniformHandle handle, const std::vector<glm::vec3>& values) = 0;
+	virtual void UploadUniformFloat4s(UniformHandle handle, const std::vector<glm::vec4>& values) = 0;
+
+	// Same as above, hashing the name at each call
+	void UploadUniformInt(const std::string& name, int value) { UploadUniformInt(HandleOf(name), value); }
+	void UploadUniformFloat(const std::string& name, float value) { UploadUniformFloat(HandleOf(name), value); }
+	void UploadUniformFloat2(const std::string& name, const glm::vec2& values) { UploadUniformFloat2(HandleOf(name), values); }
+	void UploadUniformFloat3(const std::string& name, const glm::vec3& values) { UploadUniformFloat3(HandleOf(name), values); }
+	void UploadUniformFloat4(const std::string& name, const glm::vec4& values) { UploadUniformFloat4(HandleOf(name), values); }
 
-	virtual void UploadUniformInt(const std::string& name, int value) = 0;
-	virtual void UploadUniformFloat(const std::string& name, float value) = 0;
-	virtual void UploadUniformFloat2(const std::string& name, const glm::vec2& values) = 0;
-	virtual void UploadUniformFloat3(const std::string& name, const glm::vec3& values) = 0;
-	virtual void UploadUniformFloat4(const std::string& name, const glm::vec4& values) = 0;
+	void UploadUniformMat2(const std::string& name, const glm::mat2& matrix) { UploadUniformMat2(HandleOf(name), matrix); }
+	void UploadUniformMat3(const std::string& name, const glm::mat3& matrix) { UploadUniformMat3(HandleOf(name), matrix); }
+	void UploadUniformMat4(const std::string& name, const glm::mat4& matrix) { UploadUniformMat4(HandleOf(name), matrix); }
 
-	virtual void UploadUniformMat2(const std::string& name, const glm::mat2& matrix) = 0;
-	virtual void UploadUniformMat3(const std::string& name, const glm::mat3& matrix) = 0;
-	virtual void UploadUniformMat4(const std::string& name, const glm::mat4& matrix) = 0;
+	void UploadUniformFloats(const std::string& name, const std::vector<float>& values) { UploadUniformFloats(HandleOf(name), values); }
+	void UploadUniformFloat2s(const std::string& name, const std::vector<glm::vec2>& values) { UploadUniformFloat2s(HandleOf(name), values); }
+	void UploadUniformFloat3s(const std::string& name, const std::vector<glm::vec3>& values) { UploadUniformFloat3s(HandleOf(name), values); }
+	void UploadUniformFloat4s(const std::string& name, const std::vector<glm::vec4>& values) { UploadUniformFloat4s(HandleOf(name), values); }
 
-	virtual void UploadUniformFloats(const std::string& name, const std::vector<float>& values) = 0;
-	virtual void UploadUniformFloat2s(const std::string& name, const std::vector<glm::vec2>& values) = 0;
-	virtual void UploadUniformFloat3s(const std::string& name, const std::vector<glm::vec3>& values) = 0;
-	virtual void UploadUniformFloat4s(const std::string& name, const std::vector<glm::vec4>& values) = 0;
+private:
+	static UniformHandle HandleOf(const std::string& name) { return UniformHandle{ UniformHandle::Hash(name), name.c_str() }; }
 };
\ No newline at end of file
@@ -0,0 +1,20 @@
+#include "StorageBuffer.h"
+
+#include "Core/GraphicsContext.h"
+#include "Platform/OpenGL/OpenGLStorageBuffer.h"
+
+#include <cassert>
+
+int StorageBuffer::bindingPointCounter = 0;
+
+StorageBuffer* StorageBuffer::Create(const std::string& name, unsigned int size) {
+	StorageBuffer* ssbo = nullptr;
+	switch (GraphicsContext::graphicsAPI) {
+	case GraphicsContext::API::OPENGL:
+		ssbo = new OpenGLStorageBuffer(name, size);
+		break;
+	default:
+		assert(false); // Only OpenGL is implemented.
+	}
+	return ssbo;
+}
\ No newline at end of file
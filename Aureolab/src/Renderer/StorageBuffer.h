@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Renderer/Shader.h"
+
+#include <string>
+
+// GPU buffer read by shaders as a shader storage block.
+// Writes are staged in memory the GPU is not reading and copied into the buffer on Flush, so they never stall on draws in flight.
+class StorageBuffer {
+public:
+	static StorageBuffer* Create(const std::string& name, unsigned int size);
+	virtual ~StorageBuffer() = default;
+
+	virtual void BlockBind(Shader* shader) = 0;
+	virtual unsigned int GetRendererID() const = 0;
+
+	// Grows the buffer to at least size bytes, keeping its contents
+	virtual void Reserve(unsigned int size) = 0;
+	virtual unsigned int GetSize() const = 0;
+
+	// Returns memory to write size bytes to, which end up at offset in the buffer at the next Flush
+	virtual void* Stage(unsigned int offset, unsigned int size) = 0;
+	// Copies the staged writes into the buffer. Call before the draws that should see them.
+	virtual void Flush() = 0;
+
+protected:
+	static int bindingPointCounter;
+};
\ No newline at end of file
@@ -16,7 +16,7 @@ public:
 	virtual unsigned int GetRendererID() const = 0;
 
 	virtual void AddVertexBuffer(VertexBuffer& vertexBuffer) = 0;
-	virtual void SetIndexBuffer(const IndexBuffer& indexBuffer) = 0;
+	virtual void SetIndexBuffer(IndexBuffer& indexBuffer) = 0;
 	virtual const std::vector<VertexBuffer*>& GetVertexBuffers() const = 0;
-	virtual const IndexBuffer* GetIndexBuffer() const = 0;
+	virtual IndexBuffer* GetIndexBuffer() const = 0;
 };
\ No newline at end of file
@@ -14,6 +14,9 @@ public:
 
 	template <typename TVertex>
 	void SetVertices(const std::vector<TVertex>& newVertices);
+	// Bulk copy from memory not owned by a vector, e.g. a memory mapped file.
+	template <typename TVertex>
+	void SetVertices(const TVertex* newVertices, size_t count);
 	template <typename TVertex>
 	void AppendVertices(const std::vector<TVertex>& newVertices);
 	template <typename TVertex>
@@ -31,6 +34,8 @@ public:
 	virtual void Bind() const = 0;
 	virtual void Unbind() const = 0;
 
+	virtual unsigned int GetRendererID() const = 0;
+
 protected:
 	// Concrete implementations should provide functionality to upload a void* into buffer.
 	virtual void UploadBuffer(size_t size, void* data) = 0;
@@ -70,6 +75,14 @@ void VertexBuffer::SetVertices(const std::vector<TVertex>& newVertices) {
 	numVertices = (unsigned int)newVertices.size();
 }
 
+template<typename TVertex>
+void VertexBuffer::SetVertices(const TVertex* newVertices, size_t count) {
+	auto verts = GetVertices<TVertex>();
+	verts->assign(newVertices, newVertices + count); // copy operation
+	UploadVertices<TVertex>();
+	numVertices = (unsigned int)count;
+}
+
 template<typename TVertex>
 void VertexBuffer::AppendVertex(const TVertex& vertex) {
 	GetVertices<TVertex>()->push_back(vertex);
@@ -14,6 +14,7 @@ enum class VertexAttributeType {
 	uint16,
 	int32,
 	uint32,
+	float16,
 	float32,
 	float64,
 };
@@ -1,23 +1,10 @@
 #include "Components.h"
 
-#include "Core/Log.h"
-#include "Renderer/VertexBuffer.h"
-#include "Modeling/Modeling.h"
-
-#include <array>
-
-VertexArray* VertexArrayFromOBJ(const std::string& filepath) {
-	std::vector<BasicVertex> vertices = LoadOBJ(filepath);
-	VertexBuffer* vbo = VertexBuffer::Create(BasicVertexAttributeSpecs);
-	vbo->SetVertices(vertices);
-	Log::Debug("num vertices: {}", vertices.size());
-	VertexArray* vao = VertexArray::Create();
-	vao->AddVertexBuffer(*vbo);
-	return vao;
-}
+#include "MeshAssetRegistry.h"
 
-MeshComponent::MeshComponent(const MeshComponent& other) : filepath(other.filepath) {
-	LoadOBJ();
+MeshComponent::MeshComponent(const MeshComponent& other) : filepath(other.filepath), asset(other.asset) {
+	// copies made while loading a scene have only the filepath
+	if (asset == nullptr) { LoadOBJ(); }
 }
 
 MeshComponent::MeshComponent(const std::string& filepath) : filepath(filepath) {
@@ -25,15 +12,15 @@ MeshComponent::MeshComponent(const std::string& filepath) : filepath(filepath) {
 }
 
 void MeshComponent::LoadOBJ() {
-	vao = filepath.empty() ? nullptr : VertexArrayFromOBJ(filepath);
+	asset = filepath.empty() ? nullptr : MeshAssetRegistry::LoadOBJ(filepath);
 }
 
 
 
 ProceduralMeshComponent::ProceduralMeshComponent() { GenerateMesh(); }
 
-ProceduralMeshComponent::ProceduralMeshComponent(const ProceduralMeshComponent& other) : parameters(other.parameters) {
-	GenerateMesh();
+ProceduralMeshComponent::ProceduralMeshComponent(const ProceduralMeshComponent& other) : parameters(other.parameters), asset(other.asset) {
+	if (asset == nullptr) { GenerateMesh(); }
 }
 
 ProceduralMeshComponent::ProceduralMeshComponent(const Parameters& parameters) : parameters(parameters) {
@@ -41,22 +28,5 @@ ProceduralMeshComponent::ProceduralMeshComponent(const Parameters& parameters) :
 }
 
 void ProceduralMeshComponent::GenerateMesh() {
-	VertexBuffer* vbo;
-	if (vao == nullptr) {
-		vao = VertexArray::Create();
-		vbo = VertexBuffer::Create(BasicVertexAttributeSpecs);
-		vao->AddVertexBuffer(*vbo);
-	}
-	else { vbo = vao->GetVertexBuffers()[0]; }
-
-	std::vector<BasicVertex> vertices;
-	switch (parameters.shape) {
-		case Shape::Box:
-			vertices = GenerateBox(parameters.box.dimensions);
-			break;
-		case Shape::Torus:
-			vertices = GenerateTorus(parameters.torus.outerRadius, parameters.torus.outerSegments, parameters.torus.innerRadius, parameters.torus.innerSegments);
-			break;
-	}
-	vbo->SetVertices(vertices);
+	asset = MeshAssetRegistry::Generate(parameters);
 }
\ No newline at end of file
@@ -1,10 +1,11 @@
 #pragma once
-#include "Renderer/VertexArray.h"
+#include "Renderer/MeshAsset.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <cereal/cereal.hpp>
 
+#include <memory>
 #include <string>
 
 // For serialization of glm data structures
@@ -57,17 +58,24 @@ struct TransformComponent {
 	void serialize(Archive& ar) { ar(CEREAL_NVP(translation), CEREAL_NVP(rotation), CEREAL_NVP(scale)); }
 };
 
+// Matrices of an entity derived from its TransformComponent, kept up to date by TransformCache. Not serialized.
+struct WorldTransformComponent {
+	glm::mat4 world = glm::mat4(1.0f);
+	glm::mat3 normal = glm::mat3(1.0f); // inverse transpose of the upper 3x3 of world
+};
+
 struct MeshComponent {
 	std::string filepath;
 	// not to serialize
-	VertexArray* vao = nullptr;
+	std::shared_ptr<MeshAsset> asset; // shared by all components using the same file, see MeshAssetRegistry
+	mutable int lod = 0; // chosen when last rendered, so that LOD changes can lag behind size changes
 
 	MeshComponent() = default;
 	MeshComponent(const MeshComponent&);
 	MeshComponent(const std::string& filepath);
-	~MeshComponent() { /*delete vao;*/ } // TODO: fix component clean up of renderer resources
+	~MeshComponent() = default;
 
-	// Call after changing filepath
+	// Call after changing filepath or MeshAsset::defaultFormat
 	void LoadOBJ();
 
 	template <class Archive>
@@ -101,14 +109,14 @@ struct ProceduralMeshComponent {
 	};
 	Parameters parameters;
 	// not to serialize
-	VertexArray* vao = nullptr;
+	std::shared_ptr<MeshAsset> asset; // shared by all components with the same parameters, see MeshAssetRegistry
 
 	ProceduralMeshComponent();
 	ProceduralMeshComponent(const ProceduralMeshComponent&);
 	ProceduralMeshComponent(const Parameters& parameters);
 	~ProceduralMeshComponent() = default;
 
-	// Call after changing parameters.
+	// Call after changing parameters or MeshAsset::defaultFormat.
 	void GenerateMesh();
 
 	template <class Archive>
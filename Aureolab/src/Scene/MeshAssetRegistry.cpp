@@ -0,0 +1,221 @@
+#include "MeshAssetRegistry.h"
+
+#include "Core/Log.h"
+#include "Core/ThreadPool.h"
+#include "Renderer/VertexBuffer.h"
+#include "Renderer/IndexBuffer.h"
+#include "Renderer/GeometryPool.h"
+#include "Renderer/Renderer.h"
+#include "Modeling/Modeling.h"
+#include "Modeling/MeshCache.h"
+#include "Modeling/VertexPacking.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static MeshAsset* CreateMeshAsset(VertexFormat format) {
+	return new MeshAsset(VertexBuffer::Create(GetVertexAttributeSpecs(format)), IndexBuffer::Create(), format);
+}
+
+// BVH over the triangles of the full detail mesh, for picking
+static TriangleBvh BuildTriangleBvh(const BasicVertex* vertices, const unsigned int* indices, size_t numIndices, const MeshLod* lods, size_t numLods) {
+	if (numLods == 0) { return TriangleBvh(vertices, indices, 0, numIndices); }
+	return TriangleBvh(vertices, indices, lods[0].indexOffset, lods[0].indexCount);
+}
+
+static MeshAsset* MeshAssetFromMeshData(const MeshData& mesh) {
+	MeshAsset* asset = CreateMeshAsset(MeshAsset::defaultFormat);
+	asset->decoding = UploadPackedVertices(*asset->vbo, mesh.vertices.data(), mesh.vertices.size(), asset->format);
+	asset->ebo->UploadCompactIndices(mesh.indices);
+	asset->lods = mesh.lods;
+	asset->meshlets = mesh.meshlets;
+	asset->box = ComputeBoundingBox(mesh.vertices.data(), mesh.vertices.size());
+	asset->bounds = ComputeBoundingSphere(mesh.vertices.data(), mesh.vertices.size());
+	asset->bvh = BuildTriangleBvh(mesh.vertices.data(), mesh.indices.data(), mesh.indices.size(), mesh.lods.data(), mesh.lods.size());
+	Log::Debug("num vertices: {}, num indices: {}", mesh.vertices.size(), mesh.indices.size());
+	return asset;
+}
+
+// Reads the mesh cache of the OBJ file, or imports the file with numThreads parsing it (0: hardware threads) and writes its cache. Used by synchronous and asynchronous loads alike.
+static MeshData MeshDataFromOBJ(const std::string& filepath, unsigned int numThreads) {
+	if (MeshCache* cache = MeshCache::Open(filepath)) {
+		Log::Debug("Loading {} from mesh cache", filepath);
+		const MeshCacheHeader& header = cache->GetHeader();
+		MeshData mesh;
+		mesh.vertices.assign(cache->GetVertices(), cache->GetVertices() + header.numVertices);
+		if (cache->GetIndexType() == IndexType::uint16) {
+			const unsigned short* indices = (const unsigned short*)cache->GetIndices();
+			mesh.indices.assign(indices, indices + header.numIndices);
+		}
+		else {
+			const unsigned int* indices = (const unsigned int*)cache->GetIndices();
+			mesh.indices.assign(indices, indices + header.numIndices);
+		}
+		mesh.lods.assign(cache->GetLods(), cache->GetLods() + header.numLods);
+		mesh.meshlets.assign(cache->GetMeshlets(), cache->GetMeshlets() + header.numMeshlets);
+		delete cache;
+		return mesh;
+	}
+	const MeshCacheSource source = MeshCache::ReadSource(filepath);
+	MeshData mesh = LoadOBJ(filepath, numThreads);
+	MeshCache::Write(filepath, source, mesh);
+	return mesh;
+}
+
+static MeshAsset* MeshAssetFromOBJ(const std::string& filepath) {
+	return MeshAssetFromMeshData(MeshDataFromOBJ(filepath, 0));
+}
+
+static MeshAsset* MeshAssetFromParameters(const ProceduralMeshComponent::Parameters& parameters) {
+	MeshData mesh;
+	switch (parameters.shape) {
+		case ProceduralMeshComponent::Shape::Box:
+			mesh = GenerateBox(parameters.box.dimensions);
+			break;
+		case ProceduralMeshComponent::Shape::Torus:
+			mesh = GenerateTorus(parameters.torus.outerRadius, parameters.torus.outerSegments, parameters.torus.innerRadius, parameters.torus.innerSegments);
+			break;
+	}
+	return MeshAssetFromMeshData(mesh);
+}
+
+// Raw bytes of a value with no padding, to use as an exact key
+template<typename T>
+static std::string KeyBytes(const T& value) {
+	std::string bytes(sizeof(T), '\0');
+	std::memcpy(bytes.data(), &value, sizeof(T));
+	return bytes;
+}
+
+std::shared_ptr<MeshAsset> MeshAssetRegistry::LoadOBJ(const std::string& filepath) {
+	const std::string key = "obj:" + std::string(vertexFormatNames[(int)MeshAsset::defaultFormat]) + ":" + filepath;
+	if (std::shared_ptr<MeshAsset> asset = Find(key)) { return asset; }
+	if (!isAsync) { return Insert(key, MeshAssetFromOBJ(filepath)); }
+
+	// Empty buffers for now, filled by Update once a worker has loaded the file
+	MeshAsset* asset = CreateMeshAsset(MeshAsset::defaultFormat);
+	asset->isReady = false;
+	std::shared_ptr<MeshAsset> shared = Insert(key, asset);
+	progress.numRequested++;
+	ThreadPool::GetShared().Submit([filepath, format = asset->format, weakAsset = std::weak_ptr<MeshAsset>(shared)]() {
+		LoadedMesh loadedMesh = LoadInBackground(filepath, format);
+		loadedMesh.asset = weakAsset;
+		std::lock_guard<std::mutex> lock(loadedMutex);
+		loaded.push_back(std::move(loadedMesh));
+	});
+	return shared;
+}
+
+MeshAssetRegistry::LoadedMesh MeshAssetRegistry::LoadInBackground(const std::string& filepath, VertexFormat format) {
+	LoadedMesh loadedMesh;
+	// Workers load files in parallel already, parsing each on more threads would start cores x cores of them
+	loadedMesh.mesh = MeshDataFromOBJ(filepath, 1);
+	std::vector<BasicVertex>& vertices = loadedMesh.mesh.vertices;
+	loadedMesh.box = ComputeBoundingBox(vertices.data(), vertices.size());
+	loadedMesh.bounds = ComputeBoundingSphere(vertices.data(), vertices.size());
+	const MeshData& mesh = loadedMesh.mesh;
+	loadedMesh.bvh = BuildTriangleBvh(vertices.data(), mesh.indices.data(), mesh.indices.size(), mesh.lods.data(), mesh.lods.size());
+	loadedMesh.vertices = PackVertices(vertices.data(), vertices.size(), format);
+	vertices = {};
+	return loadedMesh;
+}
+
+void MeshAssetRegistry::Update() {
+	{
+		// Boxes are cheap, so placeholders take the size of their mesh already while its upload waits
+		std::lock_guard<std::mutex> lock(loadedMutex);
+		for (const LoadedMesh& loadedMesh : loaded) {
+			if (std::shared_ptr<MeshAsset> asset = loadedMesh.asset.lock()) { asset->box = loadedMesh.box; }
+		}
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	bool hasUploaded = false;
+	while (true) {
+		const float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (hasUploaded && elapsedMs > uploadBudgetMs) { break; } // at least one upload per frame, so that huge meshes are not stuck
+		LoadedMesh loadedMesh;
+		{
+			std::lock_guard<std::mutex> lock(loadedMutex);
+			if (loaded.empty()) { break; }
+			loadedMesh = std::move(loaded.front());
+			loaded.pop_front();
+		}
+		progress.numDone++;
+		std::shared_ptr<MeshAsset> asset = loadedMesh.asset.lock();
+		if (asset == nullptr) { continue; } // nobody uses it anymore
+
+		loadedMesh.vertices.Upload(*asset->vbo);
+		asset->decoding = loadedMesh.vertices.decoding;
+		asset->ebo->UploadCompactIndices(loadedMesh.mesh.indices);
+		asset->lods = std::move(loadedMesh.mesh.lods);
+		asset->meshlets = std::move(loadedMesh.mesh.meshlets);
+		asset->box = loadedMesh.box;
+		asset->bounds = loadedMesh.bounds;
+		asset->bvh = std::move(loadedMesh.bvh);
+		asset->isReady = true;
+		if (Renderer::isMultiDrawIndirectEnabled) { GeometryPool::Add(asset.get()); }
+		hasUploaded = true;
+	}
+	if (progress.numDone == progress.numRequested) { progress = {}; }
+}
+
+const MeshAsset* MeshAssetRegistry::GetPlaceholder() {
+	if (placeholder == nullptr) { placeholder = Generate(ProceduralMeshComponent::Parameters{}); } // default is a unit box
+	return placeholder.get();
+}
+
+glm::mat4 MeshAssetRegistry::GetPlaceholderTransform(const MeshAsset* asset) {
+	const glm::vec3 center = (asset->box.min + asset->box.max) * 0.5f;
+	const glm::vec3 size = glm::max(asset->box.max - asset->box.min, glm::vec3(1e-3f)); // keep flat meshes invertible
+	return glm::translate(glm::mat4(1.0f), center) * glm::scale(glm::mat4(1.0f), size);
+}
+
+MeshLoadingProgress MeshAssetRegistry::GetLoadingProgress() {
+	return progress;
+}
+
+std::shared_ptr<MeshAsset> MeshAssetRegistry::Generate(const ProceduralMeshComponent::Parameters& parameters) {
+	std::string key = "procedural:" + std::string(vertexFormatNames[(int)MeshAsset::defaultFormat]) + ":" + ProceduralMeshComponent::shapeNames[(int)parameters.shape] + ":";
+	// only the parameters of the chosen shape matter
+	switch (parameters.shape) {
+		case ProceduralMeshComponent::Shape::Box:
+			key += KeyBytes(parameters.box.dimensions);
+			break;
+		case ProceduralMeshComponent::Shape::Torus:
+			key += KeyBytes(parameters.torus.outerRadius) + KeyBytes(parameters.torus.outerSegments) + KeyBytes(parameters.torus.innerRadius) + KeyBytes(parameters.torus.innerSegments);
+			break;
+	}
+	if (std::shared_ptr<MeshAsset> asset = Find(key)) { return asset; }
+	return Insert(key, MeshAssetFromParameters(parameters));
+}
+
+void MeshAssetRegistry::Shutdown() {
+	placeholder.reset();
+	std::lock_guard<std::mutex> lock(loadedMutex);
+	loaded.clear();
+}
+
+size_t MeshAssetRegistry::GetNumAssets() {
+	// The placeholder is not a mesh of the scene, unless components use a unit box too
+	const bool isPlaceholderUsed = placeholder.use_count() > 1;
+	return std::count_if(assets.begin(), assets.end(), [&](const auto& entry) { return !entry.second.expired() && (isPlaceholderUsed || entry.second.lock() != placeholder); });
+}
+
+std::shared_ptr<MeshAsset> MeshAssetRegistry::Find(const std::string& key) {
+	auto it = assets.find(key);
+	return it == assets.end() ? nullptr : it->second.lock();
+}
+
+std::shared_ptr<MeshAsset> MeshAssetRegistry::Insert(const std::string& key, MeshAsset* asset) {
+	// Forget freed assets, e.g. the ones left behind while dragging the parameters of a procedural shape
+	std::erase_if(assets, [](const auto& entry) { return entry.second.expired(); });
+	std::shared_ptr<MeshAsset> shared(asset);
+	assets[key] = shared;
+	// Record where it goes in the geometry pools at import, rather than at its first draw
+	if (asset->isReady && Renderer::isMultiDrawIndirectEnabled) { GeometryPool::Add(asset); }
+	return shared;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Components.h"
+#include "Modeling/VertexPacking.h"
+#include "Renderer/MeshAsset.h"
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct MeshLoadingProgress {
+	size_t numDone = 0;
+	size_t numRequested = 0; // since the last time all loads were done
+};
+
+/*
+* Hands out shared MeshAssets, so that all components using the same OBJ file or procedural shape share one copy of the geometry.
+* Assets are keyed by their source and MeshAsset::defaultFormat. GPU buffers are freed when the last handle to an asset goes away.
+* OBJ files are parsed and converted on worker threads. Their assets are not ready until Update uploads them, and render as their bounding box meanwhile.
+*/
+class MeshAssetRegistry {
+public:
+	static std::shared_ptr<MeshAsset> LoadOBJ(const std::string& filepath);
+	static std::shared_ptr<MeshAsset> Generate(const ProceduralMeshComponent::Parameters& parameters);
+
+	// Uploads meshes loaded by worker threads, for about uploadBudgetMs. Call once per frame on the thread of the graphics context.
+	static void Update();
+	// Unit box drawn in place of meshes that are not ready
+	static const MeshAsset* GetPlaceholder();
+	// Maps the placeholder onto the bounds of given mesh, which are a unit box until known
+	static glm::mat4 GetPlaceholderTransform(const MeshAsset* asset);
+
+	// Number of assets alive, i.e. of unique meshes on GPU
+	static size_t GetNumAssets();
+	static MeshLoadingProgress GetLoadingProgress();
+	// Frees the placeholder and drops meshes waiting for upload. Call before the graphics context goes away, static destruction is too late.
+	static void Shutdown();
+
+	static inline bool isAsync = true;
+	static inline float uploadBudgetMs = 4.0f;
+private:
+	// Geometry prepared on a worker thread, waiting for upload
+	struct LoadedMesh {
+		std::weak_ptr<MeshAsset> asset;
+		PackedVertices vertices;
+		MeshData mesh; // vertices are moved into the packed ones
+		BoundingBox box;
+		BoundingSphere bounds;
+		TriangleBvh bvh;
+	};
+
+	static std::shared_ptr<MeshAsset> Find(const std::string& key);
+	static std::shared_ptr<MeshAsset> Insert(const std::string& key, MeshAsset* asset);
+	static LoadedMesh LoadInBackground(const std::string& filepath, VertexFormat format);
+
+	static inline std::unordered_map<std::string, std::weak_ptr<MeshAsset>> assets;
+	static inline std::shared_ptr<MeshAsset> placeholder;
+	static inline MeshLoadingProgress progress;
+	static inline std::mutex loadedMutex;
+	static inline std::deque<LoadedMesh> loaded; // by the shared ThreadPool, which is created after it and so joins its workers before it goes away
+};
\ No newline at end of file
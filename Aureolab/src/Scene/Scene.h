@@ -2,6 +2,8 @@
 
 #include "Core/Log.h"
 #include "Components.h"
+#include "Renderer/SceneBuffer.h"
+#include "Scene/TransformCache.h"
 
 #include <entt/entt.hpp>
 #include <cereal/cereal.hpp>
@@ -35,10 +37,17 @@ public:
 	void SaveToMemory();
 	void LoadFromMemory();
 
+	// Recomputes the world transforms of entities whose TransformComponent changed. Call before updating the scene buffer.
+	void UpdateWorldTransforms() { transformCache.Update(); }
+	// GPU copy of the entities to render, kept in sync with the registry
+	SceneBuffer& GetSceneBuffer() { return sceneBuffer; }
+
 	glm::vec4 ambientColor = { 0.0f, 0.0f, 0.0f, 1.0f };
 	glm::vec4 backgroundColor = { 0.0f, 0.0f, 0.0f, 1.0f };
 
 private:
 	entt::registry registry;
+	TransformCache transformCache{ registry }; // declared after registry, which it observes
+	SceneBuffer sceneBuffer{ registry }; // same
 	std::stringstream storage;
 };
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "TransformCache.h"
+
+#include "Core/ThreadPool.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <thread>
+
+TransformCache::TransformCache(entt::registry& registry)
+	: registry(registry) {
+	registry.on_construct<TransformComponent>().connect<&TransformCache::OnChanged>(this);
+	registry.on_update<TransformComponent>().connect<&TransformCache::OnChanged>(this);
+	registry.on_destroy<TransformComponent>().connect<&TransformCache::OnChanged>(this);
+}
+
+TransformCache::~TransformCache() {
+	registry.on_construct<TransformComponent>().disconnect(this);
+	registry.on_update<TransformComponent>().disconnect(this);
+	registry.on_destroy<TransformComponent>().disconnect(this);
+}
+
+void TransformCache::Update() {
+	if (dirtyEntities.empty()) { return; }
+	std::sort(dirtyEntities.begin(), dirtyEntities.end());
+	dirtyEntities.erase(std::unique(dirtyEntities.begin(), dirtyEntities.end()), dirtyEntities.end());
+
+	// Add and remove components here, since pools must not change while the workers write into them
+	for (entt::entity ent : dirtyEntities) {
+		if (!registry.valid(ent)) { continue; }
+		if (registry.all_of<TransformComponent>(ent)) { registry.get_or_emplace<WorldTransformComponent>(ent); }
+		else { registry.remove<WorldTransformComponent>(ent); }
+	}
+	jobs.clear();
+	for (entt::entity ent : dirtyEntities) {
+		if (!registry.valid(ent) || !registry.all_of<TransformComponent>(ent)) { continue; }
+		jobs.emplace_back(&registry.get<TransformComponent>(ent), &registry.get<WorldTransformComponent>(ent));
+	}
+	dirtyEntities.clear();
+
+	auto computeRange = [this](size_t begin, size_t end) {
+		for (size_t ix = begin; ix < end; ix++) { *jobs[ix].second = Compute(*jobs[ix].first); }
+	};
+	const size_t numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	if (jobs.size() < parallelMinEntities || numThreads == 1) {
+		computeRange(0, jobs.size());
+		return;
+	}
+	const size_t numChunks = std::min(numThreads, jobs.size() / (parallelMinEntities / 2));
+	ThreadPool::GetShared().RunInParallel(numChunks, [&](size_t chunk) {
+		computeRange(jobs.size() * chunk / numChunks, jobs.size() * (chunk + 1) / numChunks);
+	});
+}
+
+WorldTransformComponent TransformCache::Compute(const TransformComponent& transform) {
+	const glm::mat3 rotation = glm::mat3_cast(glm::quat(transform.rotation));
+	WorldTransformComponent result;
+	for (int axis = 0; axis < 3; axis++) {
+		result.world[axis] = glm::vec4(rotation[axis] * transform.scale[axis], 0.0f);
+		// For rotation R and scale S, the inverse transpose of R * S is R * S^-1. Zero scales give zero normals instead of infinities.
+		result.normal[axis] = transform.scale[axis] != 0.0f ? rotation[axis] / transform.scale[axis] : glm::vec3(0.0f);
+	}
+	result.world[3] = glm::vec4(transform.translation, 1.0f);
+	return result;
+}
+
+void TransformCache::OnChanged(entt::registry& registry, entt::entity ent) {
+	dirtyEntities.push_back(ent);
+}
\ No newline at end of file
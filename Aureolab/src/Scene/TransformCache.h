@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Scene/Components.h"
+
+#include <entt/entt.hpp>
+
+#include <utility>
+#include <vector>
+
+/*
+* Keeps the WorldTransformComponent of all entities with a TransformComponent up to date.
+* Follows transform changes through registry signals, and each Update recomputes only the entities changed since the previous one,
+* in chunks on the workers of the shared ThreadPool when there are many. Transforms modified in place have to be marked as changed, e.g. with registry.patch<TransformComponent>(ent).
+*/
+class TransformCache {
+public:
+	TransformCache(entt::registry& registry);
+	TransformCache(const TransformCache&) = delete;
+	TransformCache& operator=(const TransformCache&) = delete;
+	~TransformCache();
+
+	// Call once per frame before world transforms are read, e.g. before SceneBuffer::Update
+	void Update();
+
+	// Translation, then rotation from Euler angles, then scale. The normal matrix is the rotation divided by the scale, which needs no inverse.
+	static WorldTransformComponent Compute(const TransformComponent& transform);
+
+	// Updates of at least this many entities are computed on worker threads
+	static inline size_t parallelMinEntities = 4096;
+private:
+	void OnChanged(entt::registry& registry, entt::entity ent);
+
+	entt::registry& registry;
+	std::vector<entt::entity> dirtyEntities; // may repeat entities
+	std::vector<std::pair<const TransformComponent*, WorldTransformComponent*>> jobs;
+};
\ No newline at end of file
@@ -5,13 +5,16 @@
 #include "Core/GraphicsContext.h"
 #include "Renderer/GraphicsAPI.h"
 #include "Scene/Components.h"
+#include "Scene/MeshAssetRegistry.h"
 #include "Renderer/Renderer.h"
 
 #include <imgui.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <string>
+#include <utility>
 
 void EditorLayer::OnAttach() {
 	// in case we'll see an area not behind any ImWindow
@@ -23,16 +26,24 @@ void EditorLayer::OnAttach() {
 	// keep if stencil fails. replace if stencil pass, independent of depth.
 	GraphicsAPI::Get()->SetStencilOperation(StencilAction::Keep, StencilAction::Replace, StencilAction::Replace);
 
-	selectionShader = Shader::Create("assets/shaders/SelectionShader.glsl");
 	shader = Shader::Create("assets/shaders/BasicShader.glsl");
 	solidColorShader = Shader::Create("assets/shaders/SolidColor.glsl");
 	outlineShader = Shader::Create("assets/shaders/Outline.glsl");
+	depthDownsampleShader = Shader::Create("assets/shaders/DepthDownsample.glsl");
+	occlusionBoxShader = Shader::Create("assets/shaders/OcclusionBox.glsl");
+	gBufferShader = Shader::Create("assets/shaders/GBuffer.glsl");
+	deferredLightingShader = Shader::Create("assets/shaders/DeferredLighting.glsl");
 	viewUbo = UniformBuffer::Create("ViewData", sizeof(ViewData));
-	viewUbo->BlockBind(shader);
-	lightsUbo = UniformBuffer::Create("Lights", sizeof(Lights));
-	lightsUbo->BlockBind(shader);
-	viewportFbo = FrameBuffer::Create(100, 100, FrameBuffer::TextureFormat::RGBA8); // arguments does not matter since FBO's going to be resized
-	selectionFbo = FrameBuffer::Create(100, 100, FrameBuffer::TextureFormat::RED_INTEGER);
+	lightClusters.BlockBind(shader);
+	lightClusters.BlockBind(deferredLightingShader);
+	for (Shader* sceneShader : { shader, solidColorShader, outlineShader, gBufferShader }) {
+		viewUbo->BlockBind(sceneShader);
+		scene.GetSceneBuffer().BlockBind(sceneShader);
+		renderQueue.BlockBind(sceneShader);
+	}
+	viewUbo->BlockBind(deferredLightingShader);
+	scene.GetSceneBuffer().BlockBindEntities(deferredLightingShader);
+	occlusionCuller = OcclusionCuller::Create(depthDownsampleShader, occlusionBoxShader);
 	camera = new EditorCamera(45, 1.0f, 0.01f, 100); // aspect = 1.0f will be recomputed
 
 	ExampleScene::PopulateScene(scene);
@@ -44,6 +55,16 @@ void EditorLayer::OnUpdate(float ts) {
 	frameRates[frameRates.size() - 1] = 1.0f / ts;
 
 	camera->OnUpdate(ts);
+	Renderer::stats = {};
+	GraphicsAPI::stats = {};
+	MeshAssetRegistry::Update();
+	renderTargets.BeginFrame();
+	// Color, and the ID of the entity drawn at each pixel, which BasicShader writes in the same pass. At the viewport size.
+	viewportFbo = renderTargets.Get("Viewport", { { FrameBuffer::TextureFormat::RGBA8, FrameBuffer::TextureFormat::RED_INTEGER, FrameBuffer::TextureFormat::DEPTH24_STENCIL8 } });
+	viewportFbo->PollReadbacks();
+	scene.UpdateWorldTransforms();
+	SceneBuffer& sceneBuffer = scene.GetSceneBuffer();
+	sceneBuffer.Update(); // after meshes that finished loading are ready and world transforms are up to date
 	ViewData viewData;
 	viewData.projection = camera->GetProjection();
 	viewData.view = camera->GetViewMatrix();
@@ -53,8 +74,7 @@ void EditorLayer::OnUpdate(float ts) {
 
 	// Lights System
 	auto queryLights = scene.View<TransformComponent, LightComponent>();
-	int ix = 0;
-	Lights lightsData;
+	std::vector<Light> lights;
 	for (const auto& [ent, transform, lightC] : queryLights.each()) {
 		Light light;
 		light.type = (int)lightC.type;
@@ -63,98 +83,242 @@ void EditorLayer::OnUpdate(float ts) {
 		light.pointParams.position = { transform.translation.x, transform.translation.y, transform.translation.z, 1.0f };
 		light.pointParams.attenuation = { lightC.pointParams.attenuation.x, lightC.pointParams.attenuation.y, lightC.pointParams.attenuation.z, 0.0f };
 		light.directionalParams.direction = { lightC.directionalParams.direction.x, lightC.directionalParams.direction.y, lightC.directionalParams.direction.z, 0.0f };
-		lightsData.lights[ix] = light;
-		ix++;
-		if (ix == MAX_LIGHTS) break;
+		lights.push_back(light);
 	}
-	lightsData.numLights = ix;
-	lightsData.ambientLight = scene.ambientColor;
-	lightsUbo->UploadData((const void*)&lightsData);
+	lightClusters.Update(lights, glm::vec3(scene.ambientColor), viewData, viewportFbo->GetWidth(), viewportFbo->GetHeight());
 
-	GraphicsAPI::Get()->Clear();
+	// Picking is done on the CPU, before rendering so that the hover wireframe is of this frame
+	const glm::mat4 viewProjection = viewData.projection * viewData.view;
+	PickObjects(sceneBuffer, viewProjection);
 
-	// Render pass 1: render scene into viewportFBO
-	viewportFbo->Bind();
-	GraphicsAPI::Get()->SetClearColor(scene.backgroundColor);
 	GraphicsAPI::Get()->Clear();
-	GraphicsAPI::Get()->SetStencilFunction(BufferTestFunction::Always, 1, 0xFF);
-	unsigned int mask = 0x00;
-	shader->Bind();
-	auto query = scene.View<TransformComponent, MeshComponent, MeshRendererComponent>();
-	for (const auto& [ent, transform, mesh, meshRenderer] : query.each()) {
-		mask = (selectedObject && selectedObject.entity() == ent) ? 0xFF : 0x00;
-		GraphicsAPI::Get()->SetStencilMask(mask);
-		Renderer::RenderMesh(shader, viewData, transform, mesh, meshRenderer);
-	}
-	auto query2 = scene.View<TransformComponent, ProceduralMeshComponent, MeshRendererComponent>();
-	for (const auto& [ent, transform, pMesh, meshRenderer] : query2.each()) {
-		mask = (selectedObject && selectedObject.entity() == ent) ? 0xFF : 0x00;
-		GraphicsAPI::Get()->SetStencilMask(mask);
-		Renderer::RenderProceduralMesh(shader, viewData, transform, pMesh, meshRenderer);
-	}
-	shader->Unbind();
-
-	// Overlay wireframe of hovered object, if any
-	solidColorShader->Bind();
-	GraphicsAPI::Get()->SetStencilMask(0x00);
-	GraphicsAPI::Get()->Enable(GraphicsAbility::PolygonOffsetLine);
-	GraphicsAPI::Get()->SetPolygonOffset(-1.0f, -1.0f); // prevent z-fighting btw the object and its wireframe
-	GraphicsAPI::Get()->SetPolygonMode(PolygonMode::Line);
-	if (hoveredObject) {
-		const EntityHandle& obj = hoveredObject;
-		solidColorShader->UploadUniformFloat4("u_Color", { 0.8f, 0.8f, 0.8f, 1.0f });
+
+	// The frame's passes. Each sets only the state it differs in from the state of the frame, and the graph changes between them.
+	renderGraph.Reset(GraphicsAPI::Get()->GetPipelineState());
+	const RenderGraph::Resource viewport = renderGraph.Import("Viewport", viewportFbo);
+	auto renderEntity = [&](Shader* entityShader, const EntityHandle& obj) {
 		if (obj.any_of<MeshComponent>()) {
-			Renderer::RenderMesh(solidColorShader, viewData, obj.get<TransformComponent>(), obj.get<MeshComponent>(), obj.get<MeshRendererComponent>());
+			Renderer::RenderMesh(entityShader, viewData, sceneBuffer, obj.entity(), obj.get<MeshComponent>());
 		}
 		else if (obj.any_of<ProceduralMeshComponent>()) {
-			Renderer::RenderProceduralMesh(solidColorShader, viewData, obj.get<TransformComponent>(), obj.get<ProceduralMeshComponent>(), obj.get<MeshRendererComponent>());
+			Renderer::RenderProceduralMesh(entityShader, viewData, sceneBuffer, obj.entity(), obj.get<ProceduralMeshComponent>());
 		}
 	};
-	GraphicsAPI::Get()->SetPolygonMode(PolygonMode::Fill);
-	GraphicsAPI::Get()->Disable(GraphicsAbility::PolygonOffsetLine);
-	solidColorShader->Unbind();
-
-	// Outline selected object, if any
-	GraphicsAPI::Get()->SetStencilFunction(BufferTestFunction::NotEqual, 1, 0xFF);
-	GraphicsAPI::Get()->SetStencilMask(0x00);
-	GraphicsAPI::Get()->Disable(GraphicsAbility::DepthTest);
-	outlineShader->Bind();
-	if (selectedObject) {
-		const EntityHandle& obj = selectedObject;
-		outlineShader->UploadUniformFloat4("u_Color", { 1.0f, 1.0f, 0.0f, 1.0f });
+
+	// Stencil of the passes drawing entities: 1 where the selected object is, whose packets are the only ones with a write mask
+	auto writeSelectionStencil = [](PipelineState& state) {
+		state.stencilFunction = BufferTestFunction::Always;
+		state.stencilReference = 1;
+		state.stencilReadMask = 0xFF;
+		state.stencilWriteMask = 0xFF;
+	};
+	// Slots of the entities found in the view, and not hidden behind the depth of earlier frames. Only opaque entities are occlusion culled,
+	// since the culled ones that turn out visible are drawn right after the opaque ones.
+	std::vector<uint32_t> visibleSlots;
+	auto cullEntities = [&]() -> const std::vector<uint32_t>& {
+		const std::vector<uint32_t>& frustumSlots = culler.Cull(sceneBuffer, viewProjection);
+		if (!Renderer::isOcclusionCullingEnabled) { return frustumSlots; }
+		std::vector<uint32_t> opaqueSlots;
+		for (uint32_t slot : frustumSlots) {
+			if (RenderQueue::IsTransparent(sceneBuffer.GetEntityData(slot))) { visibleSlots.push_back(slot); }
+			else { opaqueSlots.push_back(slot); }
+		}
+		const std::vector<uint32_t>& unoccludedSlots = occlusionCuller->Cull(sceneBuffer.GetBounds(), opaqueSlots);
+		visibleSlots.insert(visibleSlots.end(), unoccludedSlots.begin(), unoccludedSlots.end());
+		return visibleSlots;
+	};
+	// Second phase of occlusion culling, after the opaque entities: draws the culled entities that the depth of this frame does not hide
+	auto drawRevealedEntities = [&](Shader* entityShader) {
+		occlusionCuller->DrawRevealed(sceneBuffer.GetBounds(), viewProjection, [&](uint32_t slot) {
+			const EntityHandle obj = scene.GetHandle(sceneBuffer.GetEntity(slot));
+			entityShader->Bind();
+			GraphicsAPI::Get()->SetStencilMask((selectedObject && selectedObject.entity() == obj.entity()) ? 0xFF : 0x00);
+			renderEntity(entityShader, obj);
+		});
+	};
+	auto queueEntity = [&](Shader* entityShader, uint32_t slot) {
+		const EntityHandle obj = scene.GetHandle(sceneBuffer.GetEntity(slot));
+		const unsigned int mask = (selectedObject && selectedObject.entity() == obj.entity()) ? 0xFF : 0x00;
 		if (obj.any_of<MeshComponent>()) {
-			Renderer::RenderMesh(outlineShader, viewData, obj.get<TransformComponent>(), obj.get<MeshComponent>(), obj.get<MeshRendererComponent>());
+			renderQueue.Add(entityShader, viewData, sceneBuffer, obj.entity(), obj.get<MeshComponent>(), mask);
 		}
 		else if (obj.any_of<ProceduralMeshComponent>()) {
-			Renderer::RenderProceduralMesh(outlineShader, viewData, obj.get<TransformComponent>(), obj.get<ProceduralMeshComponent>(), obj.get<MeshRendererComponent>());
+			renderQueue.Add(entityShader, viewData, sceneBuffer, obj.entity(), obj.get<ProceduralMeshComponent>(), mask);
 		}
+	};
+
+	// The packets of all passes are queued and prepared before any pass draws, so that the instances of the frame are flushed once.
+	// The deferred path draws the opaque packets into the G-buffer, and shades the transparent ones forward after lighting.
+	renderQueue.Clear();
+	for (uint32_t slot : cullEntities()) {
+		const bool isDeferred = shadingPath == ShadingPath::Deferred && !RenderQueue::IsTransparent(sceneBuffer.GetEntityData(slot));
+		queueEntity(isDeferred ? gBufferShader : shader, slot);
 	}
-	GraphicsAPI::Get()->SetStencilMask(0xFF);
-	GraphicsAPI::Get()->SetStencilFunction(BufferTestFunction::Always, 1, 0xFF);
-	GraphicsAPI::Get()->Enable(GraphicsAbility::DepthTest);
-	outlineShader->Unbind();
-	viewportFbo->Unbind();
-
-	// Render pass 2: render entityID of each object into an integer buffer
-	selectionFbo->Bind();
-	selectionFbo->Clear(-1); // value when not hovering on any object
-	selectionShader->Bind();
-	for (const auto& [ent, transform, mesh, meshRenderer] : query.each()) {
-		Renderer::RenderVertexArrayEntityID(ent, selectionShader, viewData, transform, mesh.vao, meshRenderer);
+	renderQueue.Prepare(sceneBuffer);
+	sceneBuffer.FlushInstances();
+
+	RenderGraph::Resource gBuffer = RenderGraph::invalidResource;
+	if (shadingPath == ShadingPath::Forward) {
+		// Color and entity IDs of the scene, and 1 in the stencil where the selected object is
+		renderGraph.AddPass("Scene", [&](RenderGraph::PassBuilder& builder) {
+			builder.Write(viewport);
+			writeSelectionStencil(builder.State());
+		}, [&](const RenderGraph& graph) {
+			GraphicsAPI::Get()->SetClearColor(scene.backgroundColor);
+			GraphicsAPI::Get()->Clear();
+			graph.GetFrameBuffer(viewport)->Clear(-1, 1); // no entity
+			renderQueue.Submit(viewData, sceneBuffer, [&]() {
+				// Transparent entities and overlays do not hide what is behind them
+				if (Renderer::isOcclusionCullingEnabled) {
+					drawRevealedEntities(shader);
+					occlusionCuller->Capture(*graph.GetFrameBuffer(viewport), viewProjection);
+				}
+			});
+			shader->Unbind();
+		});
+	}
+	else {
+		// Attributes of the opaque entities for deferred lighting, see DeferredShading, and the stencil of the selected object
+		renderGraph.AddPass("G-Buffer", [&](RenderGraph::PassBuilder& builder) {
+			gBuffer = builder.Create("G-Buffer", DeferredShading::gBufferSpec);
+			writeSelectionStencil(builder.State());
+		}, [&](const RenderGraph& graph) {
+			FrameBuffer* fbo = graph.GetFrameBuffer(gBuffer);
+			GraphicsAPI::Get()->Clear();
+			fbo->Clear(-1, DeferredShading::Slot); // no entity
+			renderQueue.Submit(RenderPass::Opaque, viewData, sceneBuffer);
+			if (Renderer::isOcclusionCullingEnabled) {
+				drawRevealedEntities(gBufferShader);
+				occlusionCuller->Capture(*fbo, viewProjection);
+			}
+			gBufferShader->Unbind();
+		});
+
+		// Color and entity IDs of the G-buffer, lit or as the chosen view, over its depth and stencil for what is drawn after
+		renderGraph.AddPass("Deferred Lighting", [&](RenderGraph::PassBuilder& builder) {
+			builder.Read(gBuffer);
+			builder.Write(viewport);
+			PipelineState& state = builder.State();
+			state.SetEnabled(GraphicsAbility::DepthTest, false);
+			state.SetEnabled(GraphicsAbility::StencilTest, false);
+			state.SetEnabled(GraphicsAbility::FaceCulling, false);
+		}, [&](const RenderGraph& graph) {
+			FrameBuffer* fbo = graph.GetFrameBuffer(viewport);
+			GraphicsAPI::Get()->SetClearColor(scene.backgroundColor);
+			GraphicsAPI::Get()->Clear();
+			fbo->Clear(-1, 1); // no entity
+			graph.GetFrameBuffer(gBuffer)->ResolveTo(*fbo, false);
+			deferredShading.Light(deferredLightingShader, *graph.GetFrameBuffer(gBuffer), viewData, gBufferView);
+			deferredLightingShader->Unbind();
+		});
+
+		// The G-buffer holds one surface per pixel, so transparent entities are shaded forward and blended over the lit scene
+		renderGraph.AddPass("Transparent", [&](RenderGraph::PassBuilder& builder) {
+			builder.Write(viewport);
+			writeSelectionStencil(builder.State());
+		}, [&](const RenderGraph&) {
+			renderQueue.Submit(RenderPass::Transparent, viewData, sceneBuffer);
+			shader->Unbind();
+		});
+	}
+
+	// Wireframe of hovered object, if any, and of the objects inside the marquee. Overlays keep the entity IDs of what is below them.
+	if (hoveredObject || !marquee.objects.empty()) {
+		renderGraph.AddPass("Hover Wireframe", [&](RenderGraph::PassBuilder& builder) {
+			builder.Write(viewport);
+			builder.SetDrawAttachments({ 0 });
+			PipelineState& state = builder.State();
+			state.stencilWriteMask = 0x00;
+			state.SetEnabled(GraphicsAbility::PolygonOffsetLine, true);
+			state.polygonOffsetFactor = -1.0f; // prevent z-fighting btw the object and its wireframe
+			state.polygonOffsetUnits = -1.0f;
+			state.polygonMode = PolygonMode::Line;
+		}, [&](const RenderGraph&) {
+			solidColorShader->Bind();
+			solidColorShader->UploadUniformFloat4("u_Color", { 0.8f, 0.8f, 0.8f, 1.0f });
+			if (hoveredObject) { renderEntity(solidColorShader, hoveredObject); }
+			for (const EntityHandle& obj : marquee.objects) { renderEntity(solidColorShader, obj); }
+			solidColorShader->Unbind();
+		});
 	}
-	for (const auto& [ent, transform, pMesh, meshRenderer] : query2.each()) {
-		Renderer::RenderVertexArrayEntityID(ent, selectionShader, viewData, transform, pMesh.vao, meshRenderer);
+
+	// Outline selected object, if any, around where its stencil is
+	if (selectedObject) {
+		renderGraph.AddPass("Selection Outline", [&](RenderGraph::PassBuilder& builder) {
+			builder.Write(viewport);
+			builder.SetDrawAttachments({ 0 });
+			PipelineState& state = builder.State();
+			state.stencilFunction = BufferTestFunction::NotEqual;
+			state.stencilReference = 1;
+			state.stencilReadMask = 0xFF;
+			state.stencilWriteMask = 0x00;
+			state.SetEnabled(GraphicsAbility::DepthTest, false);
+		}, [&](const RenderGraph&) {
+			outlineShader->Bind();
+			outlineShader->UploadUniformFloat4("u_Color", { 1.0f, 1.0f, 0.0f, 1.0f });
+			renderEntity(outlineShader, selectedObject);
+			outlineShader->Unbind();
+		});
 	}
-	hoveredEntityId = -3; // value when queried coordinates are not inside the selectionFbo
-	selectionFbo->ReadPixel(hoveredEntityId, mouseX, mouseY);
-	hoveredObject = scene.GetHandle((entt::entity)hoveredEntityId);
-	selectionShader->Unbind();
-	selectionFbo->Unbind();
+
+	// Color and entity ID under the mouse for the Stats panel, which arrive a few frames later without waiting for the GPU.
+	// Culled while the mouse is outside of the viewport.
+	renderGraph.AddPass("Mouse Readback", [&](RenderGraph::PassBuilder& builder) {
+		builder.Read(viewport);
+		if (mouseX >= 0 && mouseY >= 0 && mouseX < viewportFbo->GetWidth() && mouseY < viewportFbo->GetHeight()) { builder.SetSideEffects(); }
+	}, [&](const RenderGraph& graph) {
+		FrameBuffer* fbo = graph.GetFrameBuffer(viewport);
+		fbo->Bind();
+		fbo->ReadPixelsAsync(mouseX, mouseY, 1, 1, [this](const FrameBuffer::Readback& readback) {
+			const uint8_t* rgba = (const uint8_t*)readback.pixels;
+			hoveredColor = glm::vec4(rgba[0], rgba[1], rgba[2], rgba[3]) / 255.0f;
+		});
+		fbo->ReadPixelsAsync(mouseX, mouseY, 1, 1, [this](const FrameBuffer::Readback& readback) {
+			hoveredEntityId = *(const int*)readback.pixels;
+		}, 1);
+		fbo->Unbind();
+	});
+
+	renderGraph.Execute(renderTargets);
+}
+
+void EditorLayer::PickObjects(const SceneBuffer& sceneBuffer, const glm::mat4& viewProjection) {
+	picker.Update(sceneBuffer);
+	hoveredObject = {};
+	marquee.objects.clear();
+	const int width = viewportFbo->GetWidth();
+	const int height = viewportFbo->GetHeight();
+	// Mouse coordinates are pixels from the bottom left of the viewport
+	auto toNdc = [&](int x, int y) { return glm::vec2((x + 0.5f) / width, (y + 0.5f) / height) * 2.0f - 1.0f; };
+
+	if (mouseX >= 0 && mouseY >= 0 && mouseX < width && mouseY < height) {
+		// Ray from the near plane to the far plane through the mouse
+		const glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+		const glm::vec2 ndc = toNdc(mouseX, mouseY);
+		const glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc.x, ndc.y, -1.0f, 1.0f);
+		const glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc.x, ndc.y, 1.0f, 1.0f);
+		const glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+		const uint32_t slot = picker.PickRay(sceneBuffer, origin, glm::vec3(farPoint) / farPoint.w - origin);
+		if (slot != SceneBuffer::invalidSlot) { hoveredObject = scene.GetHandle(sceneBuffer.GetEntity(slot)); }
+	}
+
+	if (!marquee.IsActive(mouseX, mouseY)) { return; }
+	const glm::vec2 corner0 = toNdc(marquee.start.x, marquee.start.y);
+	const glm::vec2 corner1 = toNdc(mouseX, mouseY);
+	std::vector<std::pair<float, uint32_t>> slotsByDistance;
+	const SlotBounds& bounds = sceneBuffer.GetBounds();
+	for (uint32_t slot : picker.PickRect(viewProjection, glm::min(corner0, corner1), glm::max(corner0, corner1))) {
+		const glm::vec3 center = { bounds.boxX[slot], bounds.boxY[slot], bounds.boxZ[slot] };
+		slotsByDistance.emplace_back(glm::distance(center, camera->GetPosition()), slot);
+	}
+	std::sort(slotsByDistance.begin(), slotsByDistance.end());
+	for (const auto& [distance, slot] : slotsByDistance) { marquee.objects.push_back(scene.GetHandle(sceneBuffer.GetEntity(slot))); }
 }
 
 void EditorLayer::OnDetach() {
-	delete viewportFbo;
-	delete selectionFbo;
+	delete occlusionCuller;
+	renderTargets.Clear();
+	MeshAssetRegistry::Shutdown();
 }
 
 void EditorLayer::OnEvent(Event& ev) {
@@ -173,16 +337,62 @@ void EditorLayer::OnImGuiRender() {
 	ImGui::Begin("Stats");
 	if (ImGui::CollapsingHeader("Global Settings", ImGuiTreeNodeFlags_DefaultOpen)) {
 		static bool shouldCullFaces = false;
+		static CullFace cullFace = CullFace::Back;
 		if (ImGui::Checkbox("Face Culling", &shouldCullFaces)) {
 			if (shouldCullFaces) { GraphicsAPI::Get()->Enable(GraphicsAbility::FaceCulling); }
 			else { GraphicsAPI::Get()->Disable(GraphicsAbility::FaceCulling); }
+			Renderer::areBackFacesCulled = shouldCullFaces && cullFace == CullFace::Back;
 		}
 
 		ImGui::ColorEdit3("Ambient Light", glm::value_ptr(scene.ambientColor));
 		ImGui::ColorEdit4("Background Color", glm::value_ptr(scene.backgroundColor));
 
+		int chosenFormat = (int)MeshAsset::defaultFormat;
+		if (ImGui::Combo("Vertex Format", &chosenFormat, vertexFormatNames, IM_ARRAYSIZE(vertexFormatNames))) {
+			MeshAsset::defaultFormat = (VertexFormat)chosenFormat;
+			// re-create meshes in the new format
+			for (const auto& [ent, mesh] : scene.View<MeshComponent>().each()) {
+				mesh.LoadOBJ();
+				scene.GetHandle(ent).patch<MeshComponent>();
+			}
+			for (const auto& [ent, pMesh] : scene.View<ProceduralMeshComponent>().each()) {
+				pMesh.GenerateMesh();
+				scene.GetHandle(ent).patch<ProceduralMeshComponent>();
+			}
+		}
+		ImGui::Checkbox("Mesh LODs", &Renderer::isLodEnabled);
+		ImGui::Checkbox("Meshlet Culling", &Renderer::isMeshletCullingEnabled);
+		ImGui::Text("Meshlets drawn: %d, culled: %d", Renderer::stats.numMeshletsDrawn, Renderer::stats.numMeshletsCulled);
+		ImGui::Text("Entities uploaded: %d", Renderer::stats.numEntitiesUploaded);
+		ImGui::Text("Draw packets: %d, state changes: %d", Renderer::stats.numDrawPackets, Renderer::stats.numStateChanges);
+		ImGui::Checkbox("Instancing", &Renderer::isInstancingEnabled);
+		ImGui::Checkbox("Multi-Draw Indirect", &Renderer::isMultiDrawIndirectEnabled);
+		ImGui::Text("Draw calls: %d, instanced: %d, multi-draws: %d", Renderer::stats.numDrawCalls, Renderer::stats.numInstancedDraws, Renderer::stats.numMultiDraws);
+		ImGui::Text("Indirect draws: %d", Renderer::stats.numIndirectDraws);
+		ImGui::Checkbox("Frustum Culling", &Renderer::isFrustumCullingEnabled);
+		ImGui::Text("Entities culled: %d%s", Renderer::stats.numEntitiesCulled, Renderer::stats.numCullingReuses > 0 ? " (reused)" : "");
+		ImGui::Checkbox("Occlusion Culling", &Renderer::isOcclusionCullingEnabled);
+		ImGui::Text("Occlusion tested: %d, culled: %d, retested: %d", Renderer::stats.numOcclusionTested, Renderer::stats.numOcclusionCulled, Renderer::stats.numOcclusionRetested);
+		ImGui::Text("Lights global: %d, clustered: %d, in clusters: %d", Renderer::stats.numGlobalLights, Renderer::stats.numClusteredLights, Renderer::stats.numLightIndices);
+		ImGui::Text("GL state changes: %d, redundant dropped: %d", GraphicsAPI::stats.numStateChanges, GraphicsAPI::stats.numRedundantStateChanges);
+		ImGui::ColorButton("##HoveredColor", ImVec4(hoveredColor.r, hoveredColor.g, hoveredColor.b, hoveredColor.a));
+		ImGui::SameLine();
+		ImGui::Text("Color under mouse (async readback)");
+		ImGui::Text("Entity under mouse, ID buffer: %d, picking: %d", hoveredEntityId, hoveredObject ? (int)hoveredObject.entity() : -1);
+		ImGui::Checkbox("Validate GL State", &GraphicsAPI::isStateValidationEnabled);
+		ImGui::Text("Render targets: %zu, %.1f MB%s", renderTargets.GetNumTargets(), renderTargets.GetNumBytes() / (1024.0f * 1024.0f), renderTargets.IsResizePending() ? " (resize pending)" : "");
+		for (const RenderGraph::PassTiming& timing : renderGraph.GetTimings()) {
+			if (timing.isCulled) { ImGui::Text("  %s: culled", timing.name.c_str()); }
+			else { ImGui::Text("  %s: CPU %.2f ms, GPU %.2f ms", timing.name.c_str(), timing.cpuMilliseconds, timing.gpuMilliseconds); }
+		}
+		ImGui::Text("Unique meshes: %zu", MeshAssetRegistry::GetNumAssets());
+		const MeshLoadingProgress progress = MeshAssetRegistry::GetLoadingProgress();
+		if (progress.numRequested > 0) {
+			ImGui::Text("Loading meshes: %zu / %zu", progress.numDone, progress.numRequested);
+			ImGui::ProgressBar((float)progress.numDone / progress.numRequested);
+		}
+
 		if (shouldCullFaces) {
-			static CullFace cullFace = CullFace::Back;
 			int chosen_index = (int)cullFace;
 			if (ImGui::BeginCombo("Cull Face", CullFaceNames[chosen_index], ImGuiComboFlags_None)) {
 				for (int ix = 0; ix < IM_ARRAYSIZE(CullFaceNames); ix++) {
@@ -190,6 +400,7 @@ void EditorLayer::OnImGuiRender() {
 					if (ImGui::Selectable(CullFaceNames[ix], is_selected)) {
 						cullFace = (CullFace)ix;
 						GraphicsAPI::Get()->SetCullFace(cullFace);
+						Renderer::areBackFacesCulled = cullFace == CullFace::Back;
 					}
 					// Set the initial focus when opening the combo (scrolling + keyboard navigation focus)
 					if (is_selected) ImGui::SetItemDefaultFocus();
@@ -10,6 +10,14 @@
 #include "Renderer/Shader.h"
 #include "Renderer/UniformBuffer.h"
 #include "Renderer/FrameBuffer.h"
+#include "Renderer/RenderTargetPool.h"
+#include "Renderer/RenderQueue.h"
+#include "Renderer/RenderGraph.h"
+#include "Renderer/FrustumCuller.h"
+#include "Renderer/OcclusionCuller.h"
+#include "Renderer/LightClusters.h"
+#include "Renderer/DeferredShading.h"
+#include "Renderer/ScenePicker.h"
 #include "Renderer/EditorCamera.h"
 #include "Scene/Scene.h"
 
@@ -27,26 +35,42 @@ public:
 	virtual void OnImGuiRender() override;
 
 private:
+	// Finds the hovered object with a ray through the mouse, and the objects inside the marquee while one is dragged
+	void PickObjects(const SceneBuffer& sceneBuffer, const glm::mat4& viewProjection);
+
 	Shader* shader = nullptr;
-	Shader* selectionShader = nullptr;
 	Shader* solidColorShader = nullptr;
 	Shader* outlineShader = nullptr;
+	Shader* depthDownsampleShader = nullptr;
+	Shader* occlusionBoxShader = nullptr;
+	Shader* gBufferShader = nullptr;
+	Shader* deferredLightingShader = nullptr;
 	UniformBuffer* viewUbo = nullptr;
-	UniformBuffer* lightsUbo = nullptr;
-	FrameBuffer* viewportFbo = nullptr;
-	FrameBuffer* selectionFbo = nullptr;
-	int mouseX, mouseY;
+	RenderTargetPool renderTargets;
+	FrameBuffer* viewportFbo = nullptr; // from renderTargets, got again each frame
+	RenderGraph renderGraph;
+	RenderQueue renderQueue;
+	FrustumCuller culler;
+	OcclusionCuller* occlusionCuller = nullptr;
+	LightClusters lightClusters;
+	DeferredShading deferredShading;
+	ShadingPath shadingPath = ShadingPath::Forward; // of the viewport, chosen in viewportPanel
+	DeferredShading::View gBufferView = DeferredShading::View::Lit; // same
+	ScenePicker picker;
+	int mouseX = -1, mouseY = -1;
 	EditorCamera* camera = nullptr;
 
 	Scene scene;
 	EntityHandle selectedObject = {};
 	EntityHandle hoveredObject = {};
-	int hoveredEntityId = -3;
+	Marquee marquee;
+	glm::vec4 hoveredColor = glm::vec4(0.0f); // read back from viewportFbo
+	int hoveredEntityId = -1; // same
 
 	MainMenuBar mainMenuBar{ scene };
 	SceneHierarchyPanel hierarchyPanel{ scene, selectedObject };
 	InspectorPanel inspectorPanel{ scene, selectedObject, hoveredObject };
-	ViewportPanel viewportPanel{ viewportFbo, selectionFbo, hoveredEntityId, camera, selectedObject, hoveredObject, mouseX, mouseY };
+	ViewportPanel viewportPanel{ viewportFbo, renderTargets, camera, selectedObject, hoveredObject, marquee, mouseX, mouseY, shadingPath, gBufferView };
 
 	std::vector<float> frameRates = std::vector<float>(120);
 };
\ No newline at end of file
@@ -77,9 +77,10 @@ void InspectorPanel::OnImGuiRender() {
 			if (info == entt::type_id<TransformComponent>()) {
 				if (ImGui::CollapsingHeader("Transform", ImGuiTreeNodeFlags_DefaultOpen)) {
 					auto& transform = selectedObject.get<TransformComponent>();
-					DrawVec3Control("Translation", transform.translation);
-					DrawVec3Control("Rotation", transform.rotation);
-					DrawVec3Control("Scale", transform.scale, 1.0f);
+					bool isChanged = DrawVec3Control("Translation", transform.translation);
+					isChanged |= DrawVec3Control("Rotation", transform.rotation);
+					isChanged |= DrawVec3Control("Scale", transform.scale, 1.0f);
+					if (isChanged) { selectedObject.patch<TransformComponent>(); } // let the scene buffer know
 				}
 			}
 			else if (info == entt::type_id<MeshComponent>()) {
@@ -92,18 +93,21 @@ void InspectorPanel::OnImGuiRender() {
 					if (ImGui::InputText("OBJ File", buffer, sizeof(buffer), ImGuiInputTextFlags_EnterReturnsTrue)) {
 						mesh.filepath = std::string(buffer);
 						mesh.LoadOBJ();
+						selectedObject.patch<MeshComponent>();
 					}
 				}
 			}
 			else if (info == entt::type_id<MeshRendererComponent>()) {
 				if (ImGui::CollapsingHeader("Mesh Renderer", ImGuiTreeNodeFlags_DefaultOpen)) {
 					auto& meshRenderer = selectedObject.get<MeshRendererComponent>();
+					bool isChanged = false;
 					int chosen_index = (int)meshRenderer.visualization;
 					if (ImGui::BeginCombo("Visualizations", MeshRendererComponent::visNames[chosen_index], ImGuiComboFlags_None)) {
 						for (int ix = 0; ix < IM_ARRAYSIZE(MeshRendererComponent::visNames); ix++) {
 							const bool is_selected = (chosen_index == ix);
 							if (ImGui::Selectable(MeshRendererComponent::visNames[ix], is_selected)) {
 								meshRenderer.visualization = (MeshRendererComponent::Visualization)ix;
+								isChanged = true;
 							}
 							// Set the initial focus when opening the combo (scrolling + keyboard navigation focus)
 							if (is_selected) ImGui::SetItemDefaultFocus();
@@ -112,33 +116,35 @@ void InspectorPanel::OnImGuiRender() {
 					}
 					switch (meshRenderer.visualization) {
 					case MeshRendererComponent::Visualization::Depth:
-						ImGui::SliderFloat("MaxDepth", &meshRenderer.depthParams.max, 0.01f, 100.0f);
-						ImGui::SliderFloat("Pow (Contrast)", &meshRenderer.depthParams.pow, 0.25f, 4.0f);
+						isChanged |= ImGui::SliderFloat("MaxDepth", &meshRenderer.depthParams.max, 0.01f, 100.0f);
+						isChanged |= ImGui::SliderFloat("Pow (Contrast)", &meshRenderer.depthParams.pow, 0.25f, 4.0f);
 						break;
 					case MeshRendererComponent::Visualization::SolidColor:
-						ImGui::ColorEdit4("Solid Color", glm::value_ptr(meshRenderer.solidColor));
+						isChanged |= ImGui::ColorEdit4("Solid Color", glm::value_ptr(meshRenderer.solidColor));
 						break;
 					case MeshRendererComponent::Visualization::Lit:
 						ImGui::Text("Material");
-						ImGui::ColorEdit3("Ambient", glm::value_ptr(meshRenderer.material.ambientColor));
-						ImGui::ColorEdit3("Diffuse", glm::value_ptr(meshRenderer.material.diffuseColor));
-						ImGui::ColorEdit3("Specular", glm::value_ptr(meshRenderer.material.specularColor));
-						ImGui::SliderFloat("Shininess", &meshRenderer.material.shininess, 0.1f, 256.0f);
-						ImGui::SliderFloat("Alpha", &meshRenderer.material.alpha, 0.0f, 1.0f);
+						isChanged |= ImGui::ColorEdit3("Ambient", glm::value_ptr(meshRenderer.material.ambientColor));
+						isChanged |= ImGui::ColorEdit3("Diffuse", glm::value_ptr(meshRenderer.material.diffuseColor));
+						isChanged |= ImGui::ColorEdit3("Specular", glm::value_ptr(meshRenderer.material.specularColor));
+						isChanged |= ImGui::SliderFloat("Shininess", &meshRenderer.material.shininess, 0.1f, 256.0f);
+						isChanged |= ImGui::SliderFloat("Alpha", &meshRenderer.material.alpha, 0.0f, 1.0f);
 						break;
 					}
+					if (isChanged) { selectedObject.patch<MeshRendererComponent>(); }
 				}
 			}
 			else if (info == entt::type_id<ProceduralMeshComponent>()) {
 				if (ImGui::CollapsingHeader("Procedural Mesh", ImGuiTreeNodeFlags_DefaultOpen)) {
 					auto& pMesh = selectedObject.get<ProceduralMeshComponent>();
+					bool isChanged = false;
 					int chosen_index = (int)pMesh.parameters.shape;
 					if (ImGui::BeginCombo("Shapes", ProceduralMeshComponent::shapeNames[chosen_index], ImGuiComboFlags_None)) {
 						for (int ix = 0; ix < IM_ARRAYSIZE(ProceduralMeshComponent::shapeNames); ix++) {
 							const bool is_selected = (chosen_index == ix);
 							if (ImGui::Selectable(ProceduralMeshComponent::shapeNames[ix], is_selected)) {
 								pMesh.parameters.shape = (ProceduralMeshComponent::Shape)ix;
-								pMesh.GenerateMesh();
+								isChanged = true;
 							}
 							// Set the initial focus when opening the combo (scrolling + keyboard navigation focus)
 							if (is_selected) ImGui::SetItemDefaultFocus();
@@ -148,15 +154,19 @@ void InspectorPanel::OnImGuiRender() {
 
 					switch (pMesh.parameters.shape) {
 					case ProceduralMeshComponent::Shape::Box:
-						if (DrawVec3Control("Dimensions", pMesh.parameters.box.dimensions, 1.0f)) { pMesh.GenerateMesh(); }
+						if (DrawVec3Control("Dimensions", pMesh.parameters.box.dimensions, 1.0f)) { isChanged = true; }
 						break;
 					case ProceduralMeshComponent::Shape::Torus:
-						if (ImGui::DragFloat("Outer Radius", &pMesh.parameters.torus.outerRadius)) { pMesh.GenerateMesh(); }
-						if (ImGui::DragInt("Outer Segments", &pMesh.parameters.torus.outerSegments)) { pMesh.GenerateMesh(); }
-						if (ImGui::DragFloat("Inner Radius", &pMesh.parameters.torus.innerRadius)) { pMesh.GenerateMesh(); }
-						if (ImGui::DragInt("Inner Segments", &pMesh.parameters.torus.innerSegments)) { pMesh.GenerateMesh(); }
+						if (ImGui::DragFloat("Outer Radius", &pMesh.parameters.torus.outerRadius)) { isChanged = true; }
+						if (ImGui::DragInt("Outer Segments", &pMesh.parameters.torus.outerSegments)) { isChanged = true; }
+						if (ImGui::DragFloat("Inner Radius", &pMesh.parameters.torus.innerRadius)) { isChanged = true; }
+						if (ImGui::DragInt("Inner Segments", &pMesh.parameters.torus.innerSegments)) { isChanged = true; }
 						break;
 					}
+					if (isChanged) {
+						pMesh.GenerateMesh();
+						selectedObject.patch<ProceduralMeshComponent>();
+					}
 				}
 			}
 			else if (info == entt::type_id<LightComponent>()) {
@@ -186,7 +196,7 @@ void InspectorPanel::OnImGuiRender() {
 					}
 				}
 			}
-			else if (info != entt::type_id<TagComponent>()) { // default
+			else if (info != entt::type_id<TagComponent>() && info != entt::type_id<WorldTransformComponent>()) { // default
 				ImGui::Text("Component '%s' has no UI yet", info.name().data());
 			}
 		});
@@ -4,9 +4,10 @@
 #include "Core/Input.h"
 #include "Scene/Components.h"
 
-#include <glad/glad.h> // include until Framebuffer and Texture abstractions are completed
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+
 void ViewportPanel::OnImGuiRender() {
 	static ImVec2 viewportPanelAvailRegionPrev;
 	ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0, 0));
@@ -14,14 +15,26 @@ void ViewportPanel::OnImGuiRender() {
 	ImVec2 viewportPanelAvailRegion = ImGui::GetContentRegionAvail();
 	bool isViewportPanelResized = viewportPanelAvailRegion.x != viewportPanelAvailRegionPrev.x || viewportPanelAvailRegion.y != viewportPanelAvailRegionPrev.y;
 	if (isViewportPanelResized) {
-		viewportFbo->Resize((int)viewportPanelAvailRegion.x, (int)viewportPanelAvailRegion.y);
-		selectionFbo->Resize((int)viewportPanelAvailRegion.x, (int)viewportPanelAvailRegion.y);
-		glViewport(0, 0, (int)viewportPanelAvailRegion.x, (int)viewportPanelAvailRegion.y);
+		// Render targets follow once the size stops changing, and are stretched over the panel meanwhile. The camera follows right away
+		// so that the stretched image has the right proportions.
+		renderTargets.SetViewportSize((int)viewportPanelAvailRegion.x, (int)viewportPanelAvailRegion.y);
 		camera->SetViewportSize(viewportPanelAvailRegion.x, viewportPanelAvailRegion.y);
 	}
 	ImGui::Image((void*)(intptr_t)viewportFbo->GetColorAttachmentRendererID(0), ImVec2(viewportPanelAvailRegion.x, viewportPanelAvailRegion.y), ImVec2{ 0, 1 }, ImVec2{ 1, 0 });
 	aspect = viewportPanelAvailRegion.x / viewportPanelAvailRegion.y;
-	isViewportPanelHovered = ImGui::IsWindowHovered();
+
+	ImGui::SetCursorPos(ImVec2(8.0f, 8.0f));
+	ImGui::SetNextItemWidth(100.0f);
+	int chosenPath = (int)shadingPath;
+	if (ImGui::Combo("##ShadingPath", &chosenPath, shadingPathNames, IM_ARRAYSIZE(shadingPathNames))) { shadingPath = (ShadingPath)chosenPath; }
+	if (shadingPath == ShadingPath::Deferred) {
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(100.0f);
+		int chosenView = (int)gBufferView;
+		if (ImGui::Combo("##GBufferView", &chosenView, DeferredShading::viewNames, IM_ARRAYSIZE(DeferredShading::viewNames))) { gBufferView = (DeferredShading::View)chosenView; }
+	}
+	// Clicks on the combos are not clicks on the scene
+	isViewportPanelHovered = ImGui::IsWindowHovered() && !ImGui::IsAnyItemHovered();
 
 	if (selectedObject && gizmoShouldShow) {
 		ImGuizmo::SetOrthographic(false);
@@ -29,7 +42,8 @@ void ViewportPanel::OnImGuiRender() {
 		ImGuizmo::SetRect(ImGui::GetWindowPos().x, ImGui::GetWindowPos().y, viewportPanelAvailRegion.x, viewportPanelAvailRegion.y);
 
 		auto& tc = selectedObject.get<TransformComponent>();
-		auto transformMatrix = Math::ComposeTransform(tc.translation, tc.rotation, tc.scale);
+		const auto* world = selectedObject.try_get<WorldTransformComponent>();
+		glm::mat4 transformMatrix = world != nullptr ? world->world : Math::ComposeTransform(tc.translation, tc.rotation, tc.scale);
 
 		// Snapping
 		const bool shouldSnap = Input::Get()->IsKeyPressed(340);
@@ -50,16 +64,23 @@ void ViewportPanel::OnImGuiRender() {
 			glm::vec3 deltaRotation = rotation - tc.rotation;
 			tc.rotation += deltaRotation;
 			tc.scale = scale;
+			selectedObject.patch<TransformComponent>();
 		}
 	}
 	viewportPanelAvailRegionPrev = viewportPanelAvailRegion;
 
-	// Mouse coordinates wrt bottom left of viewport panel.
+	// Mouse coordinates wrt bottom left of viewport panel, in texels of viewportFbo, which differ from pixels while a resize is pending
 	ImVec2 mouseScreenPos = ImGui::GetMousePos();
 	ImVec2 viewportPanelScreenPos = ImGui::GetWindowPos();
-	mouseX = (int)(mouseScreenPos.x - viewportPanelScreenPos.x);
-	mouseY = (int)(mouseScreenPos.y - viewportPanelScreenPos.y);
-	mouseY = ImGui::GetWindowSize().y - mouseY;
+	const glm::vec2 texelsPerPixel = { viewportFbo->GetWidth() / std::max(viewportPanelAvailRegion.x, 1.0f), viewportFbo->GetHeight() / std::max(viewportPanelAvailRegion.y, 1.0f) };
+	mouseX = (int)((mouseScreenPos.x - viewportPanelScreenPos.x) * texelsPerPixel.x);
+	mouseY = (int)((ImGui::GetWindowSize().y - (mouseScreenPos.y - viewportPanelScreenPos.y)) * texelsPerPixel.y);
+
+	if (marquee.IsActive(mouseX, mouseY)) {
+		const ImVec2 start = { viewportPanelScreenPos.x + marquee.start.x / texelsPerPixel.x, viewportPanelScreenPos.y + ImGui::GetWindowSize().y - marquee.start.y / texelsPerPixel.y };
+		ImGui::GetWindowDrawList()->AddRectFilled(start, mouseScreenPos, IM_COL32(255, 255, 0, 40));
+		ImGui::GetWindowDrawList()->AddRect(start, mouseScreenPos, IM_COL32(255, 255, 0, 200));
+	}
 
 	ImGui::End();
 	ImGui::PopStyleVar();
@@ -98,7 +119,9 @@ void ViewportPanel::OnMouseClicked(MouseButtonPressedEvent& ev) {
 		&& !Input::Get()->IsKeyPressed(342) // don't unselect when ALT is pressed (i.e. when manipulating EditorCamera)
 		&& ((MouseButton)ev.GetMouseButton() == MouseButton::Left) // select with left click
 	) { 
-		selectedObject = hoveredObject; // (just unselects if hovering over nothing)
+		// Selects on release, a click what is under the mouse and a drag what is inside the marquee
+		marquee.isDragging = true;
+		marquee.start = { mouseX, mouseY };
 	}
 	if (isViewportPanelHovered && Input::Get()->IsKeyPressed(342)) {
 		isManipulatingEditorCamera = true;
@@ -107,6 +130,12 @@ void ViewportPanel::OnMouseClicked(MouseButtonPressedEvent& ev) {
 
 void ViewportPanel::OnMouseReleased(MouseButtonReleasedEvent& ev) {
 	isManipulatingEditorCamera = false;
+	if (marquee.isDragging && (MouseButton)ev.GetMouseButton() == MouseButton::Left) {
+		// The nearest object inside the marquee, since one object is selected at a time (just unselects if there is nothing)
+		if (marquee.IsActive(mouseX, mouseY)) { selectedObject = marquee.objects.empty() ? EntityHandle{} : marquee.objects.front(); }
+		else { selectedObject = hoveredObject; }
+		marquee.isDragging = false;
+	}
 }
 
 void ViewportPanel::OnKeyPressed(KeyPressedEvent& ev) {
@@ -3,19 +3,36 @@
 #include "Events/Event.h"
 #include "Events/KeyEvent.h"
 #include "Events/MouseEvent.h"
+#include "Renderer/DeferredShading.h"
 #include "Renderer/FrameBuffer.h"
+#include "Renderer/RenderTargetPool.h"
 #include "Renderer/EditorCamera.h"
 #include "Scene/Scene.h"
 
 #include <imgui.h>
 #include <ImGuizmo.h>
+#include <glm/glm.hpp>
 
-// Displays content of viewportFBO and transform gizmos
+#include <cstdlib>
+#include <vector>
+
+// Rectangle dragged over the viewport with the left mouse button, from start to the mouse, in the coordinates of the mouse
+struct Marquee {
+	bool isDragging = false;
+	glm::ivec2 start = { 0, 0 };
+	std::vector<EntityHandle> objects; // inside the rectangle while it is active, nearest first
+
+	// Drags shorter than a few pixels are clicks
+	bool IsActive(int mouseX, int mouseY) const { return isDragging && (std::abs(mouseX - start.x) > 3 || std::abs(mouseY - start.y) > 3); }
+};
+
+// Displays content of viewportFBO and transform gizmos. Resizing the panel resizes the viewport of renderTargets.
+// Shading path of the viewport, and the view of the G-buffer when deferred, are chosen at its top left.
 class ViewportPanel {
 public:
 	ViewportPanel() = default;
-	ViewportPanel(FrameBuffer*& viewportFbo, FrameBuffer*& selectionFbo, int& hoveredEntityId, EditorCamera*& camera, EntityHandle& selectedObject, EntityHandle& hoveredObject, int& mouseX, int& mouseY)
-		: viewportFbo(viewportFbo), selectionFbo(selectionFbo), hoveredEntityId(hoveredEntityId), camera(camera), selectedObject(selectedObject), hoveredObject(hoveredObject), mouseX(mouseX), mouseY(mouseY) {}
+	ViewportPanel(FrameBuffer*& viewportFbo, RenderTargetPool& renderTargets, EditorCamera*& camera, EntityHandle& selectedObject, EntityHandle& hoveredObject, Marquee& marquee, int& mouseX, int& mouseY, ShadingPath& shadingPath, DeferredShading::View& gBufferView)
+		: viewportFbo(viewportFbo), renderTargets(renderTargets), camera(camera), selectedObject(selectedObject), hoveredObject(hoveredObject), marquee(marquee), mouseX(mouseX), mouseY(mouseY), shadingPath(shadingPath), gBufferView(gBufferView) {}
 
 	void OnImGuiRender();
 	void OnEvent(Event& ev);
@@ -28,13 +45,15 @@ public:
 private:
 	// references to EditorLayer's members
 	FrameBuffer*& viewportFbo;
-	FrameBuffer*& selectionFbo;
+	RenderTargetPool& renderTargets;
 	int& mouseX;
 	int& mouseY;
-	int& hoveredEntityId;
 	EditorCamera*& camera;
 	EntityHandle& selectedObject;
 	EntityHandle& hoveredObject;
+	Marquee& marquee;
+	ShadingPath& shadingPath;
+	DeferredShading::View& gBufferView;
 
 	bool isViewportPanelHovered = false;
 	bool isManipulatingEditorCamera = false;
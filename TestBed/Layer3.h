@@ -7,6 +7,7 @@
 #include "Renderer/Shader.h"
 #include "Renderer/VertexArray.h"
 #include "Renderer/VertexBuffer.h"
+#include "Renderer/IndexBuffer.h"
 #include "Renderer/GraphicsAPI.h"
 #include "Modeling/Modeling.h"
 #include "Core/ImGuiHelper.h"
@@ -30,13 +31,18 @@ public:
             shader->GetAttribLocation("a_TexCoord"), shader->GetAttribLocation("a_Color"));
 
         for (auto& objectFileName : objectFileNames) {
-            std::vector<BasicVertex> vertices = LoadOBJ(std::string("assets/models/") + objectFileName + ".obj");
-            Log::Info("{} num vertices: {}", objectFileName, vertices.size());
+            MeshData mesh = LoadOBJ(std::string("assets/models/") + objectFileName + ".obj");
+            Log::Info("{} num vertices: {}, num indices: {}", objectFileName, mesh.vertices.size(), mesh.indices.size());
             VertexBuffer* vb = VertexBuffer::Create(BasicVertexAttributeSpecs);
-            vb->SetVertices(vertices);
+            vb->SetVertices(mesh.vertices);
+            // Coarser LODs follow LOD 0 in indices, only the full mesh is drawn here
+            if (!mesh.lods.empty()) { mesh.indices.resize(mesh.lods[0].indexCount); }
+            IndexBuffer* ib = IndexBuffer::Create();
+            ib->UploadCompactIndices(mesh.indices);
 
             VertexArray* va = VertexArray::Create();
             va->AddVertexBuffer(*vb);
+            va->SetIndexBuffer(*ib);
 
             vertexArrays.push_back(va);
         }
@@ -78,7 +84,7 @@ public:
         shader->UploadUniformFloat3("u_HemisphereLightPosition", hemisphereLightPosition);
         shader->UploadUniformFloat3("u_SkyColor", skyColor);
         shader->UploadUniformFloat3("u_GroundColor", groundColor);
-        GraphicsAPI::Get()->DrawArrayTriangles(*vertexArrays[selectedVaIndex]);
+        GraphicsAPI::Get()->DrawIndexedTriangles(*vertexArrays[selectedVaIndex]);
     }
 
     virtual void OnDetach() override {
@@ -1,9 +1,9 @@
 #include "Mesh.h"
 
 #include "Core/Log.h"
+#include "Modeling/ObjParser.h"
 
 #include <vulkan/vulkan.h>
-#include <tiny_obj_loader.h>
 
 VertexInputDescription Vertex::GetVertexDescription() {
 	VertexInputDescription description;
@@ -61,80 +61,31 @@ bool Mesh::LoadFromOBJ(const char* filename) {
 	Log::Debug("Loading OBJ file: {}...", filename);
 	vertices.clear();
 
-	//attrib will contain the vertex arrays of the file
-	tinyobj::attrib_t attrib;
-	//shapes contains the info for each separate object in the file
-	std::vector<tinyobj::shape_t> shapes;
-	//materials contains the information about the material of each shape, but we won't use it.
-	std::vector<tinyobj::material_t> materials;
-
-	//error and warning output from the load function
-	std::string warn;
-	std::string err;
-
-	//load the OBJ file
-	tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename, nullptr);
-	//make sure to output the warnings to the console, in case there are issues with the file
-	if (!warn.empty()) {
-		Log::Warning("{}", warn);
-	}
-	//if we have any error, print it to the console, and break the mesh loading.
-	//This happens if the file can't be found or is malformed
-	if (!err.empty()) {
-		Log::Error("{}", err);
+	ObjData obj;
+	if (!ParseOBJ(filename, obj)) {
 		return false;
 	}
 
-	// Loop over shapes
-	for (size_t s = 0; s < shapes.size(); s++) {
-		// Loop over faces(polygon)
-		size_t index_offset = 0;
-		Log::Debug("\tShape[{}] has {} faces.", s, shapes[s].mesh.num_face_vertices.size());
-		for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
-			//hardcode loading to triangles
-			int fv = 3;
-
-			// Loop over vertices in the face.
-			for (size_t v = 0; v < fv; v++) {
-				// access to vertex
-				tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-
-				Vertex new_vert;
-
-				//vertex position
-				tinyobj::real_t vx = attrib.vertices[3 * idx.vertex_index + 0];
-				tinyobj::real_t vy = attrib.vertices[3 * idx.vertex_index + 1];
-				tinyobj::real_t vz = attrib.vertices[3 * idx.vertex_index + 2];
-				new_vert.position = { vx, vy, vz };
-
-				//vertex normal
-				if (idx.normal_index >= 0) {
-					tinyobj::real_t nx = attrib.normals[3 * idx.normal_index + 0];
-					tinyobj::real_t ny = attrib.normals[3 * idx.normal_index + 1];
-					tinyobj::real_t nz = attrib.normals[3 * idx.normal_index + 2];
-					new_vert.normal = { nx, ny, nz };
-				}
-
-				// Check if `texcoord_index` is zero or positive. negative = no texcoord data
-				if (idx.texcoord_index >= 0) {
-					tinyobj::real_t tx = attrib.texcoords[2 * size_t(idx.texcoord_index) + 0];
-					tinyobj::real_t ty = attrib.texcoords[2 * size_t(idx.texcoord_index) + 1];
-					new_vert.texCoord = { tx, 1.0 - ty }; // Vulkan's way for y-coordinates
-				}
-
-				// OBJ format does not have color information in it (it relies on accompanying MTL files to assign diffuse and specular colors to faces)
-				// However, some software extends OBJ format by adding 3 more floats per vertex (next to position).
-				// I tested that if color info is not there, vertex color becomes white.
-				{
-					tinyobj::real_t red = attrib.colors[3 * size_t(idx.vertex_index) + 0];
-					tinyobj::real_t green = attrib.colors[3 * size_t(idx.vertex_index) + 1];
-					tinyobj::real_t blue = attrib.colors[3 * size_t(idx.vertex_index) + 2];
-					new_vert.color = { red, green, blue, 1.0f };
-				}
-
-				vertices.push_back(new_vert);
-			}
-			index_offset += fv;
+	vertices.resize(obj.corners.size());
+	for (size_t ix = 0; ix < obj.corners.size(); ix++) {
+		const ObjCorner& corner = obj.corners[ix];
+		Vertex& new_vert = vertices[ix];
+
+		new_vert.position = obj.positions[corner.position];
+
+		// negative index = no normal/texcoord data
+		if (corner.normal >= 0) {
+			new_vert.normal = obj.normals[corner.normal];
+		}
+		if (corner.texCoord >= 0) {
+			const glm::vec2& texCoord = obj.texCoords[corner.texCoord];
+			new_vert.texCoord = { texCoord.x, 1.0f - texCoord.y }; // Vulkan's way for y-coordinates
+		}
+
+		// OBJ format does not have color information in it (it relies on accompanying MTL files to assign diffuse and specular colors to faces)
+		// However, some software extends OBJ format by adding 3 more floats per vertex (next to position). If they are not there, vertex color stays white.
+		if (!obj.colors.empty()) {
+			new_vert.color = glm::vec4(obj.colors[corner.position], 1.0f);
 		}
 	}
 